@@ -110,16 +110,16 @@ catstandPhysics->initPosition();
 	Model* mouseModel = ModelLoader::loadModel("res/models/rat_tri.obj");
 	Model* catModel = ModelLoader::loadModel("res/models/cat_tri.obj");
 	Model* CatAttackModel = ModelLoader::loadModel("res/models/crescent.obj");
-	//Map Models
-    Model* floorModel = ModelGen::makeQuad(ModelGen::Axis::Y, 100, 75);
-    Model* counter1Model = ModelGen::makeCube(10, 5, 40);
-    Model* counter2Model = ModelGen::makeCube(50, 5, 10);
-    Model* islandModel = ModelGen::makeCube(35, 5, 20);
-    Model* tableModel = ModelGen::makeCube(20, 5, 35);
-    Model* couchModel = ModelGen::makeCube(40, 5, 15);
-    Model* catstandModel = ModelGen::makeCube(15, 5, 15);
-    Model* horizWallModel = ModelGen::makeCube(110, 10, 5);
-    Model* vertWallModel = ModelGen::makeCube(5, 10, 85);
+	//Map Models (shared, so reloading the scene doesn't upload them again)
+    Model* floorModel = ModelGen::getQuad(ModelGen::Axis::Y, 100, 75);
+    Model* counter1Model = ModelGen::getCube(10, 5, 40);
+    Model* counter2Model = ModelGen::getCube(50, 5, 10);
+    Model* islandModel = ModelGen::getCube(35, 5, 20);
+    Model* tableModel = ModelGen::getCube(20, 5, 35);
+    Model* couchModel = ModelGen::getCube(40, 5, 15);
+    Model* catstandModel = ModelGen::getCube(15, 5, 15);
+    Model* horizWallModel = ModelGen::getCube(110, 10, 5);
+    Model* vertWallModel = ModelGen::getCube(5, 10, 85);
     //Obstacle Models
     /*Model* ball = ModelLoader::loadModel("res/models/test/teapot.obj"); // ball temp
     Model* cylinder = ModelLoader::loadModel("res/models/test/Cylinder.obj"); // vase / lamp temp
@@ -22,7 +22,7 @@ ContraptionFactory::ContraptionFactory()
 	_bombModel = ModelLoader::loadModel("res/models/battery.obj");
 	_overchargeModel = ModelLoader::loadModel("res/models/battery.obj");
 	_swordsModel = ModelLoader::loadModel("res/models/screw.obj");
-	_coilFieldModel = ModelGen::makeCube(16, 0.1, 16);
+	_coilFieldModel = ModelGen::getCube(16, 0.1, 16);
 	_explosionModel = ModelLoader::loadModel("res/models/sphere.obj");
 
 	_explosionAnim = new Animation();
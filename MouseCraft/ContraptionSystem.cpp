@@ -6,6 +6,10 @@
 
 ContraptionSystem::ContraptionSystem()
 {
+	// contraptions are gameplay code, they reparent and enable entities
+	RunOnMainThread(true);
+	Writes<Contraption>();
+	Writes<GameplayCode>();
 }
 
 
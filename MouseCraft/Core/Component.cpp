@@ -3,21 +3,80 @@
 #include "../Event/EventManager.h"
 #include "ComponentManager.h"
 #include "Entity.h"
+#include "ComponentPool.h"
+#include <mutex>
+#include <vector>
+#include <cassert>
 
-unsigned int Component::_curID = 0;
+std::atomic<unsigned int> Component::_curID(0);
 
-Component::Component() : _id(Component::_curID++)
+// IDs of destroyed components, handed out again before new ones
+static std::mutex freeIDsMtx;
+static std::vector<unsigned int> freeIDs;
+
+unsigned int ComponentTypeID::next()
+{
+	static std::atomic<unsigned int> counter(0);
+	return counter++;
+}
+
+void* Component::operator new(size_t size)
+{
+	ComponentPool* pool = ComponentPool::OfSize(size);
+	return pool ? pool->Allocate() : ComponentPool::AllocateUnpooled(size);
+}
+
+void* Component::operator new(size_t size, ComponentPool& pool)
+{
+	assert(size <= pool.GetSize() && "Component is bigger than its pool");
+	return pool.Allocate();
+}
+
+void Component::operator delete(void* ptr)
+{
+	ComponentPool::Release(ptr);
+}
+
+void Component::operator delete(void* ptr, ComponentPool& /*pool*/)
+{
+	ComponentPool::Release(ptr);
+}
+
+unsigned int Component::acquireID()
+{
+	{
+		std::unique_lock<std::mutex> lock(freeIDsMtx);
+		if (!freeIDs.empty())
+		{
+			unsigned int id = freeIDs.back();
+			freeIDs.pop_back();
+			return id;
+		}
+	}
+	return _curID++;
+}
+
+void Component::releaseID(unsigned int id)
+{
+	std::unique_lock<std::mutex> lock(freeIDsMtx);
+	freeIDs.push_back(id);
+}
+
+Component::Component() : _id(acquireID())
 {
 	// std::cout << "Component created" << std::endl;
 	//TypeParam<Component*> param(this);
-	//EventManager::Notify(COMPONENT_ADDED, &param, false);
+	//EventManager::Notify(COMPONENT_ADDED, &param);
 }
 
 Component::~Component()
 {
 	// std::cout << "Component destroyed" << std::endl;
 	TypeParam<Component*> param(this);
-	EventManager::Notify(COMPONENT_REMOVED, &param, false);
+	EventManager::Notify(COMPONENT_REMOVED, &param);
+
+	// every manager forgot it, the ID can go to the next component
+	releaseID(_id);
 }
 
 // Note: Looks kind of strange but this is to prevent components
@@ -36,6 +95,22 @@ void Component::Initialize()
 	OnInitialized();
 }
 
+void Component::SetEnabled(bool enabled)
+{
+	if (_enabled == enabled)
+		return;
+	_enabled = enabled;
+	onStatusChanged();
+}
+
+void Component::SetEntity(Entity* e)
+{
+	if (_entity == e)
+		return;
+	_entity = e;
+	onStatusChanged();
+}
+
 bool Component::GetActive() const
 {
 	return GetEnabled() && GetEntity() && GetEntity()->GetActive();
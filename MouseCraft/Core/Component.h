@@ -2,8 +2,27 @@
 
 #include <typeindex>
 #include <typeinfo>
+#include <cstddef>
+#include <atomic>
 
 class Entity;
+class ComponentPool;
+
+// Compile-time type IDs for components. IDs are small and dense (assigned on first use),
+// so they can index arrays.
+class ComponentTypeID
+{
+public:
+	template<class T>
+	static unsigned int Get()
+	{
+		static const unsigned int id = next();
+		return id;
+	}
+
+private:
+	static unsigned int next();
+};
 
 class Component
 {
@@ -13,6 +32,13 @@ public:
 	virtual Component& operator=(const Component&) = delete;  // Disallow copying
 	Component(const Component&) = delete;
 
+	// Components are allocated from ComponentPool so instances of a type stay packed together.
+	// ComponentManager::Create passes the pool of the type, a plain new shares one by size.
+	static void* operator new(size_t size);
+	static void* operator new(size_t size, ComponentPool& pool);
+	static void operator delete(void* ptr);
+	static void operator delete(void* ptr, ComponentPool& pool);
+
 	// WARNING: Should only be called internally by the engine. 
 	// Initializes this component.
 	void Initialize();
@@ -25,7 +51,7 @@ public:
 	virtual void OnInitialized() {};
 
 	// Sets the enable status of this component.
-	void SetEnabled(bool enabled) { _enabled = enabled; }
+	void SetEnabled(bool enabled);
 
 	// Returns if this component is enabled 
 	bool GetEnabled() const { return _enabled; }
@@ -34,18 +60,26 @@ public:
 	Entity* GetEntity() const { return _entity; }
 
 	// Sets the entity this component belongs to.
-	void SetEntity(Entity* e) { _entity = e; }	
+	void SetEntity(Entity* e);
 
-	// Returns the ID of this component. Guaranteed to be unique from all components.
+	// Returns the ID of this component. Guaranteed to be unique from all live components,
+	// IDs of destroyed components are reused so they stay small and dense.
 	unsigned int GetID() const { return _id; }
 
 	// Returns true if this component is active (must be enabled, must have entity, entity must be active).
 	bool GetActive() const;
 
+protected:
+	// Called when the enable status or entity of this component changes.
+	virtual void onStatusChanged() {}
+
 private:
 	bool _initialized = false;
 	bool _enabled = true;
-	Entity* _entity;
-	static unsigned int _curID;
+	Entity* _entity = nullptr;
+	static std::atomic<unsigned int> _curID;
 	unsigned int _id;
+
+	static unsigned int acquireID();
+	static void releaseID(unsigned int id);
 };
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <vector>
 #include <memory>
 #include "Component.h"
+#include "ComponentPool.h"
 #include "../Event/ISubscriber.h"
 #include "../Event/EventManager.h"
 
@@ -21,17 +22,40 @@ public:
 	ComponentType* Create(Args... args)
 	{
 		static_assert(std::is_base_of<T, ComponentType>::value, "???");
-		auto* t = new ComponentType(args...);
-		_components.push_back(t);
+		auto* t = new (ComponentPool::Of<ComponentType>()) ComponentType(args...);	// packed with the others of its type
+		Add(t);
 		return t;
 	}
 
-	void Add(T* component) { _components.push_back(component); }
+	void Add(T* component) 
+	{ 
+		unsigned int& slot = sparseSlot(component->GetID());
+		if (slot != 0)
+			return;
+		_components.push_back(component);
+		slot = (unsigned int)_components.size();
+	}
+
+	// O(1), the last component takes the removed one's place.
 	void Remove(unsigned int id)
 	{
-		auto t = std::find_if(_components.begin(), _components.end(), [&id](const Component* c) { return c->GetID() == id; });
-		if(t != _components.end())
-			_components.erase(t);
+		const unsigned int page = id / PAGE_SIZE;
+		if (page >= _sparse.size() || !_sparse[page])
+			return;
+
+		unsigned int& slot = _sparse[page][id % PAGE_SIZE];
+		if (slot == 0)
+			return;
+
+		const unsigned int index = slot - 1;
+		slot = 0;
+		if (index != _components.size() - 1)
+		{
+			T* last = _components.back();
+			_components[index] = last;
+			sparseSlot(last->GetID()) = index + 1;
+		}
+		_components.pop_back();
 	}
 
 	// Inherited via ISubscriber
@@ -63,6 +87,7 @@ public:
 		}
 	}
 
+	// Returns all components in this manager, packed (order is not preserved on removal).
 	const std::vector<T*>& All()
 	{
 		return _components;
@@ -72,7 +97,20 @@ public:
 	ComponentManager& operator= (const ComponentManager) = delete;
 
 private:
+	static const unsigned int PAGE_SIZE = 4096;
+
 	std::vector<T*> _components;
+	std::vector<std::unique_ptr<unsigned int[]>> _sparse;	// component ID -> index in _components + 1, paged (IDs are reused, so it's only as big as the most components alive)
+
+	unsigned int& sparseSlot(unsigned int id)
+	{
+		const unsigned int page = id / PAGE_SIZE;
+		if (page >= _sparse.size())
+			_sparse.resize(page + 1);
+		if (!_sparse[page])
+			_sparse[page].reset(new unsigned int[PAGE_SIZE]());
+		return _sparse[page][id % PAGE_SIZE];
+	}
 
 protected:
 	ComponentManager()
@@ -0,0 +1,83 @@
+#include "ComponentPool.h"
+#include <new>
+
+static_assert(sizeof(void*) <= ComponentPool::GRANULARITY, "The slot header doesn't fit.");
+
+ComponentPool::ComponentPool(size_t size) :
+	_size(size),
+	_slotSize((size + GRANULARITY - 1) / GRANULARITY * GRANULARITY + GRANULARITY)
+{
+}
+
+ComponentPool* ComponentPool::OfSize(size_t size)
+{
+	if (size > MAX_SHARED_SIZE)
+		return nullptr;
+
+	// never destroyed, components can outlive static destruction
+	static ComponentPool** classes = []()
+	{
+		ComponentPool** c = new ComponentPool*[MAX_SHARED_SIZE / GRANULARITY];
+		for (size_t i = 0; i < MAX_SHARED_SIZE / GRANULARITY; ++i)
+			c[i] = new ComponentPool((i + 1) * GRANULARITY);
+		return c;
+	}();
+	const size_t index = (size == 0) ? 0 : (size - 1) / GRANULARITY;
+	return classes[index];
+}
+
+void* ComponentPool::Allocate()
+{
+	std::unique_lock<std::mutex> lock(_mtx);
+
+	if (_freeList == nullptr)
+	{
+		// grab a new slab and thread its slots in address order,
+		// so consecutive allocations are contiguous
+		char* slab = static_cast<char*>(::operator new(_slotSize * SLOTS_PER_SLAB));
+		_slabs.push_back(slab);
+
+		for (size_t i = SLOTS_PER_SLAB; i-- > 0; )
+		{
+			FreeSlot* slot = reinterpret_cast<FreeSlot*>(slab + i * _slotSize);
+			slot->next = _freeList;
+			_freeList = slot;
+		}
+	}
+
+	char* slot = reinterpret_cast<char*>(_freeList);
+	_freeList = _freeList->next;
+	reinterpret_cast<Header*>(slot)->pool = this;
+	return slot + GRANULARITY;
+}
+
+void* ComponentPool::AllocateUnpooled(size_t size)
+{
+	char* block = static_cast<char*>(::operator new(size + GRANULARITY));
+	reinterpret_cast<Header*>(block)->pool = nullptr;
+	return block + GRANULARITY;
+}
+
+void ComponentPool::Release(void* ptr)
+{
+	if (ptr == nullptr)
+		return;
+
+	char* slot = static_cast<char*>(ptr) - GRANULARITY;
+	ComponentPool* pool = reinterpret_cast<Header*>(slot)->pool;
+	if (pool == nullptr)
+	{
+		::operator delete(slot);
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(pool->_mtx);
+	FreeSlot* free = reinterpret_cast<FreeSlot*>(slot);
+	free->next = pool->_freeList;
+	pool->_freeList = free;
+}
+
+size_t ComponentPool::GetSize() const
+{
+	return _size;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+// Slab allocator backing Component::operator new/delete, one pool per component type.
+// ComponentManager::Create allocates from the pool of the type it creates, so instances
+// of a type are packed next to each other. A plain new only knows the size, it takes
+// a pool shared by every type of that size class.
+// Every slot starts with a header naming its pool, so delete finds the right one.
+// Note: Slabs are kept until the program exits, freed slots are reused.
+class ComponentPool
+{
+public:
+	// Slot sizes are multiples of this (also the alignment of every component and the header size).
+	static const size_t GRANULARITY = 16;
+
+	// Plain new of anything bigger goes to the global heap.
+	static const size_t MAX_SHARED_SIZE = 1024;
+
+	// Slots allocated at once per pool.
+	static const size_t SLOTS_PER_SLAB = 64;
+
+	// The pool of components of type T.
+	template<typename T>
+	static ComponentPool& Of()
+	{
+		// never destroyed, components can outlive static destruction
+		static ComponentPool* pool = new ComponentPool(sizeof(T));
+		return *pool;
+	}
+
+	// The pool shared by types of this size class, nullptr if they're too big to share one.
+	static ComponentPool* OfSize(size_t size);
+
+	// Memory for one component, at most the size the pool was made for.
+	void* Allocate();
+
+	// Memory for a component that isn't pooled.
+	static void* AllocateUnpooled(size_t size);
+
+	// Returns memory from Allocate or AllocateUnpooled to where it came from.
+	static void Release(void* ptr);
+
+	// Largest component the pool can hold.
+	size_t GetSize() const;
+
+private:
+	struct FreeSlot
+	{
+		FreeSlot* next;
+	};
+
+	struct Header
+	{
+		ComponentPool* pool;	// nullptr if unpooled
+	};
+
+	explicit ComponentPool(size_t size);
+
+	std::mutex _mtx;
+	FreeSlot* _freeList = nullptr;
+	std::vector<char*> _slabs;
+	size_t _size;
+	size_t _slotSize;	// header included
+};
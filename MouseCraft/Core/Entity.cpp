@@ -1,25 +1,34 @@
 #include "Entity.h"
 #include "OmegaEngine.h"
 #include "../Event/EventManager.h"
+#include "EntityManager.h"
 #include <iostream>
 
 unsigned int Entity::_curID = 0;
 
 Entity::Entity() :_id(++Entity::_curID) 
 { 
-	EventManager::Notify(EventName::ENTITY_CREATED, new TypeParam<Entity*>(this));
+	EventManager::Notify(EventName::ENTITY_CREATED, this);
 }
 
 Entity::Entity(unsigned int id) : _id(id)
 {
-	std::cout << "Entity created with custom ID: " << _id << std::endl;
-	if (_id != 0) EventManager::Notify(EventName::ENTITY_CREATED, new TypeParam<Entity*>(this));
+	if (_id != 0) EventManager::Notify(EventName::ENTITY_CREATED, this);
 }
 
 Entity::~Entity()
 {
-	std::cout << "Entity: " << _id << " destroyed" << std::endl;
-	if (_id != 0) EventManager::Notify(EventName::ENTITY_DESTROYED, new TypeParam<Entity*>(this));
+	if (_id != 0) EventManager::Notify(EventName::ENTITY_DESTROYED, this);
+}
+
+void* Entity::operator new(size_t size)
+{
+	return EntityManager::Allocate(size);
+}
+
+void Entity::operator delete(void* ptr, size_t size)
+{
+	EntityManager::Release(ptr, size);
 }
 
 unsigned int Entity::GetID() const
@@ -49,7 +58,18 @@ void Entity::Initialize()
 
 bool Entity::GetActive() const
 {
-	return (_enabled && isInActiveScene() && getParentEnabled());
+	return _active;
+}
+
+void Entity::RefreshActive()
+{
+	// children share the parent's scene, so only the top needs the scene check
+	bool active = _enabled && ((_parent) ? _parent->_active : isInActiveScene());
+	if (active == _active) return;
+
+	_active = active;
+	for (auto& e : _children)
+		e->RefreshActive();
 }
 
 bool Entity::GetEnabled() const
@@ -66,12 +86,13 @@ void Entity::SetEnabled(bool enabled, bool force)
 	if (force || !isInActiveScene())
 	{
 		_enabled = enabled;
-		EventManager::Notify(EventName::ENTITY_ENABLE, new TypeParam<Entity*>(this));
+		RefreshActive();
+		EventManager::Notify(EventName::ENTITY_ENABLE, this);
 	}
 	else // defer 
 	{
 		OmegaEngine::Instance().DeferAction(
-			new StatusActionParam((enabled) ? StatusActionType::Enable : StatusActionType::Disable, this));
+			(enabled) ? StatusActionType::Enable : StatusActionType::Disable, this);
 	}
 }
 
@@ -113,8 +134,7 @@ void Entity::SetParent(Entity* parent, bool force)
 	}
 	else // defer 
 	{
-		OmegaEngine::Instance().DeferAction(
-			new StatusActionParam(StatusActionType::Move, this, parent));
+		OmegaEngine::Instance().DeferAction(StatusActionType::Move, this, parent);
 	}
 }
 
@@ -140,8 +160,7 @@ void Entity::AddChild(Entity* child, bool force)
 	}
 	else // defer 
 	{
-		OmegaEngine::Instance().DeferAction(
-			new StatusActionParam(StatusActionType::Move, child, this));
+		OmegaEngine::Instance().DeferAction(StatusActionType::Move, child, this);
 	}
 }
 
@@ -167,6 +186,7 @@ void Entity::bindEntities(Entity * parent, Entity * child)
 		parent->_children.push_back(child);
 		child->_parent = parent;
 		child->setScene(parent->getScene());
+		child->RefreshActive();
 
 		// initialize? 
 		if (parent->isInActiveScene())
@@ -178,29 +198,12 @@ void Entity::bindEntities(Entity * parent, Entity * child)
 	{
 		child->_parent = nullptr;
 		child->setScene(nullptr);
+		child->RefreshActive();
 	}
 
 	// Notify 
 	EventManager::Notify(EventName::ENTITY_MOVE, 
-		new TypeParam<std::pair<Entity*, Entity*>>(std::make_pair(child, parent)));
-}
-
-// Despite being recursive this performs very well 
-// (comparable to local variable even in worst case scenario - all enabled)
-bool Entity::getParentEnabled() const
-{
-	// fast stop 
-	if (!_enabled)
-	{
-		return false;
-	}
-
-	if (_parent)
-	{
-		return _parent->getParentEnabled();
-	}
-
-	return true;
+		std::make_pair(child, parent));
 }
 
 std::vector<Entity*> const& Entity::GetChildren() const
@@ -212,6 +215,7 @@ void Entity::AddComponent(Component * component)
 {
 	component->SetEntity(this);
 	_components.push_back(component);
+	_componentCacheValid.store(0);
 }
 
 void Entity::RemoveComponent(Component * c)
@@ -221,6 +225,7 @@ void Entity::RemoveComponent(Component * c)
 	{
 		delete(*it);
 		_components.erase(it);
+		_componentCacheValid.store(0);
 	}
 	/* 
 	_componentStorage.erase(
@@ -243,6 +248,8 @@ void Entity::Destroy(bool force)
 		// TODO: destruct all components 
 		for (auto& c : _components)
 			delete(c);
+		_components.clear();
+		_componentCacheValid.store(0);
 
 		// Remove from parent and release memory 
 		if (_parent)
@@ -253,9 +260,15 @@ void Entity::Destroy(bool force)
 	}
 	else // defer
 	{
+		if (_destroyQueued)
+		{
+			std::cout << "WARNING: You are attempting to delete an entity twice, check your code!" << std::endl;
+			return;
+		}
+		_destroyQueued = true;
+
 		std::cout << "Scheduling: " << this->GetID() << " for destruction" << std::endl;
-		OmegaEngine::Instance().DeferAction(
-			new StatusActionParam(StatusActionType::Delete, this));
+		OmegaEngine::Instance().DeferAction(StatusActionType::Delete, this);
 	}
 }
 
@@ -3,6 +3,7 @@
 #define GLM_ENABLE_EXPERIMENTAL	// I have no idea why we can't put this in main
 
 #include <vector>
+#include <atomic>
 #include <unordered_map>
 #include <memory>
 #include <algorithm>
@@ -15,13 +16,19 @@
 #include <glm/gtx/matrix_decompose.hpp>
 #include "Component.h"
 #include "Transform.h"
+#include "EntityHandle.h"
 
 class Scene;
 
 class Entity
 {
+	friend class EntityManager;
+	friend class OmegaEngine;
 // Variables 
 public:
+	// Component types with cached GetComponent lookups, the rest fall back to a scan.
+	static const unsigned int MAX_CACHED_TYPES = 64;
+
 	Transform transform;
 	std::string name;
 
@@ -31,10 +38,15 @@ protected:
 private:
 	static unsigned int _curID;
 	unsigned int _id = 0;
+	EntityHandle _handle;	// assigned by the EntityManager
 	bool _enabled = true;
+	bool _active = false;	// cached: in active scene, this and all parents enabled
 	bool _static = false;
 	bool _initialized = false;
+	bool _destroyQueued = false;	// a deferred Destroy() is pending
 	std::vector<Component*> _components;	// component storage
+	std::atomic<void*> _componentCache[MAX_CACHED_TYPES];	// GetComponent results indexed by ComponentTypeID
+	std::atomic<unsigned long long> _componentCacheValid{ 0 };	// one bit per cached type
 	std::vector<Entity*> _children;
 	Entity* _parent;
 
@@ -44,18 +56,30 @@ public:
 	Entity(unsigned int id);	// WARNING: don't call this unless you know what you're doing.
 	~Entity();
 
+	// Entities are allocated from the EntityManager's pool.
+	static void* operator new(size_t size);
+	static void operator delete(void* ptr, size_t size);
+
 	// Returns entity's ID. This cannot change. 
 	unsigned int GetID() const;
 
+	// Returns a handle to this entity, keep this instead of the pointer if the entity can be destroyed.
+	// Null if the EntityManager didn't exist when this was created.
+	EntityHandle GetHandle() const { return _handle; }
+
 	// WARNING: Should only be called internally by the engine.
 	// Called when added into the active scene. 
 	void Initialize();
 
-	// TODO: Optimize
 	// Returns entity's active status. 
 	// Only true if in active scene, all parents enabled, and this is enabled.
+	// Cached, updated whenever the entity is enabled, moved or the scene changes.
 	bool GetActive() const;
 
+	// WARNING: Should only be called internally by the engine.
+	// Recomputes the active status, and the children's if it changed.
+	void RefreshActive();
+
 	// Returns entity's enabled status. Does not check if parent is enabled.
 	bool GetEnabled() const;
 
@@ -88,19 +112,25 @@ public:
 	// Adds a component to this entity.
 	void AddComponent(Component* component);
 
-	// Returns a pointer to specified component.
-	// Note: This is a relatively expensive operation, cache your results. 
+	// Returns a pointer to specified component (or a component derived from it).
+	// The first call per type scans the components, after that it's a lookup.
+	// Safe to call from multiple threads, as long as no component is added or removed meanwhile.
 	template<class T>
 	T* GetComponent()
 	{
-		// Rationale: This function should not be called often.
-		// If you need to constantly call this cache it or consider using a system.
-		for (const auto& c : _components)
-		{
-			auto found = dynamic_cast<T*>(c);
-			if (found) return found;
-		}
-		return nullptr;
+		const unsigned int type = ComponentTypeID::Get<T>();
+		if (type >= MAX_CACHED_TYPES)
+			return findComponent<T>();
+
+		const unsigned long long bit = 1ull << type;
+		if (_componentCacheValid.load(std::memory_order_acquire) & bit)
+			return static_cast<T*>(_componentCache[type].load(std::memory_order_relaxed));
+
+		// racing misses find and store the same component
+		T* found = findComponent<T>();
+		_componentCache[type].store(found, std::memory_order_relaxed);
+		_componentCacheValid.fetch_or(bit, std::memory_order_release);
+		return found;
 	}
 
 	// Returns all components attached to this entity. 
@@ -121,6 +151,7 @@ public:
 			{
 				delete(*it);
 				_components.erase(it);
+				_componentCacheValid.store(0);
 				return;
 			}
 			else
@@ -149,13 +180,21 @@ protected:
 	Scene* getScene() const;
 	
 private:
+	template<class T>
+	T* findComponent()
+	{
+		for (const auto& c : _components)
+		{
+			auto found = dynamic_cast<T*>(c);
+			if (found) return found;
+		}
+		return nullptr;
+	}
+
 	// Helper method to remove child with ID. This should only be called internally, as bindings will not be correct.
 	void removeChild(unsigned int id);
 
 	// Helper method to properly bind a parent and child entity together. 
 	// Any method that moves an entity around will always go through this function.
 	static void bindEntities(Entity* parent, Entity* child);
-
-	// Helper method to determine if all parents are enabled. 
-	bool getParentEnabled() const;
 };
\ No newline at end of file
@@ -0,0 +1,24 @@
+#pragma once
+
+// Reference to an entity that knows when the entity is gone.
+// Unlike an Entity*, it's safe to keep after the entity is destroyed: 
+// EntityManager::Get() returns null once the entity's slot is released.
+// Packs a 20 bit slot index and a 12 bit generation into 32 bits. 0 is the null handle.
+struct EntityHandle
+{
+	static const unsigned int INDEX_BITS = 20;
+	static const unsigned int INDEX_MASK = (1u << INDEX_BITS) - 1;
+	static const unsigned int GENERATION_MASK = (1u << (32 - INDEX_BITS)) - 1;
+
+	unsigned int value = 0;
+
+	EntityHandle() {}
+	EntityHandle(unsigned int index, unsigned int generation) : value((generation << INDEX_BITS) | (index & INDEX_MASK)) {}
+
+	unsigned int GetIndex() const { return value & INDEX_MASK; }
+	unsigned int GetGeneration() const { return value >> INDEX_BITS; }
+	bool IsNull() const { return value == 0; }
+
+	bool operator==(const EntityHandle& other) const { return value == other.value; }
+	bool operator!=(const EntityHandle& other) const { return value != other.value; }
+};
@@ -1,3 +1,163 @@
 #include "EntityManager.h"
+#include <iostream>
+#include <new>
+#include <algorithm>
 
+Entity* EntityManager::Get(EntityHandle handle) const
+{
+	if (handle.IsNull())
+		return nullptr;
 
+	const unsigned int index = handle.GetIndex();
+	if (index >= _slotCount.load(std::memory_order_acquire))
+		return nullptr;
+
+	// remove clears the entity before bumping the generation, add stores the new entity after it,
+	// so if the generation still matches after reading the entity, it's the handle's entity (or null)
+	const Slot* slot = getSlot(index);
+	Entity* entity = slot->entity.load(std::memory_order_acquire);
+	return (slot->generation.load(std::memory_order_acquire) == handle.GetGeneration()) ? entity : nullptr;
+}
+
+void* EntityManager::Allocate(size_t size)
+{
+	// derived entities are bigger, they use the heap
+	if (size != sizeof(Entity))
+		return ::operator new(size);
+
+	Pool& pool = getPool();
+	std::unique_lock<std::mutex> lock(pool.mtx);
+
+	if (pool.freeList == nullptr)
+	{
+		const size_t blockSize = (sizeof(Entity) + 15) / 16 * 16;
+		char* slab = static_cast<char*>(::operator new(blockSize * ENTITIES_PER_SLAB));
+		pool.slabs.push_back(slab);
+
+		for (size_t i = ENTITIES_PER_SLAB; i-- > 0; )
+		{
+			FreeBlock* block = reinterpret_cast<FreeBlock*>(slab + i * blockSize);
+			block->next = pool.freeList;
+			pool.freeList = block;
+		}
+	}
+
+	FreeBlock* block = pool.freeList;
+	pool.freeList = block->next;
+	return block;
+}
+
+void EntityManager::Release(void* ptr, size_t size)
+{
+	if (ptr == nullptr)
+		return;
+
+	if (size != sizeof(Entity))
+	{
+		::operator delete(ptr);
+		return;
+	}
+
+	Pool& pool = getPool();
+	std::unique_lock<std::mutex> lock(pool.mtx);
+
+	FreeBlock* block = static_cast<FreeBlock*>(ptr);
+	block->next = pool.freeList;
+	pool.freeList = block;
+}
+
+void EntityManager::Notify(EventName eventName, Param *params)
+{
+	auto entityParam = static_cast<TypeParam<Entity*>*>(params);
+	if (eventName == EventName::ENTITY_CREATED)
+	{
+		add(entityParam->Param);
+	}
+	else if (eventName == EventName::ENTITY_DESTROYED)
+	{
+		remove(entityParam->Param);
+	}
+}
+
+void EntityManager::add(Entity* entity)
+{
+	std::unique_lock<std::mutex> lock(_mtx);
+
+	unsigned int index;
+	if (_freeSlot != NO_SLOT)
+	{
+		index = _freeSlot;
+		_freeSlot = getSlot(index)->nextFree;
+	}
+	else
+	{
+		if (_slotCount > EntityHandle::INDEX_MASK)
+		{
+			std::cerr << "ERROR: EntityManager ran out of entity handles" << std::endl;
+			entities.push_back(entity);
+			return;
+		}
+
+		index = _slotCount.load(std::memory_order_relaxed);
+		std::atomic<Slot*>& page = _pages[index / SLOTS_PER_PAGE];
+		if (page.load(std::memory_order_relaxed) == nullptr)
+			page.store(new Slot[SLOTS_PER_PAGE], std::memory_order_release);
+		_slotCount.store(index + 1, std::memory_order_release);
+	}
+
+	Slot* slot = getSlot(index);
+	slot->entity.store(entity, std::memory_order_release);
+	slot->dense = (unsigned int)entities.size();
+	entities.push_back(entity);
+	entity->_handle = EntityHandle(index, slot->generation.load(std::memory_order_relaxed));
+}
+
+void EntityManager::remove(Entity* entity)
+{
+	std::unique_lock<std::mutex> lock(_mtx);
+
+	EntityHandle handle = entity->_handle;
+	if (handle.IsNull() || Get(handle) != entity)
+	{
+		// created before the manager existed
+		auto it = std::find(entities.begin(), entities.end(), entity);
+		if (it != entities.end())
+			eraseDense((unsigned int)(it - entities.begin()));
+		return;
+	}
+
+	Slot* slot = getSlot(handle.GetIndex());
+	eraseDense(slot->dense);
+
+	// invalidates every handle to the entity
+	slot->entity.store(nullptr, std::memory_order_release);
+	unsigned int generation = (slot->generation.load(std::memory_order_relaxed) + 1) & EntityHandle::GENERATION_MASK;
+	if (generation == 0)
+		generation = 1;
+	slot->generation.store(generation, std::memory_order_release);
+	slot->nextFree = _freeSlot;
+	_freeSlot = handle.GetIndex();
+	entity->_handle = EntityHandle();
+}
+
+void EntityManager::eraseDense(unsigned int dense)
+{
+	// swap with the last entity to keep the list packed
+	Entity* last = entities.back();
+	entities[dense] = last;
+	if (!last->_handle.IsNull())
+		getSlot(last->_handle.GetIndex())->dense = dense;
+	entities.pop_back();
+}
+
+EntityManager::Slot* EntityManager::getSlot(unsigned int index) const
+{
+	return &_pages[index / SLOTS_PER_PAGE].load(std::memory_order_acquire)[index % SLOTS_PER_PAGE];
+}
+
+EntityManager::Pool& EntityManager::getPool()
+{
+	// never destroyed, entities can outlive static destruction
+	static Pool* pool = new Pool();
+	return *pool;
+}
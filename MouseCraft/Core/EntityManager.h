@@ -1,14 +1,26 @@
 #pragma once
 
 #include <vector>
+#include <mutex>
+#include <atomic>
 #include "Entity.h"
+#include "EntityHandle.h"
 #include "../Event/EventManager.h"
 
 // Convenience class to retrieve all entities (including ones 
 // not in the scene root) in a flat vector. 
+// Also hands out generational handles and the memory for entities (see Entity::operator new).
 class EntityManager : public ISubscriber
 {
 public:
+	// Handle slots are allocated in pages that never move, so lookups don't need a lock:
+	// Get only does atomic loads, add/remove publish with atomic stores under _mtx.
+	static const unsigned int SLOTS_PER_PAGE = 4096;
+	static const unsigned int MAX_PAGES = (EntityHandle::INDEX_MASK + 1) / SLOTS_PER_PAGE;
+
+	// Entities allocated at once when the pool is empty.
+	static const size_t ENTITIES_PER_SLAB = 64;
+
 // singleton 
 public:
 	static EntityManager& Instance()
@@ -26,9 +38,35 @@ private:
 	};
 	~EntityManager() {};
 
+	struct Slot
+	{
+		std::atomic<Entity*> entity{ nullptr };
+		std::atomic<unsigned int> generation{ 1 };	// never 0 so a null handle never matches
+		unsigned int dense = 0;			// index in entities, only used under _mtx
+		unsigned int nextFree = 0;		// only used under _mtx
+	};
+
+	struct FreeBlock
+	{
+		FreeBlock* next;
+	};
+
+	struct Pool
+	{
+		std::mutex mtx;
+		FreeBlock* freeList = nullptr;
+		std::vector<char*> slabs;
+	};
+
+	static const unsigned int NO_SLOT = 0xFFFFFFFF;
+
 // variables 
 private:
 	std::vector<Entity*> entities;
+	std::atomic<Slot*> _pages[MAX_PAGES] = {};
+	std::atomic<unsigned int> _slotCount{ 0 };	// slots used so far, bumped after their page is published
+	unsigned int _freeSlot = NO_SLOT;	// head of the released slots
+	std::mutex _mtx;
 
 // functions 
 public:
@@ -42,20 +80,25 @@ public:
 		return entities;
 	}
 
-	virtual void Notify(EventName eventName, Param *params)
-	{
-		auto entityParam = static_cast<TypeParam<Entity*>*>(params);
-		if (eventName == EventName::ENTITY_CREATED)
-		{
-			entities.push_back(entityParam->Param);
-		}
-		else if (eventName == EventName::ENTITY_DESTROYED)
-		{
-			entities.erase(
-				std::remove(entities.begin(), entities.end(), entityParam->Param), 
-				entities.end());
-		}
-	}
+	// Returns the entity the handle refers to, null if it has been destroyed.
+	// Safe to call from any thread while entities are added and removed. The entity itself is
+	// only safe to use until it's destroyed, which in the active scene is deferred to the main thread.
+	Entity* Get(EntityHandle handle) const;
+
+	// WARNING: Should only be called internally by the engine.
+	// Memory for Entity::operator new/delete. Entities share one free list,
+	// so spawning and destroying them doesn't fragment the heap.
+	static void* Allocate(size_t size);
+	static void Release(void* ptr, size_t size);
+
+	virtual void Notify(EventName eventName, Param *params);
+
+private:
+	void add(Entity* entity);
+	void remove(Entity* entity);
+	void eraseDense(unsigned int dense);
+	Slot* getSlot(unsigned int index) const;
+	static Pool& getPool();
 };
 
 /*
@@ -68,4 +111,4 @@ for active status and engnie for deferred exeuction handling).
 Considering changing this in the future to aid cohesion but this 
 would increase coupling from 2 (Entity+Engine) 
 to 3 (Engine + EntityManager + SceneManager? + Entity? if abstracting Entity.Destroy() etc.) 
-*/
\ No newline at end of file
+*/
@@ -1,8 +1,11 @@
 #include "OmegaEngine.h"
+#include <algorithm>
 #include <chrono>
 #include <SDL2/SDL.h>
 #include "../gl/glad.h"
 #include "TaskScheduler.h"
+#include "TickManager.h"
+#include "EntityManager.h"
 #include "../Event/EventManager.h"
 #include "../Graphics/Window.h" 
 
@@ -22,6 +25,17 @@ void OmegaEngine::initialize()
 
 	_profiler.StartTimer(5);
 
+	// start the worker threads, this thread becomes worker 0
+	TaskScheduler::instance();
+	for (int set = 0; set < 2; ++set)
+	{
+		for (unsigned int i = 0; i < TaskScheduler::instance().GetWorkerCount(); ++i)
+			_commandBuffers[set].push_back(new StatusCommandBuffer());
+	}
+
+	// entities created from now on get handles
+	EntityManager::Instance();
+
 	// main is defined elsewhere
 	_window = new Window("MouseCraft", SCREEN_WIDTH, SCREEN_HEIGHT);
 
@@ -39,6 +53,7 @@ void OmegaEngine::ChangeScene(Scene* scene)
 void OmegaEngine::AddSystem(System * system)
 {
 	_systems.push_back(system);
+	_systemGraphDirty = true;
 }
 
 void OmegaEngine::AddEntity(Entity* entity)
@@ -69,27 +84,30 @@ void OmegaEngine::Pause(bool p)
 	_isPause = p;
 }
 
-void OmegaEngine::DeferAction(StatusActionParam * action)
+void OmegaEngine::DeferAction(StatusActionType action, Entity* target, Entity* destination)
 {
-	std::unique_lock<std::mutex> lock(_deferredActionMtx);
-	if (action->action == StatusActionType::Delete)
-	{
-		// WARNING: You can still double delete an entity by deleting the parent and child (passes validation).
-		const bool is_in = _destructionValidation.find(action->target->GetID()) != _destructionValidation.end();
-		if (is_in)
-		{
-			std::cout << "WARNING: You are attempting to delete an entity twice, check your code!" << std::endl;
-			// do nothing
-		}
-		else
-		{
-			_destructionValidation.insert(action->target->GetID());
-			_deferredActionsBack.push_back(action);
-		}
-	}
-	else
+	StatusCommand command;
+	command.action = action;
+	command.target = target;
+	command.destination = destination;
+	command.targetHandle = target->GetHandle();
+	command.destinationHandle = (destination) ? destination->GetHandle() : EntityHandle();
+
+	// same set for the worker buffer and the overflow
+	const int write = _commandWrite.load();
+
+	// workers only touch their own buffer 
+	const int worker = TaskScheduler::instance().GetWorkerIndex();
+	if (worker >= 0 && worker < (int)_commandBuffers[0].size()
+		&& _commandBuffers[write][worker]->Push(command))
+		return;
+
+	std::unique_lock<std::mutex> lock(_overflowMtx);
+	auto& overflow = _overflowBuffers[write];
+	if (overflow.empty() || !overflow.back()->Push(command))
 	{
-		_deferredActionsBack.push_front(action);
+		overflow.push_back(acquireOverflowBuffer());
+		overflow.back()->Push(command);
 	}
 }
 
@@ -137,56 +155,25 @@ void OmegaEngine::sequential_loop()
 
 		// PHASE 1: Status Change Resolution
 		_profiler.StartTimer(2);
-		// swap buffers 
-		std::swap(_deferredActions, _deferredActionsBack);
-		while (!_deferredActions.empty())
-		{
-			// WARNING: MEMORY LEAK - USE UNIQUE_POINTER 
-			auto action = _deferredActions.front();
-			
-			switch (action->action)
-			{
-			case Move:
-				action->target->SetParent(action->destination, true);
-				break;
-			case Delete:
-				action->target->Destroy(true);
-				break;
-			case Enable:
-				action->target->SetEnabled(true, true);
-				break;
-			case Disable:
-				action->target->SetEnabled(false, true);
-				break;
-			default:
-				std::cerr << "ERROR: UNKNOWN S.ACTION" << std::endl;
-				break;
-			}
-
-			_deferredActions.pop_front();
-		}
+		executeDeferredActions();
 		_profiler.StopTimer(2);
 
 		// PHASE 1.5: Transformation precompute 
 		_profiler.StartTimer(3);
-		precomputeTransforms(&_activeScene->root);
+		_transformHierarchy.Update(&_activeScene->root);
 		_profiler.StopTimer(3);
 
 		// PHASE 2: Component Update
 		_profiler.StartTimer(4);
-		auto deltaParam = new TypeParam<float>(deltaSeconds);	// Consider: Using unique-pointer for self-destruct
-		EventManager::Notify(EventName::COMPONENT_UPDATE, deltaParam);	// serial
-		delete(deltaParam);
+		TickManager::Instance().Tick(deltaSeconds);
+		EventManager::Notify(EventName::COMPONENT_UPDATE, deltaSeconds);	// other subscribers, serial
 		_profiler.StopTimer(4);
 
 		// PHASE 3: System Update
 		// During this phase the entity state is frozen. 
 		// Entity parent, child, enable, or delete is deferred until next frame.
 		_profiler.StartTimer(5);
-		for (auto& s : _systems)
-		{
-			s->Update(deltaSeconds);
-		}
+		updateSystems(deltaSeconds);
 		_profiler.StopTimer(5);
 
 		_profiler.StopTimer(0);
@@ -207,38 +194,223 @@ void OmegaEngine::transitionScenes()
 		_activeScene->root.Destroy(true);
 		delete(_activeScene);
 	}
-	std::deque<StatusActionParam*>().swap(_deferredActions);	// https://stackoverflow.com/questions/709146/how-do-i-clear-the-stdqueue-efficiently
-	std::deque<StatusActionParam*>().swap(_deferredActionsBack);
+	clearDeferredActions();
 	_sceneChangeRequested = false;
 	// load 
 	_activeScene = _nextScene;
+	_activeScene->root.RefreshActive();
+	_transformHierarchy.MarkStructureDirty();
 	_activeScene->InitScene();
 	_activeScene->root.SetEnabled(true, true);
 	// transfer entities 
 	for (auto& e : transitionHolder.GetChildren())
 		_activeScene->root.AddChild(e);
+	// everything could have changed
+	TickManager::Instance().MarkAllDirty();
 }
 
-Window* OmegaEngine::getWindow() const
+void OmegaEngine::executeDeferredActions()
 {
-	return _window;
+	int read;
+	{
+		std::unique_lock<std::mutex> lock(_overflowMtx);
+		read = _commandWrite.fetch_xor(1);
+	}
+
+	// status changes first, then deletes (a moved or enabled entity could be deleted)
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		const bool deletes = (pass == 1);
+		for (auto buffer : _commandBuffers[read])
+		{
+			for (unsigned int i = 0; i < buffer->count; ++i)
+			{
+				if ((buffer->commands[i].action == Delete) == deletes)
+					executeCommand(buffer->commands[i]);
+			}
+		}
+		// nothing else touches the read set, executed commands queue into the other one
+		for (auto buffer : _overflowBuffers[read])
+		{
+			for (unsigned int i = 0; i < buffer->count; ++i)
+			{
+				if ((buffer->commands[i].action == Delete) == deletes)
+					executeCommand(buffer->commands[i]);
+			}
+		}
+	}
+
+	for (auto buffer : _commandBuffers[read])
+		buffer->count = 0;
+
+	std::unique_lock<std::mutex> lock(_overflowMtx);
+	releaseOverflowBuffers(read);
 }
-void OmegaEngine::precomputeTransforms(Entity* entity, glm::mat4 parentTransformation)
+
+void OmegaEngine::executeCommand(const StatusCommand& command)
 {
-	// can use a enabled check here b/c of the scenegraph
-	if (!entity->GetEnabled())
-		return;
+	// entities without a handle were made before the EntityManager, trust the pointer
+	auto resolve = [](Entity* e, EntityHandle h) { return (h.IsNull()) ? e : EntityManager::Instance().Get(h); };
 
-	// calculate local transformation 
-	if (!entity->GetStatic())
-		entity->transform.computeLocalTransformation();
+	Entity* target = resolve(command.target, command.targetHandle);
+	if (target == nullptr)
+		return;	// destroyed since (ie. with its parent)
 
-	// calculate world transformation 
-	entity->transform.computeWorldTransformation(parentTransformation);
-	auto worldTransform = entity->transform.getWorldTransformation();
+	switch (command.action)
+	{
+	case Move:
+	{
+		Entity* destination = resolve(command.destination, command.destinationHandle);
+		if (command.destination && destination == nullptr)
+			return;
+		target->SetParent(destination, true);
+		break;
+	}
+	case Delete:
+		target->Destroy(true);
+		break;
+	case Enable:
+		target->SetEnabled(true, true);
+		break;
+	case Disable:
+		target->SetEnabled(false, true);
+		break;
+	default:
+		std::cerr << "ERROR: UNKNOWN S.ACTION" << std::endl;
+		break;
+	}
+}
+
+void OmegaEngine::clearDeferredActions()
+{
+	std::unique_lock<std::mutex> lock(_overflowMtx);
+	for (int set = 0; set < 2; ++set)
+	{
+		// entities that survive the transition can be deleted again
+		auto unqueue = [](const StatusCommand& command)
+		{
+			if (command.action != Delete) return;
+			Entity* target = (command.targetHandle.IsNull()) ? command.target : EntityManager::Instance().Get(command.targetHandle);
+			if (target) target->_destroyQueued = false;
+		};
 
-	// propogate to all children 
-	auto children = entity->GetChildren();
-	for (auto c : children)
-		precomputeTransforms(c, worldTransform);
+		for (auto buffer : _commandBuffers[set])
+		{
+			for (unsigned int i = 0; i < buffer->count; ++i)
+				unqueue(buffer->commands[i]);
+			buffer->count = 0;
+		}
+		for (auto buffer : _overflowBuffers[set])
+		{
+			for (unsigned int i = 0; i < buffer->count; ++i)
+				unqueue(buffer->commands[i]);
+		}
+		releaseOverflowBuffers(set);
+	}
+}
+
+StatusCommandBuffer* OmegaEngine::acquireOverflowBuffer()
+{
+	if (_spareOverflowBuffers.empty())
+		return new StatusCommandBuffer();
+
+	StatusCommandBuffer* buffer = _spareOverflowBuffers.back();
+	_spareOverflowBuffers.pop_back();
+	return buffer;
+}
+
+void OmegaEngine::releaseOverflowBuffers(int set)
+{
+	// keep a few for the next burst, a spike doesn't hold on to its memory
+	for (auto buffer : _overflowBuffers[set])
+	{
+		if (_spareOverflowBuffers.size() < MAX_SPARE_OVERFLOW)
+		{
+			buffer->count = 0;
+			_spareOverflowBuffers.push_back(buffer);
+		}
+		else
+		{
+			delete buffer;
+		}
+	}
+	_overflowBuffers[set].clear();
+}
+
+void OmegaEngine::buildSystemGraph()
+{
+	// A system goes one level after the last system it conflicts with,
+	// this keeps the registration order between conflicting systems.
+	_systemLevels.clear();
+	std::vector<size_t> levelOf(_systems.size());
+	size_t levels = 0;
+	for (size_t i = 0; i < _systems.size(); ++i)
+	{
+		size_t level = 0;
+		for (size_t j = 0; j < i; ++j)
+		{
+			if (_systems[i]->ConflictsWith(*_systems[j]) && levelOf[j] + 1 > level)
+				level = levelOf[j] + 1;
+		}
+		levelOf[i] = level;
+		levels = std::max(levels, level + 1);
+	}
+
+	// Main thread systems sink to the last level the systems after them allow,
+	// so they keep the main thread busy while the worker systems of that level run.
+	for (size_t i = _systems.size(); i-- > 0;)
+	{
+		if (!_systems[i]->GetMainThread())
+			continue;
+		size_t level = levels - 1;
+		for (size_t j = i + 1; j < _systems.size(); ++j)
+		{
+			if (_systems[i]->ConflictsWith(*_systems[j]) && levelOf[j] - 1 < level)
+				level = levelOf[j] - 1;
+		}
+		levelOf[i] = level;
+	}
+
+	_systemLevels.resize(levels);
+	for (size_t i = 0; i < _systems.size(); ++i)
+		_systemLevels[levelOf[i]].push_back(_systems[i]);
+	_systemGraphDirty = false;
+}
+
+void OmegaEngine::updateSystems(float dt)
+{
+	if (_systemGraphDirty)
+		buildSystemGraph();
+
+	auto& scheduler = TaskScheduler::instance();
+	for (auto& level : _systemLevels)
+	{
+		// worker systems are queued first so they run while the main thread is busy 
+		Task* root = scheduler.CreateTask();
+		for (auto s : level)
+		{
+			if (!s->GetMainThread())
+				scheduler.Run(scheduler.CreateChildTask(root, [s, dt]() { s->Update(dt); }));
+		}
+		scheduler.Run(root);
+
+		for (auto s : level)
+		{
+			if (s->GetMainThread())
+				s->Update(dt);
+		}
+
+		// helps with the remaining systems
+		scheduler.Wait(root);
+	}
+
+	for (auto s : _systems)
+	{
+		s->LateUpdate(dt);
+	}
+}
+
+Window* OmegaEngine::getWindow() const
+{
+	return _window;
 }
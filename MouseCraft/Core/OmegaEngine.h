@@ -10,6 +10,7 @@
 #include <memory>
 #include <chrono>
 #include <mutex>
+#include <atomic>
 #include <queue>
 #include <deque>
 #include <SDL2/SDL.h>
@@ -19,6 +20,7 @@
 #include "Scene.h"
 #include "../Util/CpuProfiler.h"
 #include "StatusAction.h"
+#include "TransformHierarchy.h"
 #include "../Graphics/Window.h"
 
 // Screen dimension constants
@@ -55,11 +57,20 @@ private:
 	Scene* _nextScene;
 	CpuProfiler _profiler;
 	RootEntity transitionHolder;	// used to hold entities while transitioning scene.
-	std::deque<StatusActionParam*> _deferredActions;
-	std::deque<StatusActionParam*> _deferredActionsBack;
-	std::set<int> _destructionValidation;	// to ensure an entity is not deleted twice
-	std::mutex _deferredActionMtx;
+	// Deferred status changes, one buffer per worker so queueing doesn't lock.
+	// Double buffered: actions queued while executing go to the next frame.
+	std::vector<StatusCommandBuffer*> _commandBuffers[2];
+	// Full buffers and threads that aren't workers spill into extra buffers, filled in order.
+	// Emptied ones are kept for reuse, at most MAX_SPARE_OVERFLOW of them.
+	std::vector<StatusCommandBuffer*> _overflowBuffers[2];
+	std::vector<StatusCommandBuffer*> _spareOverflowBuffers;
+	std::mutex _overflowMtx;
+	static const size_t MAX_SPARE_OVERFLOW = 2;
+	std::atomic<int> _commandWrite{ 0 };	// set being filled, read once per DeferAction
 	std::vector<System*> _systems;
+	std::vector<std::vector<System*>> _systemLevels;	// systems in a level don't conflict and run together
+	bool _systemGraphDirty = true;
+	TransformHierarchy _transformHierarchy;
 	int _frameCount;
 
 // functions 
@@ -82,6 +93,8 @@ public:
 	void ChangeScene(Scene* scene);
 
 	// Add a system to receive updates. 
+	// Systems that don't conflict (see System::ConflictsWith) are updated in parallel,
+	// conflicting systems are updated in the order they were added.
 	void AddSystem(System* system);
 
 	// Gets the system of type. Not recommended to call every frame.
@@ -117,7 +130,8 @@ public:
 
 	// WARNING: Should only be called internally by the engine.
 	// Defers actions that can cause catastrophic failure. 
-	void DeferAction(StatusActionParam* action);
+	// Executed at the start of next frame: in calling order per thread, deletes last.
+	void DeferAction(StatusActionType action, Entity* target, Entity* destination = nullptr);
 
 	// Get the total elapsed frames.
 	int GetFrame() const;
@@ -136,6 +150,22 @@ private:
 
 	void transitionScenes();
 
-	void precomputeTransforms(Entity* entity, glm::mat4 parentTransformation = glm::mat4(1.0f));
+	// Executes the actions deferred last frame.
+	void executeDeferredActions();
+
+	void executeCommand(const StatusCommand& command);
+
+	// Overflow buffer bookkeeping, _overflowMtx must be held.
+	StatusCommandBuffer* acquireOverflowBuffer();
+	void releaseOverflowBuffers(int set);
+
+	// Drops all deferred actions.
+	void clearDeferredActions();
+
+	// Groups systems into levels so that no two systems in a level conflict.
+	void buildSystemGraph();
+
+	// Updates all systems level by level.
+	void updateSystems(float dt);
 };
 
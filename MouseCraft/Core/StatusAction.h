@@ -1,5 +1,7 @@
 #pragma once
 
+#include "EntityHandle.h"
+
 // Note: You should not use any of these. These are used internally by the engine. 
 
 class Entity;
@@ -9,15 +11,35 @@ enum StatusActionType
 	Move, Delete, Enable, Disable
 };
 
-struct StatusActionParam
+// A deferred status change. Plain data so it can be copied into a StatusCommandBuffer.
+// The handles are checked before executing so a command on an entity that was
+// destroyed in the meantime (ie. with its parent) is skipped.
+struct StatusCommand
 {
-public:
-	StatusActionParam(StatusActionType action, Entity* target, Entity* destination = nullptr)
-		: action(action), target(target), destination(destination) {}
-
 	StatusActionType action;
 	Entity* target;
 	Entity* destination;
+	EntityHandle targetHandle;
+	EntityHandle destinationHandle;
+};
+
+// Fixed-capacity list of commands filled by a single thread.
+// Aligned so buffers of different threads don't share a cache line.
+struct alignas(64) StatusCommandBuffer
+{
+	static const unsigned int CAPACITY = 1024;
+
+	unsigned int count = 0;
+	StatusCommand commands[CAPACITY];
+
+	// Returns false if full.
+	bool Push(const StatusCommand& command)
+	{
+		if (count >= CAPACITY)
+			return false;
+		commands[count++] = command;
+		return true;
+	}
 };
 
 /*
@@ -1,4 +1,5 @@
 #include "System.h"
+#include <algorithm>
 
 System::System()
 {
@@ -7,3 +8,51 @@ System::System()
 System::~System()
 {
 }
+
+const std::vector<std::type_index>& System::GetReads() const
+{
+	return _reads;
+}
+
+const std::vector<std::type_index>& System::GetWrites() const
+{
+	return _writes;
+}
+
+bool System::GetMainThread() const
+{
+	return _mainThread;
+}
+
+bool System::ConflictsWith(const System& other) const
+{
+	// be safe with systems that never declared their dependencies
+	if (!_declared || !other._declared)
+		return true;
+
+	auto contains = [](const std::vector<std::type_index>& v, const std::type_index& t)
+	{
+		return std::find(v.begin(), v.end(), t) != v.end();
+	};
+
+	// write-write and write-read
+	for (auto& t : _writes)
+	{
+		if (contains(other._writes, t) || contains(other._reads, t))
+			return true;
+	}
+
+	// read-write
+	for (auto& t : _reads)
+	{
+		if (contains(other._writes, t))
+			return true;
+	}
+
+	return false;
+}
+
+void System::RunOnMainThread(bool mainThread)
+{
+	_mainThread = mainThread;
+}
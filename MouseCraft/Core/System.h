@@ -1,10 +1,64 @@
 #pragma once
 
+#include <vector>
+#include <typeindex>
+#include <typeinfo>
+
+// Tag for the gameplay code a system calls into (component callbacks, observers, event subscribers).
+// Gameplay code spawns and destroys entities and edits any component, so a system declaring
+// Writes<GameplayCode>() has to stay on the main thread. Systems that touch components gameplay
+// edits (ie. UI panels) declare Reads<GameplayCode>() to stay ordered with them.
+struct GameplayCode {};
+
 class System
 {
 public:
 	System();
-	~System();
+	virtual ~System();
 	
 	virtual void Update(float dt) = 0;
+
+	// Called after every system finished Update, serially on the main thread in registration order.
+	// Use it for work that must see the final state of the frame.
+	virtual void LateUpdate(float dt) {};
+
+	// Types this system reads during Update.
+	const std::vector<std::type_index>& GetReads() const;
+
+	// Types this system writes during Update.
+	const std::vector<std::type_index>& GetWrites() const;
+
+	// True if Update has to run on the main thread (ie. GL context or SDL event pump).
+	bool GetMainThread() const;
+
+	// True if both systems can't run at the same time.
+	// A system that didn't declare anything conflicts with everything.
+	bool ConflictsWith(const System& other) const;
+
+protected:
+	// Declare that Update reads instances of T. 
+	// T is usually a component type, but any type can be used as a tag for shared state.
+	template<typename T>
+	void Reads()
+	{
+		_reads.push_back(std::type_index(typeid(T)));
+		_declared = true;
+	}
+
+	// Declare that Update writes instances of T (implies read).
+	template<typename T>
+	void Writes()
+	{
+		_writes.push_back(std::type_index(typeid(T)));
+		_declared = true;
+	}
+
+	// Let the engine run Update on a worker thread. Systems run on the main thread by default.
+	void RunOnMainThread(bool mainThread);
+
+private:
+	std::vector<std::type_index> _reads;
+	std::vector<std::type_index> _writes;
+	bool _declared = false;
+	bool _mainThread = true;
 };
@@ -1,5 +0,0 @@
-#include "Task.h"
-
-void Task::Execute()
-{
-}
@@ -1,10 +1,23 @@
 #pragma once
 
-#include <iostream>
+#include <atomic>
 
-class Task
+struct Task;
+
+// Function executed by a task. Data points at the task's inline payload.
+typedef void(*TaskFunction)(Task* task, void* data);
+
+// Size of the inline payload available to a task's function (bytes).
+#define TASK_DATA_SIZE 40
+
+// A unit of work for the TaskScheduler. Tasks are pooled by the scheduler,
+// never new/delete them - use TaskScheduler::CreateTask() instead.
+// Padded to a cache line so workers never share one.
+struct alignas(64) Task
 {
-public:
-	virtual void Execute();
+	TaskFunction function;
+	Task* parent;						// parent is not complete until all children are.
+	std::atomic<int> unfinishedTasks;	// 1 for this task + 1 for each unfinished child.
+	int padding;
+	alignas(8) char data[TASK_DATA_SIZE];
 };
-
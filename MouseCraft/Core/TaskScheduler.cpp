@@ -1,17 +1,7 @@
 #include "TaskScheduler.h"
-#ifndef NOMINMAX
-#define NOMINMAX 1
-#endif
-#include <Windows.h>
-//
-//TaskScheduler::TaskScheduler()
-//{
-//}
-//
-//
-//TaskScheduler::~TaskScheduler()
-//{
-//}
+
+// index of the worker owned by this thread, -1 if not a worker
+static thread_local int _workerIndex = -1;
 
 TaskScheduler& TaskScheduler::instance()
 {
@@ -19,96 +9,202 @@ TaskScheduler& TaskScheduler::instance()
 	return singleton;
 }
 
-TaskScheduler::TaskScheduler()
+TaskScheduler::TaskScheduler() : _running(true), _sleeping(0), _workGeneration(0)
 {
-	unsigned concurentThreadsSupported = std::thread::hardware_concurrency();
-	threads.reserve(concurentThreadsSupported);
-	for (int i = 0; i < concurentThreadsSupported; i++)
+	unsigned int concurentThreadsSupported = std::thread::hardware_concurrency();
+	if (concurentThreadsSupported == 0)
+		concurentThreadsSupported = 1;
+
+	_workers.reserve(concurentThreadsSupported);
+	for (unsigned int i = 0; i < concurentThreadsSupported; i++)
 	{
-		// std::cout << "Created thread" << std::endl;
-		threads.push_back(std::thread(&TaskScheduler::ProcessTask, this));
-		// threads.emplace_back(std::bind(ProcessTask));
+		Worker* w = new Worker();
+		w->pool = new Task[MAX_TASKS];
+		_workers.push_back(w);
 	}
 
-	//std::vector<std::thread> threads;
+	// the creating thread is worker 0, spawn the rest
+	_workerIndex = 0;
+	_threads.reserve(concurentThreadsSupported - 1);
+	for (unsigned int i = 1; i < concurentThreadsSupported; i++)
+	{
+		_threads.push_back(std::thread(&TaskScheduler::workerLoop, this, i));
+	}
 }
 
 TaskScheduler::~TaskScheduler()
 {
+	_running = false;
+	{
+		std::unique_lock<std::mutex> lock(_sleepMtx);
+		_workGeneration++;
+		_sleepCv.notify_all();
+	}
+	for (auto& t : _threads)
+		t.join();
+
+	for (auto w : _workers)
+	{
+		delete[] w->pool;
+		delete w;
+	}
 }
 
-void TaskScheduler::ScheduleTask(Task * task)
+unsigned int TaskScheduler::GetWorkerCount() const
 {
-	// LOCK
-	std::unique_lock<std::mutex> lock(mtx);
-	//std::cout << "+++Added task" << std::endl;
-	++runningTask;
-	tasks.push(task);
-	cv.notify_one();
-	// UNLOCK
+	return (unsigned int)_workers.size();
 }
 
-Task * TaskScheduler::Retrieve()
+bool TaskScheduler::IsWorkerThread() const
 {
+	return _workerIndex >= 0;
+}
+
+int TaskScheduler::GetWorkerIndex() const
+{
+	return _workerIndex;
+}
+
+Task* TaskScheduler::CreateTask()
+{
+	return allocate(nullptr, nullptr);
+}
+
+Task* TaskScheduler::CreateTask(TaskFunction function)
+{
+	return allocate(nullptr, function);
+}
+
+Task* TaskScheduler::CreateChildTask(Task* parent, TaskFunction function)
+{
+	return allocate(parent, function);
+}
+
+void TaskScheduler::Run(Task* task)
+{
+	Worker* self = getWorker();
+	if (self == nullptr || !self->queue.Push(task))
 	{
-		// LOCK
-		//std::unique_lock<std::mutex> lock(mtx);
-		//cv.wait(lock);	// UNLOCK
-
-		//if (tasks.empty())
-		//{
-		//	std::cout << "Waiting for tasks" << std::endl;
-		//	// LOCK 
-		//	std::cout << "---Found a task!" << std::endl;
-		//}
-		//else
-		//{
-		//	std::cout << "---Task was present" << std::endl;
-		//}
-
-		std::unique_lock<std::mutex> lock(mtx);
-		if (!tasks.empty())
-		{
-			auto t = tasks.front();
-			tasks.pop();
-			return t;
-		}
+		// unknown thread or queue full, just do it now
+		execute(task);
+		return;
+	}
+	wakeWorkers();
+}
+
+void TaskScheduler::Wait(const Task* task)
+{
+	Worker* self = getWorker();
+	while (!IsComplete(task))
+	{
+		Task* next = (self) ? getTask(self) : nullptr;
+		if (next)
+			execute(next);
 		else
-		{
-			return nullptr;
-		}
+			std::this_thread::yield();
 	}
 }
 
-void TaskScheduler::ProcessTask()
+bool TaskScheduler::IsComplete(const Task* task) const
 {
-	// std::cout << "thread initialized: " << std::this_thread::get_id() << std::endl;
-	while (true)
+	return task->unfinishedTasks.load(std::memory_order_acquire) == 0;
+}
+
+Task* TaskScheduler::allocate(Task* parent, TaskFunction function)
+{
+	Worker* self = getWorker();
+	Task* task;
+	if (self)
+	{
+		task = &self->pool[self->allocated++ & (MAX_TASKS - 1)];
+	}
+	else
 	{
-		// retrieve task 
-		std::unique_lock<std::mutex> lock(mtx);
-		
-		while (tasks.empty()) cv.wait(lock);
-		auto t = tasks.front();
-		tasks.pop();
-
-		lock.unlock();
-
-		// execute task 
-		// std::cout << std::this_thread::get_id() << std::endl;
-		t->Execute();
-		delete(t);
-		--runningTask;
-		
-		waitCv.notify_one();
+		// Consider: Giving foreign threads their own pool. Nothing does this yet.
+		static thread_local Task foreignPool[MAX_TASKS];
+		static thread_local unsigned int foreignAllocated = 0;
+		task = &foreignPool[foreignAllocated++ & (MAX_TASKS - 1)];
 	}
+
+	task->function = function;
+	task->parent = parent;
+	task->unfinishedTasks.store(1, std::memory_order_relaxed);
+
+	if (parent)
+		parent->unfinishedTasks.fetch_add(1, std::memory_order_relaxed);
+
+	return task;
 }
 
-void TaskScheduler::Wait()
+Task* TaskScheduler::getTask(Worker* self)
 {
-	while (runningTask > 0)
+	Task* task = self->queue.Pop();
+	if (task)
+		return task;
+
+	// steal, starting from the next worker so everyone doesn't hammer worker 0
+	const unsigned int count = (unsigned int)_workers.size();
+	const unsigned int start = (unsigned int)_workerIndex + 1;
+	for (unsigned int i = 0; i < count - 1; ++i)
 	{
-		std::unique_lock<std::mutex> lock(waitMtx);
-		waitCv.wait(lock);
+		Worker* victim = _workers[(start + i) % count];
+		task = victim->queue.Steal();
+		if (task)
+			return task;
 	}
+	return nullptr;
+}
+
+void TaskScheduler::execute(Task* task)
+{
+	if (task->function)
+		task->function(task, task->data);
+	finish(task);
+}
+
+void TaskScheduler::finish(Task* task)
+{
+	const int remaining = task->unfinishedTasks.fetch_sub(1, std::memory_order_acq_rel) - 1;
+	if (remaining == 0 && task->parent)
+		finish(task->parent);
+}
+
+void TaskScheduler::workerLoop(unsigned int index)
+{
+	_workerIndex = (int)index;
+	Worker* self = _workers[index];
+
+	while (_running)
+	{
+		// generation is read before looking for work so a push that happens
+		// after we give up is guaranteed to wake us up
+		unsigned int generation = _workGeneration.load();
+
+		Task* task = getTask(self);
+		if (task)
+		{
+			execute(task);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(_sleepMtx);
+		++_sleeping;
+		_sleepCv.wait(lock, [&]() { return _workGeneration.load() != generation || !_running; });
+		--_sleeping;
+	}
+}
+
+void TaskScheduler::wakeWorkers()
+{
+	_workGeneration++;
+	if (_sleeping.load() > 0)
+	{
+		std::unique_lock<std::mutex> lock(_sleepMtx);
+		_sleepCv.notify_all();
+	}
+}
+
+TaskScheduler::Worker* TaskScheduler::getWorker() const
+{
+	return (_workerIndex >= 0) ? _workers[_workerIndex] : nullptr;
 }
@@ -1,38 +1,166 @@
 #pragma once
-#include <iostream>
 #include <mutex>
 #include <condition_variable>
-#include <queue>
 #include <thread>
 #include <atomic>
+#include <vector>
+#include <new>
+#include <utility>
+#include <type_traits>
 #include "Task.h"
+#include "WorkStealingQueue.h"
 
+// Work-stealing task scheduler.
+// Every worker (including the thread that created the scheduler) owns a deque and
+// a pool of tasks. Workers execute their own tasks first and steal from others when idle.
+//
+// Usage:
+//	auto& ts = TaskScheduler::instance();
+//	Task* root = ts.CreateTask();
+//	for (...) ts.Run(ts.CreateChildTask(root, [=]() { ... }));
+//	ts.Run(root);
+//	ts.Wait(root);	// helps execute tasks until root and all children are done.
+//
+// Note: Tasks are recycled after MAX_TASKS allocations on the same thread,
+// a task must be waited on before that happens (ie. don't keep them across frames).
 class TaskScheduler
 {
 public:
+	// Tasks per worker pool. Must be a power of two.
+	static const unsigned int MAX_TASKS = 4096;
+
 	static TaskScheduler& instance();
+	TaskScheduler(TaskScheduler const&) = delete;
+	void operator=(TaskScheduler const&) = delete;
+
+private:
 	TaskScheduler();
 	~TaskScheduler();
-	std::queue<Task*> tasks;
-	std::vector<std::thread> threads;
-	// CircularBuffer<std::thread> threads;
-	
-	std::mutex mtx;
-	std::condition_variable cv;
 
-	std::atomic<int> runningTask;
-	std::mutex waitMtx;
-	std::condition_variable waitCv;
+	struct Worker
+	{
+		WorkStealingQueue queue;
+		Task* pool;
+		unsigned int allocated = 0;
+	};
+
+// variables
+private:
+	std::vector<Worker*> _workers;		// [0] is the thread that created the scheduler
+	std::vector<std::thread> _threads;
+	std::atomic<bool> _running;
 
-public: 
+	// idle workers sleep here until new work is queued
+	std::mutex _sleepMtx;
+	std::condition_variable _sleepCv;
+	std::atomic<int> _sleeping;
+	std::atomic<unsigned int> _workGeneration;
 
-	void ScheduleTask(Task* task);
+// functions
+public:
+	// Number of workers including the main thread.
+	unsigned int GetWorkerCount() const;
 
-	Task* Retrieve();
+	// Returns true if the calling thread is one of the scheduler's workers.
+	bool IsWorkerThread() const;
 
-	void ProcessTask();
+	// Returns the index of the calling worker [0, GetWorkerCount()), -1 if not a worker.
+	int GetWorkerIndex() const;
 
-	void Wait();
+	// Creates an empty task. Useful as a parent to wait on.
+	Task* CreateTask();
 
-};
+	// Creates a task that calls function with its inline data.
+	Task* CreateTask(TaskFunction function);
+
+	// Creates a task that runs func. The callable is stored inline in the task so it
+	// must fit in TASK_DATA_SIZE bytes (capture pointers, not containers).
+	template<typename Func>
+	Task* CreateTask(Func&& func)
+	{
+		return createInline(nullptr, std::forward<Func>(func));
+	}
+
+	// Creates a task that counts as a child of parent.
+	// Parent will not be complete until this is complete.
+	Task* CreateChildTask(Task* parent, TaskFunction function);
+
+	template<typename Func>
+	Task* CreateChildTask(Task* parent, Func&& func)
+	{
+		return createInline(parent, std::forward<Func>(func));
+	}
+
+	// Queues a task on the calling worker.
+	// If called from a thread the scheduler doesn't know about the task is executed immediately.
+	void Run(Task* task);
+
+	// Blocks until task (and its children) is complete. The calling thread executes
+	// other tasks while waiting, so it's safe to call from within a task.
+	void Wait(const Task* task);
+
+	// Returns true if task and all of its children finished executing.
+	bool IsComplete(const Task* task) const;
+
+	// Splits [0, count) into chunks of chunkSize and calls func(begin, end) on each in parallel.
+	// Blocks until all chunks are done. func must outlive the call (it's captured by pointer).
+	template<typename Func>
+	void ParallelFor(unsigned int count, unsigned int chunkSize, const Func& func)
+	{
+		if (count == 0) return;
+		if (chunkSize == 0) chunkSize = 1;
 
+		// not worth splitting
+		if (count <= chunkSize || !IsWorkerThread())
+		{
+			func(0u, count);
+			return;
+		}
+
+		const Func* f = &func;
+		Task* root = CreateTask();
+		for (unsigned int begin = 0; begin < count; begin += chunkSize)
+		{
+			unsigned int end = (begin + chunkSize < count) ? begin + chunkSize : count;
+			Run(CreateChildTask(root, [f, begin, end]() { (*f)(begin, end); }));
+		}
+		Run(root);
+		Wait(root);
+	}
+
+private:
+	template<typename Func>
+	Task* createInline(Task* parent, Func&& func)
+	{
+		typedef typename std::decay<Func>::type F;
+		static_assert(sizeof(F) <= TASK_DATA_SIZE, "Task callable is too large, capture less (or capture by pointer).");
+		static_assert(alignof(F) <= 8, "Task callable is over-aligned.");
+
+		Task* task = allocate(parent, &invokeInline<F>);
+		new (task->data) F(std::forward<Func>(func));
+		return task;
+	}
+
+	template<typename F>
+	static void invokeInline(Task*, void* data)
+	{
+		F* f = static_cast<F*>(data);
+		(*f)();
+		f->~F();
+	}
+
+	Task* allocate(Task* parent, TaskFunction function);
+
+	// Finds a task to execute: own queue first, then steal.
+	Task* getTask(Worker* self);
+
+	void execute(Task* task);
+
+	void finish(Task* task);
+
+	void workerLoop(unsigned int index);
+
+	void wakeWorkers();
+
+	Worker* getWorker() const;
+};
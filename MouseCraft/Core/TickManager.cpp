@@ -0,0 +1,297 @@
+#include "TickManager.h"
+#include <algorithm>
+#include "UpdatableComponent.h"
+#include "Entity.h"
+#include "TaskScheduler.h"
+#include "../Event/EventManager.h"
+
+TickManager::TickManager()
+{
+	EventManager::Subscribe(EventName::ENTITY_ENABLE, this);
+	EventManager::Subscribe(EventName::ENTITY_MOVE, this);
+}
+
+TickManager::~TickManager()
+{
+	EventManager::Unsubscribe(EventName::ENTITY_ENABLE, this);
+	EventManager::Unsubscribe(EventName::ENTITY_MOVE, this);
+}
+
+void TickManager::Tick(float dt)
+{
+	{
+		std::lock_guard<std::recursive_mutex> lock(_mtx);
+		flushPending();
+		flushDirty();
+		_ticking = true;
+	}
+
+	// Note: Buckets are only added in flushPending, so _buckets doesn't change while ticking.
+	// Status changes made by Update are applied next tick.
+	auto& scheduler = TaskScheduler::instance();
+	for (auto& bucket : _buckets)
+	{
+		const size_t count = bucket.activeCount;
+		if (count == 0)
+			continue;
+
+		if (bucket.concurrent)
+		{
+			UpdatableComponent** components = bucket.components.data();
+			scheduler.ParallelFor((unsigned int)count, CONCURRENT_CHUNK_SIZE, [components, dt](unsigned int begin, unsigned int end)
+			{
+				for (unsigned int i = begin; i < end; ++i)
+				{
+					UpdatableComponent* c = components[i];
+					if (c && c->GetEnabled())
+						c->Update(dt);
+				}
+			});
+		}
+		else
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				// component could have been disabled or deleted by a previous update
+				UpdatableComponent* c = bucket.components[i];
+				if (c && c->GetEnabled())
+					c->Update(dt);
+			}
+		}
+	}
+
+	std::lock_guard<std::recursive_mutex> lock(_mtx);
+	_ticking = false;
+	for (auto& bucket : _buckets)
+	{
+		if (bucket.hasHoles)
+			compact(bucket);
+	}
+}
+
+void TickManager::Register(UpdatableComponent* component)
+{
+	std::lock_guard<std::recursive_mutex> lock(_mtx);
+	component->_tickPending = true;
+	_pending.push_back(component);
+}
+
+void TickManager::Unregister(UpdatableComponent* component)
+{
+	std::lock_guard<std::recursive_mutex> lock(_mtx);
+
+	if (component->_tickPending)
+	{
+		_pending.erase(std::remove(_pending.begin(), _pending.end(), component), _pending.end());
+		component->_tickPending = false;
+	}
+
+	if (component->_tickDirty)
+	{
+		std::replace(_dirty.begin(), _dirty.end(), component, (UpdatableComponent*)nullptr);
+		component->_tickDirty = false;
+	}
+
+	if (component->_tickBucket >= 0)
+		removeFromBucket(component);
+}
+
+void TickManager::MarkDirty(UpdatableComponent* component)
+{
+	std::lock_guard<std::recursive_mutex> lock(_mtx);
+	if (!component->_tickDirty)
+	{
+		component->_tickDirty = true;
+		_dirty.push_back(component);
+	}
+}
+
+void TickManager::MarkAllDirty()
+{
+	std::lock_guard<std::recursive_mutex> lock(_mtx);
+	for (auto& bucket : _buckets)
+	{
+		for (auto c : bucket.components)
+		{
+			if (c) MarkDirty(c);
+		}
+	}
+}
+
+size_t TickManager::GetActiveCount() const
+{
+	std::lock_guard<std::recursive_mutex> lock(_mtx);
+	size_t count = 0;
+	for (auto& bucket : _buckets)
+		count += bucket.activeCount;
+	return count;
+}
+
+void TickManager::Notify(EventName eventName, Param* params)
+{
+	switch (eventName)
+	{
+	case EventName::ENTITY_ENABLE:
+		markEntityDirty(static_cast<TypeParam<Entity*>*>(params)->Param);
+		break;
+	case EventName::ENTITY_MOVE:
+		markEntityDirty(static_cast<TypeParam<std::pair<Entity*, Entity*>>*>(params)->Param.first);
+		break;
+	default:
+		break;
+	}
+}
+
+void TickManager::setConcurrent(std::type_index type, bool concurrent)
+{
+	std::lock_guard<std::recursive_mutex> lock(_mtx);
+
+	auto it = std::find(_concurrentTypes.begin(), _concurrentTypes.end(), type);
+	if (concurrent && it == _concurrentTypes.end())
+		_concurrentTypes.push_back(type);
+	else if (!concurrent && it != _concurrentTypes.end())
+		_concurrentTypes.erase(it);
+
+	for (auto& bucket : _buckets)
+	{
+		if (bucket.type == type)
+			bucket.concurrent = concurrent;
+	}
+}
+
+void TickManager::flushPending()
+{
+	for (auto c : _pending)
+	{
+		// fully constructed now, so typeid gives the concrete type
+		std::type_index type(typeid(*c));
+
+		int index = -1;
+		for (size_t i = 0; i < _buckets.size(); ++i)
+		{
+			if (_buckets[i].type == type)
+			{
+				index = (int)i;
+				break;
+			}
+		}
+
+		if (index < 0)
+		{
+			Bucket bucket(type);
+			bucket.concurrent = std::find(_concurrentTypes.begin(), _concurrentTypes.end(), type) != _concurrentTypes.end();
+			_buckets.push_back(bucket);
+			index = (int)_buckets.size() - 1;
+		}
+
+		// starts inactive, the dirty flush decides
+		Bucket& bucket = _buckets[index];
+		c->_tickPending = false;
+		c->_tickBucket = index;
+		c->_tickIndex = (unsigned int)bucket.components.size();
+		c->_tickActive = false;
+		bucket.components.push_back(c);
+		MarkDirty(c);
+	}
+	_pending.clear();
+}
+
+void TickManager::flushDirty()
+{
+	for (auto c : _dirty)
+	{
+		if (c == nullptr)
+			continue;
+
+		c->_tickDirty = false;
+		setActive(c, c->GetActive());
+	}
+	_dirty.clear();
+}
+
+void TickManager::setActive(UpdatableComponent* component, bool active)
+{
+	if (component->_tickActive == active)
+		return;
+
+	Bucket& bucket = _buckets[component->_tickBucket];
+	auto& components = bucket.components;
+
+	// swap with the element at the border of the active range
+	const unsigned int from = component->_tickIndex;
+	const unsigned int to = (unsigned int)((active) ? bucket.activeCount : bucket.activeCount - 1);
+
+	UpdatableComponent* other = components[to];
+	components[to] = component;
+	components[from] = other;
+	other->_tickIndex = from;
+	component->_tickIndex = to;
+	component->_tickActive = active;
+
+	if (active)
+		++bucket.activeCount;
+	else
+		--bucket.activeCount;
+}
+
+void TickManager::removeFromBucket(UpdatableComponent* component)
+{
+	Bucket& bucket = _buckets[component->_tickBucket];
+	component->_tickBucket = -1;
+
+	if (_ticking)
+	{
+		// can't move anything around while updating
+		bucket.components[component->_tickIndex] = nullptr;
+		bucket.hasHoles = true;
+		return;
+	}
+
+	// move to the inactive range, then swap with the last element
+	component->_tickBucket = (int)(&bucket - _buckets.data());
+	setActive(component, false);
+	component->_tickBucket = -1;
+
+	UpdatableComponent* last = bucket.components.back();
+	bucket.components[component->_tickIndex] = last;
+	last->_tickIndex = component->_tickIndex;
+	bucket.components.pop_back();
+}
+
+void TickManager::compact(Bucket& bucket)
+{
+	std::vector<UpdatableComponent*> components;
+	components.reserve(bucket.components.size());
+
+	size_t activeCount = 0;
+	for (size_t i = 0; i < bucket.components.size(); ++i)
+	{
+		UpdatableComponent* c = bucket.components[i];
+		if (c == nullptr)
+			continue;
+
+		c->_tickIndex = (unsigned int)components.size();
+		components.push_back(c);
+		if (i < bucket.activeCount)
+			++activeCount;
+	}
+
+	bucket.components.swap(components);
+	bucket.activeCount = activeCount;
+	bucket.hasHoles = false;
+}
+
+void TickManager::markEntityDirty(Entity* entity)
+{
+	if (entity == nullptr)
+		return;
+
+	for (auto c : entity->GetComponents())
+	{
+		auto u = dynamic_cast<UpdatableComponent*>(c);
+		if (u) MarkDirty(u);
+	}
+
+	for (auto child : entity->GetChildren())
+		markEntityDirty(child);
+}
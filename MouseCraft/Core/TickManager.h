@@ -0,0 +1,102 @@
+#pragma once
+
+#include <vector>
+#include <mutex>
+#include <typeindex>
+#include <typeinfo>
+#include "../Event/ISubscriber.h"
+
+class UpdatableComponent;
+class Entity;
+
+// Updates every UpdatableComponent once per frame (engine PHASE 2).
+// Components are grouped by concrete type and each group keeps its active
+// components packed at the front, so a tick is a tight loop per type.
+// Active status is only re-evaluated for components whose status may have changed
+// (entity enabled/moved, component enabled, scene changed).
+class TickManager : public ISubscriber
+{
+// singleton 
+public:
+	static TickManager& Instance()
+	{
+		static TickManager _instance;
+		return _instance;
+	}
+	TickManager(TickManager const&) = delete;
+	void operator=(TickManager const&) = delete;
+private:
+	TickManager();
+	~TickManager();
+
+	struct Bucket
+	{
+		std::type_index type;
+		std::vector<UpdatableComponent*> components;	// [0, activeCount) are active
+		size_t activeCount = 0;
+		bool concurrent = false;
+		bool hasHoles = false;	// components removed during a tick leave null slots
+
+		Bucket(std::type_index t) : type(t) {}
+	};
+
+// variables 
+private:
+	std::vector<Bucket> _buckets;
+	std::vector<UpdatableComponent*> _pending;	// registered, not bucketed yet (type is only known once constructed)
+	std::vector<UpdatableComponent*> _dirty;	// active status needs re-evaluation
+	std::vector<std::type_index> _concurrentTypes;
+	mutable std::recursive_mutex _mtx;
+	bool _ticking = false;
+
+	// components per task when updating a concurrent type
+	static const unsigned int CONCURRENT_CHUNK_SIZE = 64;
+
+// functions 
+public:
+	// Updates all active components.
+	void Tick(float dt);
+
+	// Allow instances of ComponentType to be updated in parallel with each other.
+	// Only do this if Update touches nothing but its own entity, and no other
+	// instance of the type shares that entity. Types are still updated one after the other.
+	template<typename ComponentType>
+	void SetConcurrent(bool concurrent)
+	{
+		setConcurrent(std::type_index(typeid(ComponentType)), concurrent);
+	}
+
+	// WARNING: Should only be called internally by the engine.
+	// Starts/stops updating a component.
+	void Register(UpdatableComponent* component);
+	void Unregister(UpdatableComponent* component);
+
+	// WARNING: Should only be called internally by the engine.
+	// Re-evaluates if the component is active before the next tick.
+	void MarkDirty(UpdatableComponent* component);
+
+	// WARNING: Should only be called internally by the engine.
+	// Re-evaluates every component (ie. the active scene changed).
+	void MarkAllDirty();
+
+	// Number of components that will be updated next tick.
+	size_t GetActiveCount() const;
+
+	// Inherited via ISubscriber
+	void Notify(EventName eventName, Param* params) override;
+
+private:
+	void setConcurrent(std::type_index type, bool concurrent);
+
+	void flushPending();
+	void flushDirty();
+
+	// moves a component in or out of the active range of its bucket
+	void setActive(UpdatableComponent* component, bool active);
+
+	void removeFromBucket(UpdatableComponent* component);
+
+	void compact(Bucket& bucket);
+
+	void markEntityDirty(Entity* entity);
+};
@@ -9,6 +9,7 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/quaternion.hpp>
 #include <glm/gtx/euler_angles.hpp>
+#include "../Util/AffineMath.h"
 
 glm::vec3 Transform::getLocalPosition() const
 {
@@ -18,6 +19,7 @@ glm::vec3 Transform::getLocalPosition() const
 void Transform::setLocalPosition(glm::vec3 position)
 {
 	_localPosition = position;
+	_dirty = true;
 }
 
 glm::vec3 Transform::getLocalRotation() const
@@ -29,6 +31,7 @@ void Transform::setLocalRotation(glm::vec3 rotation)
 {
 	_localRotation = rotation;
 	_localQuat = glm::quat(rotation);
+	_dirty = true;
 }
 
 glm::quat Transform::getLocalQuaternion() const
@@ -40,6 +43,7 @@ void Transform::setLocalRotation(glm::quat rotation)
 {
 	_localRotation = glm::eulerAngles(rotation);
 	_localQuat = rotation;
+	_dirty = true;
 }
 
 glm::vec3 Transform::getLocalScale() const
@@ -50,6 +54,7 @@ glm::vec3 Transform::getLocalScale() const
 void Transform::setLocalScale(glm::vec3 scale)
 {
 	_localScale = scale;
+	_dirty = true;
 }
 
 glm::vec3 Transform::getWorldPosition() const
@@ -87,14 +92,9 @@ glm::vec3 Transform::getWorldRotation() const
 	return glm::vec3(x,y,z);
 }
 
-// WARNING: UNTESTED.
 glm::vec3 Transform::getWorldScale() const
 {
-	return glm::vec3(
-		glm::length(glm::vec3(_worldTransformation[0])),
-		glm::length(glm::vec3(_worldTransformation[1])),
-		glm::length(glm::vec3(_worldTransformation[2]))
-	);
+	return AffineMath::ExtractScale(_worldTransformation);
 }
 
 glm::vec3 Transform::getLocalForward() const
@@ -173,8 +173,8 @@ void Transform::face2D(glm::vec3 dir)
 
 void Transform::computeLocalTransformation()
 {
-	_localTransformation = glm::mat4(1.0f);
-	_localTransformation = glm::translate(_localTransformation, _localPosition);
+	// translate * rotate * scale in one go
+	_localTransformation = AffineMath::Compose(_localPosition, _localQuat, _localScale);
 
 	/*
 	// we going super-sonic http://www.opengl-tutorial.org/assets/faq_quaternions/index.html#Q26
@@ -201,15 +201,12 @@ void Transform::computeLocalTransformation()
 	rot[3][3] = 1.0f;
 	_localTransformation = _localTransformation * rot;
 	*/
-
-	_localTransformation = _localTransformation * (glm::mat4)_localQuat;
-
-	_localTransformation = glm::scale(_localTransformation, _localScale);
 }
 
-void Transform::computeWorldTransformation(glm::mat4 parent)
+void Transform::computeWorldTransformation(const glm::mat4& parent)
 {
-	_worldTransformation = parent * _localTransformation;
+	AffineMath::Multiply(parent, _localTransformation, _worldTransformation);
+	++_worldVersion;
 }
 
 float Transform::getAngle2D(glm::vec2 dir)
@@ -6,6 +6,7 @@
 
 class Transform
 {
+	friend class TransformHierarchy;
 public:
 	Transform() {};
 	~Transform() {};
@@ -78,6 +79,9 @@ public:
 	// Gets the world transformation matrix. 
 	glm::mat4 getWorldTransformation() const;
 
+	// Goes up every time the world transformation is recomputed, compare to notice changes.
+	unsigned int getWorldVersion() const { return _worldVersion; }
+
 	// Face towards the direction vector 
 	void face2D(glm::vec2 dir);
 	void face2D(glm::vec3 dir);
@@ -88,7 +92,7 @@ public:
 	void computeLocalTransformation();
 
 	// compute the world transformation matrix with a given parent transformation.
-	void computeWorldTransformation(glm::mat4 parent = glm::mat4(1.0f));
+	void computeWorldTransformation(const glm::mat4& parent = glm::mat4(1.0f));
 
 #pragma region Aliases
 
@@ -147,4 +151,7 @@ private:
 	glm::vec3 _localScale = glm::vec3(1.0f);
 	glm::mat4 _localTransformation;
 	glm::mat4 _worldTransformation;
+	bool _dirty = true;	// local values changed since the last transform pass
+	unsigned int _worldVersion = 0;
+	int _level = -1;	// depth in the flattened scene graph, -1 if it was never in it
 };
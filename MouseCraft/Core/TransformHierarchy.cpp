@@ -0,0 +1,200 @@
+#include "TransformHierarchy.h"
+#include "Entity.h"
+#include "TaskScheduler.h"
+#include "../Event/EventManager.h"
+#include "../Util/AffineMath.h"
+
+TransformHierarchy::TransformHierarchy() : _rebuildFrom(0)
+{
+	EventManager::Subscribe(EventName::ENTITY_MOVE, this);
+	EventManager::Subscribe(EventName::ENTITY_ENABLE, this);
+	EventManager::Subscribe(EventName::ENTITY_DESTROYED, this);
+}
+
+TransformHierarchy::~TransformHierarchy()
+{
+	EventManager::Unsubscribe(EventName::ENTITY_MOVE, this);
+	EventManager::Unsubscribe(EventName::ENTITY_ENABLE, this);
+	EventManager::Unsubscribe(EventName::ENTITY_DESTROYED, this);
+}
+
+void TransformHierarchy::Update(Entity* root)
+{
+	const int from = _rebuildFrom.exchange(CLEAN);
+	if (root != _root)
+		rebuild(root, 0);
+	else if (from != CLEAN)
+		rebuild(root, from);
+
+	auto& scheduler = TaskScheduler::instance();
+	for (size_t l = 0; l < _depth; ++l)
+	{
+		Level& level = _levels[l];
+		const Level* parentLevel = (l > 0) ? &_levels[l - 1] : nullptr;
+		scheduler.ParallelFor((unsigned int)level.entities.size(), CHUNK_SIZE, [&level, parentLevel](unsigned int begin, unsigned int end)
+		{
+			updateRange(level, parentLevel, begin, end);
+		});
+	}
+}
+
+void TransformHierarchy::MarkStructureDirty()
+{
+	markLevelDirty(0);
+}
+
+size_t TransformHierarchy::GetCount() const
+{
+	size_t count = 0;
+	for (size_t l = 0; l < _depth; ++l)
+		count += _levels[l].entities.size();
+	return count;
+}
+
+void TransformHierarchy::Notify(EventName eventName, Param* params)
+{
+	switch (eventName)
+	{
+	case EventName::ENTITY_MOVE:
+	{
+		// moved subtree needs a new world transformation
+		auto& move = static_cast<TypeParam<std::pair<Entity*, Entity*>>*>(params)->Param;
+		move.first->transform._dirty = true;
+		markLevelDirty(changedLevel(move.first, move.second));
+		break;
+	}
+	case EventName::ENTITY_ENABLE:
+	{
+		// wasn't updated while disabled
+		Entity* e = static_cast<TypeParam<Entity*>*>(params)->Param;
+		e->transform._dirty = true;
+		markLevelDirty(changedLevel(e, e->GetParent()));
+		break;
+	}
+	case EventName::ENTITY_DESTROYED:
+	{
+		// already taken from its parent, its children were destroyed first
+		Entity* e = static_cast<TypeParam<Entity*>*>(params)->Param;
+		markLevelDirty(changedLevel(e, nullptr));
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+int TransformHierarchy::changedLevel(Entity* e, Entity* parent)
+{
+	// an entity's level is only stale if it left the graph, that only makes the rebuild start higher
+	int level = CLEAN;
+	if (e->transform._level >= 0)
+		level = e->transform._level;
+	if (parent != nullptr && parent->transform._level >= 0 && parent->transform._level + 1 < level)
+		level = parent->transform._level + 1;
+	return level;
+}
+
+void TransformHierarchy::markLevelDirty(int level)
+{
+	int current = _rebuildFrom.load();
+	while (level < current && !_rebuildFrom.compare_exchange_weak(current, level))
+	{
+	}
+}
+
+void TransformHierarchy::rebuild(Entity* root, size_t from)
+{
+	if (from == 0 || from > _depth || _root != root)
+	{
+		// everything, starting at the root
+		_root = root;
+		_depth = 0;
+		if (root == nullptr || !root->GetEnabled())
+			return;
+
+		if (_levels.empty())
+			_levels.resize(1);
+		Level& top = _levels[0];
+		top.entities.assign(1, root);
+		top.parents.assign(1, 0);
+		top.locals.assign(1, root->transform._localTransformation);
+		top.worlds.assign(1, root->transform._worldTransformation);
+		top.changed.assign(1, 0);
+		root->transform._level = 0;
+		_depth = 1;
+	}
+	else
+	{
+		// the levels above 'from' didn't change
+		_depth = from;
+	}
+
+	// breadth first, disabled entities (and their children) are skipped like before
+	while (true)
+	{
+		if (_levels.size() <= _depth)
+			_levels.resize(_depth + 1);
+
+		const Level& level = _levels[_depth - 1];
+		Level& next = _levels[_depth];
+		next.entities.clear();
+		next.parents.clear();
+		next.locals.clear();
+		next.worlds.clear();
+
+		for (unsigned int i = 0; i < level.entities.size(); ++i)
+		{
+			for (auto c : level.entities[i]->GetChildren())
+			{
+				if (!c->GetEnabled())
+					continue;
+				next.entities.push_back(c);
+				next.parents.push_back(i);
+				next.locals.push_back(c->transform._localTransformation);
+				next.worlds.push_back(c->transform._worldTransformation);
+				c->transform._level = (int)_depth;
+			}
+		}
+
+		if (next.entities.empty())
+			break;
+		next.changed.resize(next.entities.size());
+		++_depth;
+	}
+}
+
+void TransformHierarchy::updateRange(Level& level, const Level* parentLevel, unsigned int begin, unsigned int end)
+{
+	static const glm::mat4 identity(1.0f);
+
+	for (unsigned int i = begin; i < end; ++i)
+	{
+		Entity* e = level.entities[i];
+		Transform& t = e->transform;
+
+		bool changed = t._dirty;
+		const glm::mat4* parentWorld = &identity;
+		if (parentLevel)
+		{
+			const unsigned int p = level.parents[i];
+			changed = changed || parentLevel->changed[p];
+			parentWorld = &parentLevel->worlds[p];
+		}
+
+		if (changed)
+		{
+			// static entities keep the local transformation they were frozen with
+			if (t._dirty)
+			{
+				if (!e->GetStatic())
+					t._localTransformation = AffineMath::Compose(t._localPosition, t._localQuat, t._localScale);
+				level.locals[i] = t._localTransformation;
+			}
+			AffineMath::Multiply(*parentWorld, level.locals[i], level.worlds[i]);
+			t._worldTransformation = level.worlds[i];
+			++t._worldVersion;
+			t._dirty = false;
+		}
+		level.changed[i] = changed;
+	}
+}
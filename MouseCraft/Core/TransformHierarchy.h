@@ -0,0 +1,72 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <glm/glm.hpp>
+#include "../Event/ISubscriber.h"
+
+class Entity;
+
+// Computes the world transformations of the active scene (engine PHASE 1.5).
+// The enabled part of the scene graph is flattened into one set of arrays per depth,
+// so a level can be processed in parallel once the level above it is done.
+// Local and world matrices are kept in those arrays in hierarchy order; a level reads the
+// world matrices of the level above instead of following entity pointers. Transform keeps
+// a copy of both, updated only where something changed, for its getters.
+// Only transforms that changed (see Transform setters) and their descendants are recomputed.
+// When entities are moved, enabled, disabled or destroyed, the levels from the shallowest
+// one they touched down are flattened again, the levels above are kept.
+class TransformHierarchy : public ISubscriber
+{
+public:
+	TransformHierarchy();
+	~TransformHierarchy();
+
+private:
+	// entities at the same depth, stored as separate arrays
+	struct Level
+	{
+		std::vector<Entity*> entities;
+		std::vector<unsigned int> parents;	// index into the level above
+		std::vector<glm::mat4> locals;
+		std::vector<glm::mat4> worlds;
+		std::vector<unsigned char> changed;	// world transformation was recomputed this frame
+	};
+
+// variables
+private:
+	std::vector<Level> _levels;	// only [0, _depth) are in use, the rest keep their memory
+	size_t _depth = 0;
+	Entity* _root = nullptr;
+	std::atomic<int> _rebuildFrom;	// shallowest level to flatten again, CLEAN if none
+
+	static const int CLEAN = 0x7fffffff;
+
+	// entities per task when updating a level
+	static const unsigned int CHUNK_SIZE = 256;
+
+// functions
+public:
+	// Updates the world transformations of root and its enabled descendants.
+	void Update(Entity* root);
+
+	// Forces the whole flattened graph to be rebuilt next update.
+	void MarkStructureDirty();
+
+	// Number of entities in the flattened graph.
+	size_t GetCount() const;
+
+	// Inherited via ISubscriber
+	void Notify(EventName eventName, Param* params) override;
+
+private:
+	// flattens the levels from 'from' down again, everything if from is 0
+	void rebuild(Entity* root, size_t from);
+
+	// level the structure changed at if e joins or leaves the graph under parent, CLEAN if neither is in it
+	static int changedLevel(Entity* e, Entity* parent);
+
+	void markLevelDirty(int level);
+
+	static void updateRange(Level& level, const Level* parentLevel, unsigned int begin, unsigned int end);
+};
@@ -1,23 +1,23 @@
 #include "UpdatableComponent.h"
 
-#include "../Event/EventManager.h"
-#include "Entity.h"
+#include "TickManager.h"
 
 UpdatableComponent::UpdatableComponent()
 {
-	EventManager::Subscribe(COMPONENT_UPDATE, this);
+	TickManager::Instance().Register(this);
 }
 
 UpdatableComponent::~UpdatableComponent()
 {
-	EventManager::Unsubscribe(COMPONENT_UPDATE, this);
+	TickManager::Instance().Unregister(this);
 }
 
 void UpdatableComponent::Notify(EventName eventName, Param * params)
 {
-	if (GetEnabled() && GetEntity() && GetEntity()->GetActive())
-	{
-		auto delta = static_cast<TypeParam<float>*>(params);
-		Update(delta->Param);
-	}
+	// Note: Update is called by the TickManager, subclasses still call this from their own Notify.
+}
+
+void UpdatableComponent::onStatusChanged()
+{
+	TickManager::Instance().MarkDirty(this);
 }
@@ -3,12 +3,24 @@
 #include "Component.h"
 #include "../Event/ISubscriber.h"
 
+// Component that is updated once per frame by the TickManager.
 class UpdatableComponent : public Component, public ISubscriber
 {
+	friend class TickManager;
 public:
 	UpdatableComponent();
 	~UpdatableComponent();
 	virtual void Update(float deltaTime) = 0;
 	virtual void Notify(EventName eventName, Param *params);
-};
 
+protected:
+	void onStatusChanged() override;
+
+private:
+	// bookkeeping for the TickManager
+	int _tickBucket = -1;
+	unsigned int _tickIndex = 0;
+	bool _tickActive = false;
+	bool _tickDirty = false;
+	bool _tickPending = false;
+};
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include "Task.h"
+
+// Fixed capacity Chase-Lev deque.
+// The owning worker pushes and pops from the bottom (LIFO),
+// any other worker can steal from the top (FIFO).
+// Memory orderings follow "Correct and Efficient Work-Stealing for Weak Memory Models" (Le et al. 2013).
+class WorkStealingQueue
+{
+public:
+	// Must be a power of two.
+	static const long CAPACITY = 4096;
+	static const long MASK = CAPACITY - 1;
+
+	WorkStealingQueue() : _top(0), _bottom(0)
+	{
+		for (auto& t : _tasks)
+			t.store(nullptr, std::memory_order_relaxed);
+	}
+
+	// Owner only. Returns false if the queue is full.
+	bool Push(Task* task)
+	{
+		long b = _bottom.load(std::memory_order_relaxed);
+		long t = _top.load(std::memory_order_acquire);
+		if (b - t >= CAPACITY)
+			return false;
+
+		_tasks[b & MASK].store(task, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		_bottom.store(b + 1, std::memory_order_relaxed);
+		return true;
+	}
+
+	// Owner only. Returns nullptr if empty.
+	Task* Pop()
+	{
+		long b = _bottom.load(std::memory_order_relaxed) - 1;
+		_bottom.store(b, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		long t = _top.load(std::memory_order_relaxed);
+
+		if (t > b)
+		{
+			// empty
+			_bottom.store(b + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		Task* task = _tasks[b & MASK].load(std::memory_order_relaxed);
+		if (t == b)
+		{
+			// last item, race against stealers
+			if (!_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				task = nullptr;
+			_bottom.store(b + 1, std::memory_order_relaxed);
+		}
+		return task;
+	}
+
+	// Any thread. Returns nullptr if empty or if another thread won the race.
+	Task* Steal()
+	{
+		long t = _top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		long b = _bottom.load(std::memory_order_acquire);
+
+		if (t >= b)
+			return nullptr;
+
+		Task* task = _tasks[t & MASK].load(std::memory_order_relaxed);
+		if (!_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			return nullptr;
+		return task;
+	}
+
+	// Approximate, only use as a hint.
+	bool Empty() const
+	{
+		return _bottom.load(std::memory_order_relaxed) <= _top.load(std::memory_order_relaxed);
+	}
+
+private:
+	alignas(64) std::atomic<long> _top;
+	alignas(64) std::atomic<long> _bottom;
+	alignas(64) std::atomic<Task*> _tasks[CAPACITY];
+};
@@ -1,43 +1,95 @@
 #include "EventManager.h"
-std::map<EventName, std::set<ISubscriber*>> EventManager::_eventMap;
+#include <algorithm>
 
-void EventManager::Notify(EventName eventName, Param* params, bool async) {
-    if (async) {
-        std::thread t(&notifySubscribers, eventName, params);
-        t.detach();
-    } else {
-        notifySubscribers(eventName, params);
+std::vector<ISubscriber*> EventManager::_subscribers[EVENT_COUNT];
+std::vector<EventManager::PendingSubscription> EventManager::_pendingSubscriptions;
+bool EventManager::_needsCompaction[EVENT_COUNT];
+bool EventManager::_hasPendingChanges = false;
+int EventManager::_dispatchDepth = 0;
+std::recursive_mutex EventManager::_mtx;
+
+void EventManager::Notify(EventName eventName, Param* params) {
+    std::lock_guard<std::recursive_mutex> lock(_mtx);
+
+    // subscribers added during dispatch go to the pending list, so the size can't grow here
+    auto& subscribers = _subscribers[eventName];
+    const size_t count = subscribers.size();
+
+    ++_dispatchDepth;
+    for (size_t i = 0; i < count; ++i) {
+        ISubscriber* subscriber = subscribers[i];
+        if (subscriber != nullptr) {
+            subscriber->Notify(eventName, params);
+        }
+    }
+    --_dispatchDepth;
+
+    if (_dispatchDepth == 0 && _hasPendingChanges) {
+        flushPending();
     }
 }
 
 void EventManager::Subscribe(EventName eventName, ISubscriber* subscriber) {
-    auto event = _eventMap.find(eventName);
-    if (event != _eventMap.end()) {
-        event->second.insert(subscriber);
+    std::lock_guard<std::recursive_mutex> lock(_mtx);
+
+    auto& subscribers = _subscribers[eventName];
+    if (std::find(subscribers.begin(), subscribers.end(), subscriber) != subscribers.end()) {
+        return;
+    }
+
+    if (_dispatchDepth > 0) {
+        _pendingSubscriptions.push_back(PendingSubscription{ eventName, subscriber });
+        _hasPendingChanges = true;
     } else {
-        std::set<ISubscriber*> subscriberList;
-        subscriberList.insert(subscriber);
-        _eventMap.insert(std::pair<EventName,std::set<ISubscriber*>>(eventName, subscriberList));
+        subscribers.push_back(subscriber);
     }
 }
 
 void EventManager::Unsubscribe(EventName eventName, ISubscriber* subscriber) {
-    auto event = _eventMap.find(eventName);
-    if (event != _eventMap.end()) {
-        auto it = event->second.find(subscriber);
-        if (it != event->second.end()) {
-            event->second.erase(it);
+    std::lock_guard<std::recursive_mutex> lock(_mtx);
+
+    auto& subscribers = _subscribers[eventName];
+    auto it = std::find(subscribers.begin(), subscribers.end(), subscriber);
+    if (it != subscribers.end()) {
+        if (_dispatchDepth > 0) {
+            // can't move anything around while iterating
+            *it = nullptr;
+            _needsCompaction[eventName] = true;
+            _hasPendingChanges = true;
+        } else {
+            subscribers.erase(it);
         }
     }
+
+    // could have subscribed during this dispatch
+    _pendingSubscriptions.erase(
+        std::remove_if(_pendingSubscriptions.begin(), _pendingSubscriptions.end(), 
+            [&](const PendingSubscription& p) { return p.eventName == eventName && p.subscriber == subscriber; }),
+        _pendingSubscriptions.end());
 }
 
-void EventManager::notifySubscribers(EventName eventName, Param* params) {
-    auto event = _eventMap.find(eventName);
-    if (event != _eventMap.end()) {
-        std::set<ISubscriber*> subscriberList = event->second;
+size_t EventManager::GetSubscriberCount(EventName eventName) {
+    std::lock_guard<std::recursive_mutex> lock(_mtx);
 
-        for (auto subscriber : subscriberList) {
-            subscriber->Notify(eventName, params);
+    auto& subscribers = _subscribers[eventName];
+    return subscribers.size() - std::count(subscribers.begin(), subscribers.end(), nullptr);
+}
+
+void EventManager::flushPending() {
+    for (int e = 0; e < EVENT_COUNT; ++e) {
+        if (_needsCompaction[e]) {
+            auto& subscribers = _subscribers[e];
+            subscribers.erase(std::remove(subscribers.begin(), subscribers.end(), nullptr), subscribers.end());
+            _needsCompaction[e] = false;
         }
     }
-}
\ No newline at end of file
+
+    for (auto& p : _pendingSubscriptions) {
+        auto& subscribers = _subscribers[p.eventName];
+        if (std::find(subscribers.begin(), subscribers.end(), p.subscriber) == subscribers.end()) {
+            subscribers.push_back(p.subscriber);
+        }
+    }
+    _pendingSubscriptions.clear();
+    _hasPendingChanges = false;
+}
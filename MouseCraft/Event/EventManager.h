@@ -2,29 +2,60 @@
 
 //created by main
 
-#include <map>
-#include <set>
-#include <thread>
+#include <vector>
+#include <mutex>
+#include <type_traits>
 #include "ISubscriber.h"
 #include "EventName.h"
 
 /**
     Event Manager is a static class that dispatches messages between various components of the engine.
     Any class that implements ISubscriber can subscribe to events to be notified when that event is triggered.
+
+    Params are only valid for the duration of the notify, pass them by value:
+        EventManager::Notify(EventName::INPUT_BUTTON, ButtonEvent{ player, b, isDown });
+    Subscribers still receive a Param* they can cast to TypeParam<T>*.
+
+    Subscribing or unsubscribing while an event is being dispatched is safe, the change
+    is applied once the dispatch finishes (an unsubscribed subscriber won't be called again).
+    Dispatch is serialized across threads, don't wait on another thread from within a Notify.
 */
 class EventManager {
 public:
-    // Use to notify subscribers of the specified event passing the given parameter
-    static void Notify(EventName eventName, Param* params, bool async = false);
+    // Use to notify subscribers of the specified event passing the given parameter.
+    // The caller owns params (put it on the stack).
+    static void Notify(EventName eventName, Param* params);
+
+    // Use to notify subscribers of the specified event, value is wrapped in a TypeParam<T> on the stack.
+    template<typename T, typename = typename std::enable_if<!std::is_convertible<T, Param*>::value>::type>
+    static void Notify(EventName eventName, const T& value) {
+        TypeParam<T> param(value);
+        Notify(eventName, &param);
+    }
 
     // Subscribes the specified subscriber to an event
     static void Subscribe(EventName eventName, ISubscriber* subscriber);
 
     // Unsubscribes the specified subscriber from an event
     static void Unsubscribe(EventName eventName, ISubscriber* subscriber);
+
+    // Number of subscribers to an event.
+    static size_t GetSubscriberCount(EventName eventName);
 private:
-    static std::map<EventName, std::set<ISubscriber*>> _eventMap;
-    static void notifySubscribers(EventName eventName, Param* params);
+    struct PendingSubscription {
+        EventName eventName;
+        ISubscriber* subscriber;
+    };
+
+    static std::vector<ISubscriber*> _subscribers[EVENT_COUNT];    // unsubscribed slots are null until compacted
+    static std::vector<PendingSubscription> _pendingSubscriptions;  // subscribed during dispatch
+    static bool _needsCompaction[EVENT_COUNT];
+    static bool _hasPendingChanges;
+    static int _dispatchDepth;
+    static std::recursive_mutex _mtx;
+
+    // Applies changes made during dispatch.
+    static void flushPending();
 
     EventManager() {}
-};
\ No newline at end of file
+};
@@ -19,4 +19,5 @@ enum EventName {
 	INPUT_MOUSE_CLICK,	//	| MouseButtonEvent	| Input/InputSystem.h	| Left and right click only
 	INPUT_MOUSE_MOVE,	//	| glm::ivec2		| <glm/glm.hpp>			| 
 	GAMEOVER,			//	| GameOverParams	| GameManager.h			| 
+	EVENT_COUNT,		//	|					|						| Not an event, number of events. Keep last.
 };
@@ -63,5 +63,5 @@ void GameManager::GameOver(GameOverParams winner)
 	cat->GetEntity()->SetEnabled(false);
 
 	// notify any interested parties 
-	EventManager::Notify(EventName::GAMEOVER, new TypeParam<GameOverParams>(winner));
+	EventManager::Notify(EventName::GAMEOVER, winner);
 }
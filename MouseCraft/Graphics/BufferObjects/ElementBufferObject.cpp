@@ -18,6 +18,38 @@ void ElementBufferObject::buffer(vector<GLuint>& elements) {
 		static_cast<void*>(&elements[0]),
 		GL_STATIC_DRAW
 	);
+	_capacity = elements.size();
+}
+
+void ElementBufferObject::reserve(size_t count) {
+	if (count <= _capacity) return;
+
+	// binding to GL_ELEMENT_ARRAY_BUFFER would change the bound VAO, use the copy targets
+	GLuint id;
+	glGenBuffers(1, &id);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, id);
+	glBufferData(GL_COPY_WRITE_BUFFER, count * sizeof(GLuint), nullptr, GL_STATIC_DRAW);
+	if (_capacity > 0) {
+		glBindBuffer(GL_COPY_READ_BUFFER, _id);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, _capacity * sizeof(GLuint));
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	glDeleteBuffers(1, &_id);
+	_id = id;
+	_capacity = count;
+}
+
+void ElementBufferObject::bufferSubData(size_t offset, const vector<GLuint>& elements) {
+	if (elements.empty()) return;
+	glBindBuffer(GL_COPY_WRITE_BUFFER, _id);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, offset * sizeof(GLuint), elements.size() * sizeof(GLuint), elements.data());
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+size_t ElementBufferObject::getCapacity() {
+	return _capacity;
 }
 
 GLuint ElementBufferObject::getID() {
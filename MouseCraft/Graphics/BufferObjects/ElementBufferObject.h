@@ -33,6 +33,27 @@ public:
 	/// </summary>
 	/// <param name="elements">The array of vertex indices</param>
 	void buffer(std::vector<GLuint>& elements);
+
+	/// <summary>
+	/// Grow the EBO to hold at least count indices, keeping its contents.
+	/// This replaces the OpenGL buffer so the ID changes and it must be set on the VAO again.
+	/// </summary>
+	/// <param name="count">The number of indices to make room for</param>
+	void reserve(size_t count);
+
+	/// <summary>
+	/// Write vertex indices into part of the EBO without reallocating it.
+	/// The EBO must already be large enough (see reserve).
+	/// </summary>
+	/// <param name="offset">The first index to write to</param>
+	/// <param name="elements">The array of vertex indices</param>
+	void bufferSubData(size_t offset, const std::vector<GLuint>& elements);
+
+	/// <summary>
+	/// Get the number of indices the EBO can hold
+	/// </summary>
+	/// <returns>The capacity in indices</returns>
+	size_t getCapacity();
 	
 	/// <summary>
 	/// Bind the EBO in OpenGL using glBindBuffer
@@ -50,4 +71,9 @@ private:
 	/// The ID used by OpenGL to identify the EBO
 	/// </summary>
 	GLuint _id;
+
+	/// <summary>
+	/// The number of indices allocated in OpenGL
+	/// </summary>
+	size_t _capacity = 0;
 };
\ No newline at end of file
@@ -4,32 +4,52 @@
 
 using std::vector;
 
-FrameBufferObject::FrameBufferObject(int width, int height, vector<GLTexture*>& textures) : _width(width), _height(height) {
+FrameBufferObject::FrameBufferObject(int width, int height, vector<GLTexture*>& textures) :
+	FrameBufferObject(width, height, textures, vector<GLuint>(textures.size(), GL_RGBA16F)) {
+}
+
+FrameBufferObject::FrameBufferObject(int width, int height, vector<GLTexture*>& textures, const vector<GLuint>& formats, GLTexture* depthTexture) :
+	_rbo(0), _width(width), _height(height) {
 	glGenFramebuffers(1, &_id);
 	RenderUtil::checkGLError("glGenFramebuffers");
-	glGenRenderbuffers(1, &_rbo);
 	glBindFramebuffer(GL_FRAMEBUFFER, _id);
-	glBindRenderbuffer(GL_RENDERBUFFER, _rbo);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, _width, _height);
-	glBindRenderbuffer(GL_RENDERBUFFER, 0);
-	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, _rbo);
+	if (depthTexture != nullptr) {
+		// read with texelFetch or at the same resolution, so no filtering
+		glBindTexture(GL_TEXTURE_2D, depthTexture->getID());
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, _width, _height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depthTexture->getID(), 0);
+		RenderUtil::checkGLError("glFrameBufferTexture2D");
+	}
+	else {
+		glGenRenderbuffers(1, &_rbo);
+		glBindRenderbuffer(GL_RENDERBUFFER, _rbo);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, _width, _height);
+		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, _rbo);
+	}
 	if (textures.size() > 0) {
-		attachBuffers(textures);
+		attachBuffers(textures, formats);
 	}
 }
 
 FrameBufferObject::~FrameBufferObject() {
 	glDeleteFramebuffers(1, &_id);
 	RenderUtil::checkGLError("glDeleteFramebuffers");
-	glDeleteRenderbuffers(1, &_rbo);
+	if (_rbo != 0) {
+		glDeleteRenderbuffers(1, &_rbo);
+	}
 }
 
-void FrameBufferObject::attachBuffers(std::vector<GLTexture*>& buffers) {
+void FrameBufferObject::attachBuffers(std::vector<GLTexture*>& buffers, const std::vector<GLuint>& formats) {
 	Image* img = new Image(NULL, _width, _height); // Temp image so we can use GLtextures
 	vector<GLuint> attachments;
 	for (int i = 0; i < buffers.size(); i++) {
 		GLTexture* b = buffers[i];
-		b->setImage(*img, false, GL_RGBA16F, GL_FLOAT);
+		b->setImage(*img, false, formats[i], GL_FLOAT);
 		GLuint attachment = GL_COLOR_ATTACHMENT0 + i;
 		attachments.push_back(attachment);
 		// Calls internal function to attach buffer
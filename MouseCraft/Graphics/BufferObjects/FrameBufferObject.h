@@ -18,6 +18,14 @@ public:
 	/// <param name="height">The height of the FBO</param>
 	/// <param name="textures">The color attachments to put in the FBO</param>
 	FrameBufferObject(int width, int height, std::vector<GLTexture*>& textures);
+
+	/// <summary>
+	/// Initializes the FBO with a storage format per color attachment.
+	/// If a depth texture is given it replaces the depth buffer, so later passes can sample depth.
+	/// </summary>
+	/// <param name="formats">Internal format of each color attachment, ie. GL_RGBA8</param>
+	/// <param name="depthTexture">Texture to store depth and stencil in (GL_DEPTH24_STENCIL8), nullptr for a depth buffer</param>
+	FrameBufferObject(int width, int height, std::vector<GLTexture*>& textures, const std::vector<GLuint>& formats, GLTexture* depthTexture = nullptr);
 	
 	/// <summary>
 	/// Destructs the FBO, destroying it in OpenGL
@@ -60,7 +68,7 @@ private:
 	/// And calls glDrawBuffers accordingly with the attachments
 	/// </summary>
 	/// <param name="buffers"></param>
-	void attachBuffers(std::vector<GLTexture*>& buffers);
+	void attachBuffers(std::vector<GLTexture*>& buffers, const std::vector<GLuint>& formats);
 
 	GLuint _id;
 	GLuint _rbo;
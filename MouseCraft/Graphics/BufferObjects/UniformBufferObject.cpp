@@ -1,6 +1,6 @@
 #include "UniformBufferObject.h"
 
-UniformBufferObject::UniformBufferObject() {
+UniformBufferObject::UniformBufferObject() : _allocated(0) {
 	glGenBuffers(1, &_id);
 }
 
@@ -16,6 +16,31 @@ void UniformBufferObject::unbind(int bindingPoint) {
 	glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, 0);
 }
 
+void UniformBufferObject::bufferData(const void* data, size_t size) {
+	glBindBuffer(GL_UNIFORM_BUFFER, _id);
+	if (_allocated != size) {
+		glBufferData(GL_UNIFORM_BUFFER, size, data, GL_STATIC_DRAW);
+		_allocated = size;
+	}
+	else {
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, size, data);
+	}
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void UniformBufferObject::bindRange(int bindingPoint, size_t offset, size_t size) {
+	glBindBufferRange(GL_UNIFORM_BUFFER, bindingPoint, _id, offset, size);
+}
+
+size_t UniformBufferObject::alignedSize(size_t size) {
+	static GLint alignment = 0;
+	if (alignment == 0) {
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+		if (alignment <= 0) alignment = 256;
+	}
+	return (size + alignment - 1) / alignment * alignment;
+}
+
 GLuint UniformBufferObject::getID() {
 	return _id;
 }
\ No newline at end of file
@@ -10,17 +10,14 @@ public:
 	void unbind(int bindingPoint);
 	template<typename T>
 	void buffer(T& data, int count = 1) {
-		glBindBuffer(GL_UNIFORM_BUFFER, _id);
-		size_t size = sizeof(data) * count;
-		if (_allocated != size) {
-			glBufferData(GL_UNIFORM_BUFFER, size, &data, GL_STATIC_DRAW);
-			_allocated = size;
-		}
-		else {
-			glBufferSubData(GL_UNIFORM_BUFFER, 0, size, &data);
-		}
-		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		bufferData(&data, sizeof(data) * count);
 	}
+	// Uploads size bytes, reallocating only when the size changes.
+	void bufferData(const void* data, size_t size);
+	// Binds part of the buffer, offset must be a multiple of alignedSize(x).
+	void bindRange(int bindingPoint, size_t offset, size_t size);
+	// Rounds size up to something bindRange can use as a stride.
+	static size_t alignedSize(size_t size);
 	GLuint getID();
 private:
 	GLuint _id;
@@ -20,6 +20,14 @@ void VertexArrayObject::setBuffer(int id, VertexBufferObject& vbo, int offset) {
 	_vbos[id] = &vbo;
 }
 
+void VertexArrayObject::setAttribute(int id, VertexBufferObject& vbo, int components, int stride, int offset) {
+	bind();
+	vbo.bind();
+	glEnableVertexAttribArray(id);
+	glVertexAttribPointer(id, components, GL_FLOAT, GL_FALSE, stride, (void *)offset);
+	_vbos[id] = &vbo;
+}
+
 void VertexArrayObject::unsetBuffer(int buffID) {
 	bind();
 	glEnableVertexAttribArray(0);
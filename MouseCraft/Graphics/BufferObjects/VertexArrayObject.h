@@ -9,6 +9,8 @@ public:
 	~VertexArrayObject();
 	GLuint getID();
 	void setBuffer(int id, VertexBufferObject& vbo, int offset = 0);
+	// Reads one attribute out of interleaved vertices, stride and offset in bytes
+	void setAttribute(int id, VertexBufferObject& vbo, int components, int stride, int offset);
 	void unsetBuffer(int id);
 	void setElementBuffer(ElementBufferObject& ebo);
 	void bind();
@@ -2,7 +2,7 @@
 
 using std::vector;
 
-VertexBufferObject::VertexBufferObject(int componentsPerElement) : _componentsPerElement(componentsPerElement) {
+VertexBufferObject::VertexBufferObject(int componentsPerElement) : _componentsPerElement(componentsPerElement), _capacity(0) {
 	glGenBuffers(1, &_id);
 }
 
@@ -22,6 +22,38 @@ void VertexBufferObject::buffer(vector<GLfloat>& values) {
 		static_cast<void*>(&values[0]),
 		GL_STATIC_DRAW
 	);
+	_capacity = values.size();
+}
+
+void VertexBufferObject::reserve(size_t count) {
+	if (count <= _capacity) return;
+
+	// copy targets so whatever VAO is bound doesn't notice
+	GLuint id;
+	glGenBuffers(1, &id);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, id);
+	glBufferData(GL_COPY_WRITE_BUFFER, count * sizeof(GLfloat), nullptr, GL_STATIC_DRAW);
+	if (_capacity > 0) {
+		glBindBuffer(GL_COPY_READ_BUFFER, _id);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, _capacity * sizeof(GLfloat));
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	glDeleteBuffers(1, &_id);
+	_id = id;
+	_capacity = count;
+}
+
+void VertexBufferObject::bufferSubData(size_t offset, const vector<GLfloat>& values) {
+	if (values.empty()) return;
+	glBindBuffer(GL_COPY_WRITE_BUFFER, _id);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, offset * sizeof(GLfloat), values.size() * sizeof(GLfloat), values.data());
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+size_t VertexBufferObject::getCapacity() {
+	return _capacity;
 }
 
 int VertexBufferObject::getComponentsPerElement() {
@@ -8,9 +8,15 @@ public:
 	GLuint getID();
 	int getComponentsPerElement();
 	void buffer(std::vector<GLfloat>& values);
+	// Grows the buffer to hold at least count floats, keeping the contents. Changes the ID.
+	void reserve(size_t count);
+	// Writes values starting at float offset, the buffer must already be large enough.
+	void bufferSubData(size_t offset, const std::vector<GLfloat>& values);
+	size_t getCapacity();
 	void bind();
 	void unbind();
 private:
 	GLuint _id;
 	int _componentsPerElement;
+	size_t _capacity;
 };
\ No newline at end of file
@@ -9,7 +9,7 @@ Camera::~Camera() {
 
 }
 
-Transform Camera::getTransform() {
+const Transform& Camera::getTransform() {
 	return GetEntity()->transform;
 }
 
@@ -5,7 +5,7 @@ class Camera : public Component {
 public:
 	Camera();
 	~Camera();
-	Transform getTransform();
+	const Transform& getTransform();
 	float getFOV();
 	void setFOV(float fov);
 	float getCloseClip();
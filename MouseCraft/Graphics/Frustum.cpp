@@ -0,0 +1,160 @@
+#include "Frustum.h"
+#include "../Util/AffineMath.h"
+
+#if defined(AFFINE_MATH_SSE)
+#include <xmmintrin.h>
+#elif defined(AFFINE_MATH_NEON)
+#include <arm_neon.h>
+#endif
+
+Frustum::Frustum() {
+	for (int i = 0; i < 8; ++i) {
+		_x[i] = _y[i] = _z[i] = 0.0f;
+		_w[i] = 1.0f;
+	}
+}
+
+Frustum::Frustum(const glm::mat4& m) : Frustum() {
+	// Gribb & Hartmann: every plane is the last row plus or minus one of the others
+	const glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+	const glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+	const glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+	const glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+	const glm::vec4 planes[6] = {
+		row3 + row0,	// left
+		row3 - row0,	// right
+		row3 + row1,	// bottom
+		row3 - row1,	// top
+		row3 + row2,	// near
+		row3 - row2		// far
+	};
+
+	for (int i = 0; i < 6; ++i) {
+		// normalized so the sphere test can compare distances
+		float length = glm::length(glm::vec3(planes[i]));
+		glm::vec4 p = (length > 0.0f) ? planes[i] / length : glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		_x[i] = p.x;
+		_y[i] = p.y;
+		_z[i] = p.z;
+		_w[i] = p.w;
+	}
+}
+
+#if defined(AFFINE_MATH_SSE)
+
+AABBTree::Overlap Frustum::test(const glm::vec3& min, const glm::vec3& max) const {
+	// distance of the center to each plane and the box's reach towards it
+	const __m128 cx = _mm_set1_ps((min.x + max.x) * 0.5f);
+	const __m128 cy = _mm_set1_ps((min.y + max.y) * 0.5f);
+	const __m128 cz = _mm_set1_ps((min.z + max.z) * 0.5f);
+	const __m128 ex = _mm_set1_ps((max.x - min.x) * 0.5f);
+	const __m128 ey = _mm_set1_ps((max.y - min.y) * 0.5f);
+	const __m128 ez = _mm_set1_ps((max.z - min.z) * 0.5f);
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	const __m128 zero = _mm_setzero_ps();
+
+	int intersects = 0;
+	for (int i = 0; i < 8; i += 4) {
+		const __m128 nx = _mm_loadu_ps(_x + i);
+		const __m128 ny = _mm_loadu_ps(_y + i);
+		const __m128 nz = _mm_loadu_ps(_z + i);
+		const __m128 w = _mm_loadu_ps(_w + i);
+
+		__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, cx), _mm_mul_ps(ny, cy)), _mm_add_ps(_mm_mul_ps(nz, cz), w));
+		__m128 r = _mm_add_ps(_mm_add_ps(
+			_mm_mul_ps(_mm_andnot_ps(signMask, nx), ex),
+			_mm_mul_ps(_mm_andnot_ps(signMask, ny), ey)),
+			_mm_mul_ps(_mm_andnot_ps(signMask, nz), ez));
+
+		if (_mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(d, r), zero)))
+			return AABBTree::OUTSIDE;
+		intersects |= _mm_movemask_ps(_mm_cmplt_ps(_mm_sub_ps(d, r), zero));
+	}
+	return intersects ? AABBTree::INTERSECTS : AABBTree::INSIDE;
+}
+
+bool Frustum::intersectsSphere(const glm::vec3& center, float radius) const {
+	const __m128 cx = _mm_set1_ps(center.x);
+	const __m128 cy = _mm_set1_ps(center.y);
+	const __m128 cz = _mm_set1_ps(center.z);
+	const __m128 negRadius = _mm_set1_ps(-radius);
+	for (int i = 0; i < 8; i += 4) {
+		__m128 d = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(_x + i), cx), _mm_mul_ps(_mm_loadu_ps(_y + i), cy)),
+			_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(_z + i), cz), _mm_loadu_ps(_w + i)));
+		if (_mm_movemask_ps(_mm_cmplt_ps(d, negRadius)))
+			return false;
+	}
+	return true;
+}
+
+#elif defined(AFFINE_MATH_NEON)
+
+static inline bool anyLane(uint32x4_t mask) {
+	uint32x2_t folded = vorr_u32(vget_low_u32(mask), vget_high_u32(mask));
+	return (vget_lane_u32(folded, 0) | vget_lane_u32(folded, 1)) != 0;
+}
+
+AABBTree::Overlap Frustum::test(const glm::vec3& min, const glm::vec3& max) const {
+	const float32x4_t cx = vdupq_n_f32((min.x + max.x) * 0.5f);
+	const float32x4_t cy = vdupq_n_f32((min.y + max.y) * 0.5f);
+	const float32x4_t cz = vdupq_n_f32((min.z + max.z) * 0.5f);
+	const float32x4_t ex = vdupq_n_f32((max.x - min.x) * 0.5f);
+	const float32x4_t ey = vdupq_n_f32((max.y - min.y) * 0.5f);
+	const float32x4_t ez = vdupq_n_f32((max.z - min.z) * 0.5f);
+	const float32x4_t zero = vdupq_n_f32(0.0f);
+
+	bool intersects = false;
+	for (int i = 0; i < 8; i += 4) {
+		const float32x4_t nx = vld1q_f32(_x + i);
+		const float32x4_t ny = vld1q_f32(_y + i);
+		const float32x4_t nz = vld1q_f32(_z + i);
+
+		float32x4_t d = vmlaq_f32(vmlaq_f32(vmlaq_f32(vld1q_f32(_w + i), nx, cx), ny, cy), nz, cz);
+		float32x4_t r = vmlaq_f32(vmlaq_f32(vmulq_f32(vabsq_f32(nx), ex), vabsq_f32(ny), ey), vabsq_f32(nz), ez);
+
+		if (anyLane(vcltq_f32(vaddq_f32(d, r), zero)))
+			return AABBTree::OUTSIDE;
+		intersects = intersects || anyLane(vcltq_f32(vsubq_f32(d, r), zero));
+	}
+	return intersects ? AABBTree::INTERSECTS : AABBTree::INSIDE;
+}
+
+bool Frustum::intersectsSphere(const glm::vec3& center, float radius) const {
+	const float32x4_t cx = vdupq_n_f32(center.x);
+	const float32x4_t cy = vdupq_n_f32(center.y);
+	const float32x4_t cz = vdupq_n_f32(center.z);
+	const float32x4_t negRadius = vdupq_n_f32(-radius);
+	for (int i = 0; i < 8; i += 4) {
+		float32x4_t d = vmlaq_f32(vmlaq_f32(vmlaq_f32(vld1q_f32(_w + i), vld1q_f32(_x + i), cx), vld1q_f32(_y + i), cy), vld1q_f32(_z + i), cz);
+		if (anyLane(vcltq_f32(d, negRadius)))
+			return false;
+	}
+	return true;
+}
+
+#else
+
+AABBTree::Overlap Frustum::test(const glm::vec3& min, const glm::vec3& max) const {
+	const glm::vec3 c = (min + max) * 0.5f;
+	const glm::vec3 e = (max - min) * 0.5f;
+	bool intersects = false;
+	for (int i = 0; i < 6; ++i) {
+		float d = _x[i] * c.x + _y[i] * c.y + _z[i] * c.z + _w[i];
+		float r = glm::abs(_x[i]) * e.x + glm::abs(_y[i]) * e.y + glm::abs(_z[i]) * e.z;
+		if (d + r < 0.0f)
+			return AABBTree::OUTSIDE;
+		intersects = intersects || (d - r < 0.0f);
+	}
+	return intersects ? AABBTree::INTERSECTS : AABBTree::INSIDE;
+}
+
+bool Frustum::intersectsSphere(const glm::vec3& center, float radius) const {
+	for (int i = 0; i < 6; ++i) {
+		if (_x[i] * center.x + _y[i] * center.y + _z[i] * center.z + _w[i] < -radius)
+			return false;
+	}
+	return true;
+}
+
+#endif
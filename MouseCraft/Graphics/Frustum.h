@@ -0,0 +1,37 @@
+#pragma once
+#include <glm/glm.hpp>
+#include "../Util/AABBTree.h"
+
+/// <summary>
+/// The six planes of a camera's view volume, used to skip objects the camera can't see.
+/// Planes are kept as a structure of arrays so boxes are tested against four planes at a time
+/// with SSE or NEON (same detection as AffineMath), scalar code otherwise.
+/// </summary>
+class Frustum {
+public:
+	/// <summary>
+	/// A frustum that contains everything
+	/// </summary>
+	Frustum();
+
+	/// <summary>
+	/// Extract the planes of a projection * view matrix, in world space.
+	/// </summary>
+	explicit Frustum(const glm::mat4& viewProjection);
+
+	/// <summary>
+	/// Test a world space box. Fits AABBTree::Query, so whole subtrees can be skipped or accepted.
+	/// </summary>
+	AABBTree::Overlap test(const glm::vec3& min, const glm::vec3& max) const;
+
+	/// <summary>
+	/// Returns false if the sphere is completely outside
+	/// </summary>
+	bool intersectsSphere(const glm::vec3& center, float radius) const;
+private:
+	// 6 planes padded to 8 with planes everything is in front of; normals point inside
+	float _x[8];
+	float _y[8];
+	float _z[8];
+	float _w[8];
+};
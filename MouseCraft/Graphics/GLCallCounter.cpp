@@ -0,0 +1,107 @@
+#include "GLCallCounter.h"
+#include "../GL/glad.h"
+
+static uint64_t _calls = 0;
+static bool _installed = false;
+
+// one of these per wrapped function, N keeps their statics apart
+template<int N, typename R, typename... A>
+struct CountedCall {
+	static R(APIENTRYP original)(A...);
+	static R(APIENTRYP* target)(A...);
+
+	static R APIENTRY call(A... args) {
+		++_calls;
+		if (original) return original(args...);
+		return R();
+	}
+
+	static void install(R(APIENTRYP& pointer)(A...)) {
+		if (pointer == &call) return;
+		target = &pointer;
+		original = pointer;
+		pointer = &call;
+	}
+
+	static void uninstall() {
+		if (target) *target = original;
+	}
+};
+
+template<int N, typename R, typename... A>
+R(APIENTRYP CountedCall<N, R, A...>::original)(A...) = nullptr;
+
+template<int N, typename R, typename... A>
+R(APIENTRYP* CountedCall<N, R, A...>::target)(A...) = nullptr;
+
+template<int N, typename R, typename... A>
+static void wrap(R(APIENTRYP& pointer)(A...), bool install) {
+	if (install) CountedCall<N, R, A...>::install(pointer);
+	else CountedCall<N, R, A...>::uninstall();
+}
+
+#define COUNT_GL(function) wrap<__COUNTER__>(glad_##function, install)
+
+static void wrapAll(bool install) {
+	// state
+	COUNT_GL(glUseProgram);
+	COUNT_GL(glBindVertexArray);
+	COUNT_GL(glBindFramebuffer);
+	COUNT_GL(glActiveTexture);
+	COUNT_GL(glBindTexture);
+	COUNT_GL(glEnable);
+	COUNT_GL(glDisable);
+	COUNT_GL(glBlendFunc);
+	COUNT_GL(glCullFace);
+	COUNT_GL(glClear);
+	// buffers and vertex layout
+	COUNT_GL(glBindBuffer);
+	COUNT_GL(glBindBufferBase);
+	COUNT_GL(glBindBufferRange);
+	COUNT_GL(glBufferData);
+	COUNT_GL(glBufferSubData);
+	COUNT_GL(glEnableVertexAttribArray);
+	COUNT_GL(glVertexAttribPointer);
+	COUNT_GL(glVertexAttribIPointer);
+	COUNT_GL(glVertexAttribDivisor);
+	// uniforms
+	COUNT_GL(glGetUniformLocation);
+	COUNT_GL(glGetUniformBlockIndex);
+	COUNT_GL(glUniformBlockBinding);
+	COUNT_GL(glUniform1i);
+	COUNT_GL(glUniform1f);
+	COUNT_GL(glUniform2f);
+	COUNT_GL(glUniform3f);
+	COUNT_GL(glUniform4f);
+	COUNT_GL(glUniformMatrix4fv);
+	// draws
+	COUNT_GL(glDrawElements);
+	COUNT_GL(glDrawElementsBaseVertex);
+	COUNT_GL(glDrawElementsInstancedBaseVertex);
+	COUNT_GL(glDrawElementsInstancedBaseVertexBaseInstance);
+	COUNT_GL(glMultiDrawElementsIndirect);
+}
+
+void GLCallCounter::install() {
+	if (_installed) return;
+	wrapAll(true);
+	_installed = true;
+}
+
+void GLCallCounter::uninstall() {
+	if (!_installed) return;
+	wrapAll(false);
+	_installed = false;
+}
+
+bool GLCallCounter::isInstalled() {
+	return _installed;
+}
+
+uint64_t GLCallCounter::getCount() {
+	return _calls;
+}
+
+void GLCallCounter::reset() {
+	_calls = 0;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+
+/// <summary>
+/// Counts the OpenGL calls the renderer makes by swapping glad's function pointers
+/// for counting wrappers. Only meant for benchmarks and debugging, wrapping every call
+/// costs a little. Without a context the wrapped calls are counted but do nothing.
+/// Covers state, buffer, uniform and draw calls (the ones that scale with objects).
+/// </summary>
+class GLCallCounter {
+public:
+	/// <summary>
+	/// Start counting. Must be called after glad loaded the functions.
+	/// </summary>
+	static void install();
+
+	/// <summary>
+	/// Put glad's function pointers back.
+	/// </summary>
+	static void uninstall();
+
+	static bool isInstalled();
+
+	/// <summary>
+	/// Number of calls since the last reset
+	/// </summary>
+	static uint64_t getCount();
+
+	static void reset();
+};
@@ -1,12 +1,17 @@
 #include "GLTextureArray.h"
 #include "RenderUtil.h"
 GLTextureArray::GLTextureArray(int width, int height, int layers, int mipmapLevels, GLuint storageFormat)
-: _width(width), _height(height), _layers(layers), _mipmaps(mipmapLevels) {
-	glGenTextures(1, &_id);
-	glBindTexture(GL_TEXTURE_2D_ARRAY, _id);
-	glTexStorage3D(GL_TEXTURE_2D_ARRAY, _mipmaps, storageFormat, _width, _height, _layers);
+: _format(storageFormat), _width(width), _height(height), _layers(layers), _mipmaps(mipmapLevels) {
+	_id = allocate(_layers);
+}
+
+GLuint GLTextureArray::allocate(int layers) {
+	GLuint id;
+	glGenTextures(1, &id);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, id);
+	glTexStorage3D(GL_TEXTURE_2D_ARRAY, _mipmaps, _format, _width, _height, layers);
 	RenderUtil::checkGLError("glTexStorage3D");
-	if (mipmapLevels == 1) {
+	if (_mipmaps == 1) {
 		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	}
@@ -14,6 +19,39 @@ GLTextureArray::GLTextureArray(int width, int height, int layers, int mipmapLeve
 		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	}
+	return id;
+}
+
+void GLTextureArray::setLayers(int layers) {
+	GLuint id = allocate(layers);
+	const int copied = (layers < _layers) ? layers : _layers;
+
+	// read every level of the old texture into a pixel buffer and upload it from there,
+	// raw bytes so sRGB values aren't converted on the way
+	GLuint buffer;
+	glGenBuffers(1, &buffer);
+	for (int level = 0; level < _mipmaps && copied > 0; ++level) {
+		int width = (_width >> level) > 0 ? (_width >> level) : 1;
+		int height = (_height >> level) > 0 ? (_height >> level) : 1;
+		size_t layerSize = (size_t)width * height * 4;
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+		glBufferData(GL_PIXEL_PACK_BUFFER, layerSize * _layers, nullptr, GL_STREAM_COPY);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, _id);
+		glGetTexImage(GL_TEXTURE_2D_ARRAY, level, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, id);
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, 0, width, height, copied, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+	glDeleteBuffers(1, &buffer);
+	RenderUtil::checkGLError("GLTextureArray::setLayers");
+
+	glDeleteTextures(1, &_id);
+	_id = id;
+	_layers = layers;
 }
 
 GLTextureArray::~GLTextureArray() {
@@ -42,18 +80,23 @@ void GLTextureArray::setImage(int layer, Image& image, GLuint inputType) {
 	if (!inputFormat) {
 		throw "Invalid number of channels in image";
 	}
+	setImageLevel(layer, 0, 0, 0, image.getWidth(), image.getHeight(), inputFormat, inputType, image.getData());
+}
+
+void GLTextureArray::setImageLevel(int layer, int level, int x, int y, int width, int height, GLenum format, GLenum type, const void* data) {
+	glBindTexture(GL_TEXTURE_2D_ARRAY, _id);
 	glTexSubImage3D(
 		GL_TEXTURE_2D_ARRAY,
-		0,
-		0,
-		0,
+		level,
+		x,
+		y,
 		layer,
-		image.getWidth(),
-		image.getHeight(),
+		width,
+		height,
 		1,
-		inputFormat,
-		inputType,
-		image.getData()
+		format,
+		type,
+		data
 	);
 	RenderUtil::checkGLError("glTexSubImage3D");
 }
@@ -87,6 +130,10 @@ int GLTextureArray::getLayers() {
 	return _layers;
 }
 
+int GLTextureArray::getMipmapLevels() {
+	return _mipmaps;
+}
+
 GLuint GLTextureArray::getID() {
 	return _id;
 }
\ No newline at end of file
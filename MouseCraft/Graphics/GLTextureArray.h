@@ -11,14 +11,22 @@ public:
 		Image& image,
 		GLuint inputType = GL_FLOAT
 	);
+	// Upload part of one mip level of a layer. data can be an offset into the bound GL_PIXEL_UNPACK_BUFFER.
+	void setImageLevel(int layer, int level, int x, int y, int width, int height, GLenum format, GLenum type, const void* data);
+	// Change the number of layers. The layers both sizes have keep their contents, the copy stays on the GPU.
+	void setLayers(int layers);
 	void bind(GLenum slot);
 	void unbind(GLenum slot);
 	void genMipmaps();
 	int getWidth();
 	int getHeight();
 	int getLayers();
+	int getMipmapLevels();
 private:
+	GLuint allocate(int layers);
+
 	GLuint _id;
+	GLuint _format;
 	int _layers;
 	int _width;
 	int _height;
@@ -0,0 +1,55 @@
+#include "Geometry.h"
+#include <cmath>
+#include <algorithm>
+
+// positions are snapped to this grid, vertices in the same cell share a smooth normal
+#define SMOOTH_NORMAL_GRID 100.0f
+
+void Geometry::computeSmoothNormals() const {
+	const size_t count = std::min(_vertexData.size(), _normalData.size()) / 3;
+	_smoothNormalData.assign(_normalData.begin(), _normalData.begin() + count * 3);
+	if (count == 0) {
+		return;
+	}
+
+	// open addressing hash grid, at most half full
+	struct Cell {
+		glm::ivec3 key;
+		glm::vec3 normal;
+		bool used;
+	};
+	size_t capacity = 16;
+	while (capacity < count * 2) {
+		capacity <<= 1;
+	}
+	std::vector<Cell> cells(capacity, Cell{ glm::ivec3(0), glm::vec3(0.0f), false });
+	std::vector<size_t> cellOf(count);
+
+	for (size_t v = 0; v < count; ++v) {
+		const GLfloat* p = &_vertexData[v * 3];
+		glm::ivec3 key(
+			(int)std::round(p[0] * SMOOTH_NORMAL_GRID),
+			(int)std::round(p[1] * SMOOTH_NORMAL_GRID),
+			(int)std::round(p[2] * SMOOTH_NORMAL_GRID));
+		size_t h = ((size_t)key.x * 73856093u ^ (size_t)key.y * 19349663u ^ (size_t)key.z * 83492791u) & (capacity - 1);
+		while (cells[h].used && cells[h].key != key) {
+			h = (h + 1) & (capacity - 1);
+		}
+		cells[h].used = true;
+		cells[h].key = key;
+		cells[h].normal += glm::vec3(_normalData[v * 3], _normalData[v * 3 + 1], _normalData[v * 3 + 2]);
+		cellOf[v] = h;
+	}
+
+	for (size_t v = 0; v < count; ++v) {
+		const glm::vec3& sum = cells[cellOf[v]].normal;
+		float length = glm::length(sum);
+		// opposite normals cancel out, keep the flat one then
+		if (length > 0.0001f) {
+			glm::vec3 n = sum / length;
+			_smoothNormalData[v * 3] = n.x;
+			_smoothNormalData[v * 3 + 1] = n.y;
+			_smoothNormalData[v * 3 + 2] = n.z;
+		}
+	}
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include "../GL/glad.h"
+#include <glm/glm.hpp>
 #include <vector>
 
 /// <summary>
@@ -27,7 +28,19 @@ public:
 	/// Set the vertex data of the shape
 	/// </summary>
 	/// <param name="vertexData">The vertex data as an array of GLfloats (3 per coodinate)</param>
-	void setVertexData(std::vector<GLfloat>& vertexData) { _vertexData = vertexData; }
+	void setVertexData(std::vector<GLfloat>& vertexData) { _vertexData = vertexData; computeBounds(); _smoothNormalsDirty = true; }
+
+	/// <summary>
+	/// Get the corner of the bounding box with the smallest coordinates
+	/// </summary>
+	/// <returns>The minimum of every vertex, in model space</returns>
+	const glm::vec3& getBoundsMin() const { return _boundsMin; }
+
+	/// <summary>
+	/// Get the corner of the bounding box with the largest coordinates
+	/// </summary>
+	/// <returns>The maximum of every vertex, in model space</returns>
+	const glm::vec3& getBoundsMax() const { return _boundsMax; }
 
 	/// <summary>
 	/// Get the normal data of the shape
@@ -39,7 +52,21 @@ public:
 	/// Set the normal data of the shape
 	/// </summary>
 	/// <param name="normalData">The normal data as an array of GLfloats (3 per coordinate)</param>
-	void setNormalData(std::vector<GLfloat>& normalData) { _normalData = normalData; }
+	void setNormalData(std::vector<GLfloat>& normalData) { _normalData = normalData; _smoothNormalsDirty = true; }
+
+	/// <summary>
+	/// Get the smooth normals of the shape. Every vertex sharing a position gets the average of their normals,
+	/// so extruding along them (ie. outlines) leaves no gaps at hard edges.
+	/// Computed on the first call after the vertex or normal data was set.
+	/// </summary>
+	/// <returns>The smooth normal data as an array of GLfloats (3 per coordinate)</returns>
+	const std::vector<GLfloat>& getSmoothNormalData() const {
+		if (_smoothNormalsDirty) {
+			computeSmoothNormals();
+			_smoothNormalsDirty = false;
+		}
+		return _smoothNormalData;
+	}
 
 	/// <summary>
 	/// Get the texture coordinate data of the shape
@@ -65,6 +92,27 @@ public:
 	/// <param name="indices">The face indices as an array of GLuints (3 per triangle)</param>
 	void setIndices(std::vector<GLuint>& indices) { _indices = indices; }
 private:
+	/// <summary>
+	/// Fit the bounding box around the vertex data. Done whenever the vertex data is set (at load time).
+	/// </summary>
+	void computeBounds() {
+		if (_vertexData.size() < 3) {
+			_boundsMin = _boundsMax = glm::vec3(0.0f);
+			return;
+		}
+		_boundsMin = _boundsMax = glm::vec3(_vertexData[0], _vertexData[1], _vertexData[2]);
+		for (size_t i = 3; i + 2 < _vertexData.size(); i += 3) {
+			glm::vec3 v(_vertexData[i], _vertexData[i + 1], _vertexData[i + 2]);
+			_boundsMin = glm::min(_boundsMin, v);
+			_boundsMax = glm::max(_boundsMax, v);
+		}
+	}
+
+	/// <summary>
+	/// Average the normals of vertices at the same position. Done once both the vertex and normal data are set.
+	/// </summary>
+	void computeSmoothNormals() const;
+
 	/// <summary>
 	/// An array of vertex data. Each vertex is stored across 3 indices in the array.
 	/// </summary>
@@ -75,6 +123,12 @@ private:
 	/// </summary>
 	std::vector<GLfloat> _normalData;
 
+	/// <summary>
+	/// An array of smooth normal data, lined up with the normal data.
+	/// </summary>
+	mutable std::vector<GLfloat> _smoothNormalData;
+	mutable bool _smoothNormalsDirty = false;
+
 	/// <summary>
 	/// An array of texture coordinate data. Each texture coordinate is stored across 2 indices in the array.
 	/// </summary>
@@ -84,5 +138,11 @@ private:
 	/// The indices which define the triangles in the model. Each triangle face is 3 indices.
 	/// </summary>
 	std::vector<GLuint> _indices;
+
+	/// <summary>
+	/// Model space bounding box of the vertex data.
+	/// </summary>
+	glm::vec3 _boundsMin = glm::vec3(0.0f);
+	glm::vec3 _boundsMax = glm::vec3(0.0f);
 };
 
@@ -0,0 +1,165 @@
+#include "InstanceBatcher.h"
+#include <algorithm>
+#include <cstddef>
+
+#define INDEX_BITS 24
+#define MATERIAL_BITS 16
+
+InstanceBatcher::InstanceBatcher() :
+	_instanceCapacity(0), _commandCapacity(0), _drawCount(0) {
+	glGenBuffers(1, &_instanceBuffer);
+	glGenBuffers(1, &_indirectBuffer);
+	_multiDrawIndirect = supportsMultiDrawIndirect();
+}
+
+InstanceBatcher::~InstanceBatcher() {
+	glDeleteBuffers(1, &_instanceBuffer);
+	glDeleteBuffers(1, &_indirectBuffer);
+}
+
+void InstanceBatcher::clear() {
+	_keys.clear();
+	_instances.clear();
+}
+
+InstanceBatcher::Instance& InstanceBatcher::add(unsigned int mesh, unsigned int material) {
+	uint64_t index = _instances.size();
+	uint64_t key = ((uint64_t)mesh << (MATERIAL_BITS + INDEX_BITS))
+		| ((uint64_t)(material & ((1 << MATERIAL_BITS) - 1)) << INDEX_BITS)
+		| index;
+	_keys.push_back(key);
+	_instances.emplace_back();
+	return _instances.back();
+}
+
+void InstanceBatcher::draw(MeshRegistry& meshes) {
+	_drawCount = 0;
+	if (_instances.empty()) {
+		return;
+	}
+
+	buildCommands(meshes);
+	upload();
+
+	meshes.bind();
+	if (_multiDrawIndirect) {
+		setInstanceAttributes(0);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, _indirectBuffer);
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, (GLsizei)_commands.size(), 0);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		_drawCount = 1;
+		return;
+	}
+
+	// base instance offsets the instanced attributes for us, otherwise point them at each batch
+	bool baseInstance = GLAD_GL_ARB_base_instance != 0;
+	if (baseInstance) {
+		setInstanceAttributes(0);
+	}
+	for (const DrawCommand& c : _commands) {
+		if (baseInstance) {
+			glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, c.count, GL_UNSIGNED_INT,
+				(void *)(c.firstIndex * sizeof(GLuint)), c.instanceCount, c.baseVertex, c.baseInstance);
+		}
+		else {
+			setInstanceAttributes(c.baseInstance);
+			glDrawElementsInstancedBaseVertex(GL_TRIANGLES, c.count, GL_UNSIGNED_INT,
+				(void *)(c.firstIndex * sizeof(GLuint)), c.instanceCount, c.baseVertex);
+		}
+	}
+	_drawCount = _commands.size();
+}
+
+size_t InstanceBatcher::getDrawCount() const {
+	return _drawCount;
+}
+
+size_t InstanceBatcher::getInstanceCount() const {
+	return _instances.size();
+}
+
+bool InstanceBatcher::supportsMultiDrawIndirect() {
+	// base instance is needed so every command reads its own range of the instance buffer
+	return GLAD_GL_ARB_multi_draw_indirect && GLAD_GL_ARB_base_instance && GLAD_GL_ARB_draw_indirect;
+}
+
+void InstanceBatcher::buildCommands(MeshRegistry& meshes) {
+	// the RenderSystem hands over lists already sorted by mesh and material
+	if (!std::is_sorted(_keys.begin(), _keys.end())) {
+		std::sort(_keys.begin(), _keys.end());
+	}
+
+	_sorted.resize(_instances.size());
+	_commands.clear();
+	const uint64_t indexMask = ((uint64_t)1 << INDEX_BITS) - 1;
+	for (size_t i = 0; i < _keys.size(); ++i) {
+		_sorted[i] = _instances[_keys[i] & indexMask];
+
+		unsigned int mesh = (unsigned int)(_keys[i] >> (MATERIAL_BITS + INDEX_BITS));
+		if (i > 0 && (_keys[i - 1] >> (MATERIAL_BITS + INDEX_BITS)) == mesh) {
+			_commands.back().instanceCount++;
+			continue;
+		}
+
+		const MeshInfo& info = meshes.getInfo(mesh);
+		DrawCommand c;
+		c.count = info.indexCount;
+		c.instanceCount = 1;
+		c.firstIndex = info.firstIndex;
+		c.baseVertex = info.baseVertex;
+		c.baseInstance = (GLuint)i;
+		_commands.push_back(c);
+	}
+}
+
+void InstanceBatcher::upload() {
+	// orphan the old storage so the driver doesn't wait on last frame's draws
+	glBindBuffer(GL_ARRAY_BUFFER, _instanceBuffer);
+	_instanceCapacity = std::max(_instanceCapacity, _sorted.size());
+	glBufferData(GL_ARRAY_BUFFER, _instanceCapacity * sizeof(Instance), nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, _sorted.size() * sizeof(Instance), _sorted.data());
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	if (_multiDrawIndirect) {
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, _indirectBuffer);
+		_commandCapacity = std::max(_commandCapacity, _commands.size());
+		glBufferData(GL_DRAW_INDIRECT_BUFFER, _commandCapacity * sizeof(DrawCommand), nullptr, GL_STREAM_DRAW);
+		glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, _commands.size() * sizeof(DrawCommand), _commands.data());
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	}
+}
+
+void InstanceBatcher::setInstanceAttributes(size_t firstInstance) {
+	const GLsizei stride = sizeof(Instance);
+	const size_t base = firstInstance * sizeof(Instance);
+
+	// mat4 and the normal matrix take one location per column
+	struct Attribute { int components; size_t offset; bool integer; };
+	const Attribute attributes[] = {
+		{ 4, offsetof(Instance, modelView), false },
+		{ 4, offsetof(Instance, modelView) + sizeof(glm::vec4), false },
+		{ 4, offsetof(Instance, modelView) + sizeof(glm::vec4) * 2, false },
+		{ 4, offsetof(Instance, modelView) + sizeof(glm::vec4) * 3, false },
+		{ 3, offsetof(Instance, normalMatrix), false },
+		{ 3, offsetof(Instance, normalMatrix) + sizeof(glm::vec4), false },
+		{ 3, offsetof(Instance, normalMatrix) + sizeof(glm::vec4) * 2, false },
+		{ 4, offsetof(Instance, color), false },
+		{ 1, offsetof(Instance, material), true },
+	};
+
+	glBindBuffer(GL_ARRAY_BUFFER, _instanceBuffer);
+	for (int i = 0; i < 9; ++i) {
+		GLuint location = INSTANCE_LOCATION + i;
+		glEnableVertexAttribArray(location);
+		if (attributes[i].integer) {
+			glVertexAttribIPointer(location, attributes[i].components, GL_UNSIGNED_INT, stride,
+				(void *)(base + attributes[i].offset));
+		}
+		else {
+			glVertexAttribPointer(location, attributes[i].components, GL_FLOAT, GL_FALSE, stride,
+				(void *)(base + attributes[i].offset));
+		}
+		glVertexAttribDivisor(location, 1);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
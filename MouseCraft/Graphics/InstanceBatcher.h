@@ -0,0 +1,93 @@
+#pragma once
+#include "../GL/glad.h"
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+#include "MeshRegistry.h"
+
+/// <summary>
+/// Collects the objects of a pass and draws every object sharing a mesh with one instanced draw.
+/// Instances are sorted by mesh then material, written to an instanced attribute buffer and
+/// submitted with glMultiDrawElementsIndirect when the driver has it (one call for the pass),
+/// otherwise with one glDrawElementsInstancedBaseVertex per mesh.
+///
+/// Per instance attributes start at INSTANCE_LOCATION:
+///		+0..3 model view matrix columns
+///		+4..6 normal matrix columns
+///		+7    color
+///		+8    material ID (integer, indexes the Materials uniform block)
+/// </summary>
+class InstanceBatcher {
+public:
+	static const int INSTANCE_LOCATION = 4;	// after the MeshRegistry attributes
+
+	struct Instance {
+		glm::mat4 modelView;
+		glm::vec4 normalMatrix[3];
+		glm::vec4 color;
+		GLuint material;
+	};
+
+	InstanceBatcher();
+	~InstanceBatcher();
+
+	/// <summary>
+	/// Forget the instances of the last frame, keeps the memory.
+	/// </summary>
+	void clear();
+
+	/// <summary>
+	/// Queue an instance of a mesh. The returned instance must be filled in before the next add.
+	/// </summary>
+	/// <param name="mesh">Mesh ID from the MeshRegistry</param>
+	/// <param name="material">Material used to order instances of the same mesh</param>
+	Instance& add(unsigned int mesh, unsigned int material);
+
+	/// <summary>
+	/// Sort, upload and draw everything queued with the bound shader.
+	/// Binds the registry's VAO.
+	/// </summary>
+	void draw(MeshRegistry& meshes);
+
+	/// <summary>
+	/// Number of draw calls the last draw issued
+	/// </summary>
+	size_t getDrawCount() const;
+
+	/// <summary>
+	/// Number of instances the last draw submitted
+	/// </summary>
+	size_t getInstanceCount() const;
+
+	/// <summary>
+	/// Returns true if the driver can draw a pass with one glMultiDrawElementsIndirect.
+	/// </summary>
+	static bool supportsMultiDrawIndirect();
+private:
+	// layout defined by glMultiDrawElementsIndirect
+	struct DrawCommand {
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+
+	void buildCommands(MeshRegistry& meshes);
+	void upload();
+	void setInstanceAttributes(size_t firstInstance);
+
+	// key: mesh (24 bits) | material (16 bits) | instance index (24 bits)
+	std::vector<uint64_t> _keys;
+	std::vector<Instance> _instances;
+	std::vector<Instance> _sorted;
+	std::vector<DrawCommand> _commands;
+
+	GLuint _instanceBuffer;
+	GLuint _indirectBuffer;
+	size_t _instanceCapacity;
+	size_t _commandCapacity;
+	bool _multiDrawIndirect;
+
+	size_t _drawCount;
+};
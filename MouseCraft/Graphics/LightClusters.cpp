@@ -0,0 +1,173 @@
+#include "LightClusters.h"
+#include <algorithm>
+#include <cmath>
+
+LightClusters::LightClusters() : _sliceScaleBias(0.0f) {
+	static const GLenum formats[BUFFER_COUNT] = { GL_RGBA32F, GL_RG32UI, GL_R32UI };
+
+	glGenBuffers(BUFFER_COUNT, _buffers);
+	glGenTextures(BUFFER_COUNT, _textures);
+	for (int i = 0; i < BUFFER_COUNT; ++i) {
+		// the texture keeps pointing at the buffer when its storage is replaced
+		uploadBuffer(_buffers[i], nullptr, 0);
+		glBindTexture(GL_TEXTURE_BUFFER, _textures[i]);
+		glTexBuffer(GL_TEXTURE_BUFFER, formats[i], _buffers[i]);
+	}
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+	_clusters.resize(CLUSTER_COUNT);
+}
+
+LightClusters::~LightClusters() {
+	glDeleteTextures(BUFFER_COUNT, _textures);
+	glDeleteBuffers(BUFFER_COUNT, _buffers);
+}
+
+void LightClusters::clear() {
+	_directional.clear();
+	_point.clear();
+}
+
+void LightClusters::addLight(const LightData& light) {
+	if (light.attenuation.w == 0.0f) {
+		_directional.push_back(light);
+	}
+	else {
+		_point.push_back(light);
+	}
+}
+
+void LightClusters::build(const glm::mat4& projection, float closeClip, float farClip) {
+	_lights.clear();
+	_lights.insert(_lights.end(), _directional.begin(), _directional.end());
+	_lights.insert(_lights.end(), _point.begin(), _point.end());
+	_indices.clear();
+	std::fill(_clusters.begin(), _clusters.end(), glm::uvec2(0));
+
+	// exponential slices: slice = log(depth / closeClip) / log(farClip / closeClip) * SLICES
+	closeClip = std::max(closeClip, 0.0001f);
+	farClip = std::max(farClip, closeClip * 1.01f);
+	const float scale = SLICES / std::log(farClip / closeClip);
+	_sliceScaleBias = glm::vec2(scale, -std::log(closeClip) * scale);
+	auto sliceOf = [this](float depth) {
+		int slice = (int)std::floor(std::log(depth) * _sliceScaleBias.x + _sliceScaleBias.y);
+		return std::min(std::max(slice, 0), SLICES - 1);
+	};
+	auto tileOf = [](float ndc, int tiles) {
+		int tile = (int)std::floor((ndc + 1.0f) * 0.5f * tiles);
+		return std::min(std::max(tile, 0), tiles - 1);
+	};
+
+	// find the clusters every point light touches and count them
+	_rangeMin.clear();
+	_rangeMax.clear();
+	for (const LightData& light : _point) {
+		const glm::vec3 center(light.position);
+		const float radius = light.position.w;
+		const float nearest = -center.z - radius;
+		const float farthest = -center.z + radius;
+		// lights that reach nothing (or a broken radius, log(NaN) isn't a slice) touch no cluster
+		if (!(radius > 0.0f) || farthest < closeClip || nearest > farClip) {
+			_rangeMin.push_back(glm::ivec3(0));
+			_rangeMax.push_back(glm::ivec3(-1));
+			continue;
+		}
+
+		glm::ivec3 lo(0, 0, sliceOf(std::max(nearest, closeClip)));
+		glm::ivec3 hi(TILES_X - 1, TILES_Y - 1, sliceOf(std::min(farthest, farClip)));
+
+		// spheres reaching behind the near plane can cover any tile, otherwise project the
+		// corners of the sphere's box at its nearest and farthest depth
+		if (nearest > closeClip) {
+			glm::vec2 ndcMin(1.0f), ndcMax(-1.0f);
+			for (int corner = 0; corner < 8; ++corner) {
+				glm::vec4 p(
+					center.x + ((corner & 1) ? radius : -radius),
+					center.y + ((corner & 2) ? radius : -radius),
+					(corner & 4) ? -nearest : -farthest,
+					1.0f);
+				glm::vec4 clip = projection * p;
+				glm::vec2 ndc = glm::vec2(clip) / clip.w;
+				ndcMin = glm::min(ndcMin, ndc);
+				ndcMax = glm::max(ndcMax, ndc);
+			}
+			if (ndcMax.x < -1.0f || ndcMax.y < -1.0f || ndcMin.x > 1.0f || ndcMin.y > 1.0f) {
+				_rangeMin.push_back(glm::ivec3(0));
+				_rangeMax.push_back(glm::ivec3(-1));
+				continue;
+			}
+			lo.x = tileOf(ndcMin.x, TILES_X);
+			lo.y = tileOf(ndcMin.y, TILES_Y);
+			hi.x = tileOf(ndcMax.x, TILES_X);
+			hi.y = tileOf(ndcMax.y, TILES_Y);
+		}
+
+		_rangeMin.push_back(lo);
+		_rangeMax.push_back(hi);
+		for (int z = lo.z; z <= hi.z; ++z)
+			for (int y = lo.y; y <= hi.y; ++y)
+				for (int x = lo.x; x <= hi.x; ++x)
+					_clusters[(z * TILES_Y + y) * TILES_X + x].y++;
+	}
+
+	// counts to offsets, then fill the index list cluster by cluster
+	uint32_t offset = 0;
+	for (glm::uvec2& cluster : _clusters) {
+		cluster.x = offset;
+		offset += cluster.y;
+		cluster.y = 0;
+	}
+	_indices.resize(offset);
+	const uint32_t firstPoint = (uint32_t)_directional.size();
+	for (size_t i = 0; i < _point.size(); ++i) {
+		const glm::ivec3& lo = _rangeMin[i];
+		const glm::ivec3& hi = _rangeMax[i];
+		for (int z = lo.z; z <= hi.z; ++z)
+			for (int y = lo.y; y <= hi.y; ++y)
+				for (int x = lo.x; x <= hi.x; ++x) {
+					glm::uvec2& cluster = _clusters[(z * TILES_Y + y) * TILES_X + x];
+					_indices[cluster.x + cluster.y++] = firstPoint + (uint32_t)i;
+				}
+	}
+}
+
+void LightClusters::upload() {
+	uploadBuffer(_buffers[LIGHT_BUFFER], _lights.data(), _lights.size() * sizeof(LightData));
+	uploadBuffer(_buffers[CLUSTER_BUFFER], _clusters.data(), _clusters.size() * sizeof(glm::uvec2));
+	uploadBuffer(_buffers[INDEX_BUFFER], _indices.data(), _indices.size() * sizeof(uint32_t));
+}
+
+void LightClusters::bind(Shader& shader, GLuint firstUnit) {
+	for (int i = 0; i < BUFFER_COUNT; ++i) {
+		glActiveTexture(GL_TEXTURE0 + firstUnit + i);
+		glBindTexture(GL_TEXTURE_BUFFER, _textures[i]);
+	}
+	shader.setUniformTexture("lightBuffer", firstUnit + LIGHT_BUFFER);
+	shader.setUniformTexture("clusterBuffer", firstUnit + CLUSTER_BUFFER);
+	shader.setUniformTexture("lightIndexBuffer", firstUnit + INDEX_BUFFER);
+	shader.setUniformInt("numDirectional", (GLint)_directional.size());
+	shader.setUniformVec2("sliceScaleBias", _sliceScaleBias);
+}
+
+size_t LightClusters::getLightCount() const {
+	return _lights.size();
+}
+
+size_t LightClusters::getIndexCount() const {
+	return _indices.size();
+}
+
+void LightClusters::uploadBuffer(GLuint buffer, const void* data, size_t size) {
+	// never empty, texel fetches from an empty buffer are undefined on some drivers
+	static const glm::vec4 empty(0.0f);
+	glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+	if (size == 0) {
+		glBufferData(GL_TEXTURE_BUFFER, sizeof(empty), &empty, GL_STREAM_DRAW);
+	}
+	else {
+		// orphan, last frame's lighting pass may still be reading the old storage
+		glBufferData(GL_TEXTURE_BUFFER, size, nullptr, GL_STREAM_DRAW);
+		glBufferSubData(GL_TEXTURE_BUFFER, 0, size, data);
+	}
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
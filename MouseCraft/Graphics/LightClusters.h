@@ -0,0 +1,92 @@
+#pragma once
+#include "../GL/glad.h"
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+#include "Shader.h"
+
+/// <summary>
+/// Assigns point lights to the clusters of a view so the lighting pass only evaluates
+/// the lights that can reach a pixel. The view is split into TILES_X * TILES_Y screen tiles
+/// and SLICES depth slices (exponential, so near slices are thin). Every point light is added
+/// to the clusters its sphere of influence overlaps, directional lights light every pixel.
+///
+/// Binning is CPU only and can run while capturing a frame, upload and bind need the GL thread.
+/// The shader reads three texture buffers:
+///		lightBuffer		4 RGBA32F texels per light, directional lights first
+///		clusterBuffer	RG32UI offset and count into the index list per cluster
+///		lightIndexBuffer	R32UI light indices
+/// </summary>
+class LightClusters {
+public:
+	static const int TILES_X = 16;
+	static const int TILES_Y = 9;
+	static const int SLICES = 24;
+	static const int CLUSTER_COUNT = TILES_X * TILES_Y * SLICES;
+
+	// One light, in view space. Same layout as the texels in the light buffer.
+	struct LightData {
+		glm::vec4 color;
+		glm::vec4 position;		// w: range, how far the light reaches
+		glm::vec4 direction;
+		glm::vec4 attenuation;	// constant, linear, quadratic, type (0 directional, 1 point)
+	};
+
+	LightClusters();
+	~LightClusters();
+
+	/// <summary>
+	/// Forget the lights of the last frame, keeps the memory.
+	/// </summary>
+	void clear();
+
+	/// <summary>
+	/// Queue a light for the next build.
+	/// </summary>
+	void addLight(const LightData& light);
+
+	/// <summary>
+	/// Bin the queued point lights into the clusters of a view.
+	/// </summary>
+	/// <param name="projection">Projection matrix of the view</param>
+	/// <param name="closeClip">Near plane distance the slices start at</param>
+	/// <param name="farClip">Far plane distance the slices end at</param>
+	void build(const glm::mat4& projection, float closeClip, float farClip);
+
+	/// <summary>
+	/// Upload the lights and clusters of the last build.
+	/// </summary>
+	void upload();
+
+	/// <summary>
+	/// Bind the texture buffers to three texture units starting at firstUnit and set the
+	/// uniforms the lighting shader needs to find its cluster.
+	/// </summary>
+	void bind(Shader& shader, GLuint firstUnit);
+
+	size_t getLightCount() const;
+
+	/// <summary>
+	/// Number of light references in all the clusters together
+	/// </summary>
+	size_t getIndexCount() const;
+private:
+	void uploadBuffer(GLuint buffer, const void* data, size_t size);
+
+	std::vector<LightData> _directional;
+	std::vector<LightData> _point;
+
+	// result of the last build
+	std::vector<LightData> _lights;		// directional then point
+	std::vector<glm::uvec2> _clusters;	// offset, count
+	std::vector<uint32_t> _indices;
+	glm::vec2 _sliceScaleBias;			// slice = log(depth) * x + y
+
+	// cluster ranges per point light, counts then offsets while building
+	std::vector<glm::ivec3> _rangeMin;
+	std::vector<glm::ivec3> _rangeMax;
+
+	enum { LIGHT_BUFFER, CLUSTER_BUFFER, INDEX_BUFFER, BUFFER_COUNT };
+	GLuint _buffers[BUFFER_COUNT];
+	GLuint _textures[BUFFER_COUNT];
+};
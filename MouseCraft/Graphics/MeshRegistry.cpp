@@ -0,0 +1,127 @@
+#include "MeshRegistry.h"
+#include <algorithm>
+
+using std::vector;
+
+// starting size of the shared buffers
+#define INITIAL_VERTICES 65536
+#define INITIAL_INDICES 262144
+
+MeshRegistry::MeshRegistry() :
+	_positionVBO(3), _normalVBO(3), _smoothNormalVBO(3), _texCoordVBO(2), _vertexCount(0), _indexCount(0) {
+	reserve(INITIAL_VERTICES, INITIAL_INDICES);
+}
+
+MeshRegistry::~MeshRegistry() {
+}
+
+unsigned int MeshRegistry::getMesh(Geometry* geometry) {
+	auto it = _geometryMeshes.find(geometry);
+	if (it != _geometryMeshes.end()) {
+		return it->second;
+	}
+	unsigned int mesh = addMesh(
+		geometry->getVertexData(),
+		geometry->getNormalData(),
+		geometry->getSmoothNormalData(),
+		geometry->getTexCoordData(),
+		geometry->getIndices()
+	);
+	_geometryMeshes[geometry] = mesh;
+	return mesh;
+}
+
+unsigned int MeshRegistry::addMesh(const vector<GLfloat>& vertices, const vector<GLfloat>& normals,
+	const vector<GLfloat>& smoothNormals, const vector<GLfloat>& texCoords, const vector<GLuint>& indices) {
+	size_t vertexCount = vertices.size() / 3;
+	reserve(_vertexCount + vertexCount, _indexCount + indices.size());
+
+	MeshInfo info;
+	info.baseVertex = (GLint)_vertexCount;
+	info.firstIndex = (GLuint)_indexCount;
+	info.indexCount = (GLsizei)indices.size();
+	info.vertexCount = (GLsizei)vertexCount;
+
+	// all attributes share the vertex index, so short ones are padded to keep them lined up
+	auto upload = [&](VertexBufferObject& vbo, const vector<GLfloat>& values) {
+		size_t size = vertexCount * vbo.getComponentsPerElement();
+		if (values.size() == size) {
+			vbo.bufferSubData(_vertexCount * vbo.getComponentsPerElement(), values);
+			return;
+		}
+		_padding.assign(size, 0.0f);
+		std::copy(values.begin(), values.begin() + std::min(values.size(), size), _padding.begin());
+		vbo.bufferSubData(_vertexCount * vbo.getComponentsPerElement(), _padding);
+	};
+	upload(_positionVBO, vertices);
+	upload(_normalVBO, normals);
+	upload(_smoothNormalVBO, smoothNormals);
+	upload(_texCoordVBO, texCoords);
+	_ebo.bufferSubData(_indexCount, indices);
+
+	_vertexCount += vertexCount;
+	_indexCount += indices.size();
+	_meshes.push_back(info);
+	return (unsigned int)_meshes.size() - 1;
+}
+
+const MeshInfo& MeshRegistry::getInfo(unsigned int mesh) const {
+	return _meshes[mesh];
+}
+
+void MeshRegistry::bind() {
+	_vao.bind();
+}
+
+void MeshRegistry::draw(unsigned int mesh) {
+	const MeshInfo& info = _meshes[mesh];
+	glDrawElementsBaseVertex(
+		GL_TRIANGLES,
+		info.indexCount,
+		GL_UNSIGNED_INT,
+		(void *)(info.firstIndex * sizeof(GLuint)),
+		info.baseVertex
+	);
+}
+
+size_t MeshRegistry::getMeshCount() const {
+	return _meshes.size();
+}
+
+size_t MeshRegistry::getVertexCount() const {
+	return _vertexCount;
+}
+
+size_t MeshRegistry::getIndexCount() const {
+	return _indexCount;
+}
+
+void MeshRegistry::reserve(size_t vertices, size_t indices) {
+	if (vertices * 3 > _positionVBO.getCapacity()) {
+		size_t capacity = grow(_positionVBO.getCapacity() / 3, vertices);
+		_positionVBO.reserve(capacity * 3);
+		_normalVBO.reserve(capacity * 3);
+		_smoothNormalVBO.reserve(capacity * 3);
+		_texCoordVBO.reserve(capacity * 2);
+
+		// the buffers were replaced, point the VAO at the new ones
+		_vao.setBuffer(0, _positionVBO);
+		_vao.setBuffer(1, _normalVBO);
+		_vao.setBuffer(2, _texCoordVBO);
+		_vao.setBuffer(SMOOTH_NORMAL_LOCATION, _smoothNormalVBO);
+	}
+	if (indices > _ebo.getCapacity()) {
+		_ebo.reserve(grow(_ebo.getCapacity(), indices));
+		_vao.setElementBuffer(_ebo);
+	}
+}
+
+size_t MeshRegistry::grow(size_t capacity, size_t required) {
+	if (capacity == 0) {
+		return required;
+	}
+	while (capacity < required) {
+		capacity *= 2;
+	}
+	return capacity;
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include "../GL/glad.h"
+#include <vector>
+#include <unordered_map>
+#include "Geometry.h"
+#include "BufferObjects/VertexArrayObject.h"
+#include "BufferObjects/VertexBufferObject.h"
+#include "BufferObjects/ElementBufferObject.h"
+
+/// <summary>
+/// Where a mesh lives inside the shared buffers of a MeshRegistry.
+/// </summary>
+struct MeshInfo {
+	GLint baseVertex;		// added to every index of the mesh
+	GLuint firstIndex;		// offset into the element buffer, in indices
+	GLsizei indexCount;
+	GLsizei vertexCount;
+};
+
+/// <summary>
+/// Keeps every mesh the renderer has seen in one set of GPU buffers.
+/// A mesh is uploaded the first time it is drawn and then stays resident, so
+/// drawing it again only costs a glDrawElementsBaseVertex with its offsets.
+/// The buffers grow by doubling and are copied GPU side when they do.
+/// Must only be used from the thread that owns the OpenGL context.
+///
+/// Vertex attributes: 0 position, 1 normal, 2 texture coordinate, 3 smooth normal (see Geometry).
+/// </summary>
+class MeshRegistry {
+public:
+	static const int SMOOTH_NORMAL_LOCATION = 3;
+
+	/// <summary>
+	/// Creates the shared buffers and the VAO pointing at them
+	/// </summary>
+	MeshRegistry();
+
+	~MeshRegistry();
+
+	/// <summary>
+	/// Get the ID of a geometry's mesh, uploading it on first use.
+	/// Geometry is expected to stay the same once it is drawn (nothing in the game edits it after loading).
+	/// Meshes are never released and the geometry is the key, so it must outlive the registry:
+	/// share models (ResourceCache, ModelGen::getCube) instead of generating one per entity.
+	/// </summary>
+	/// <param name="geometry">The geometry to look up</param>
+	/// <returns>The mesh ID</returns>
+	unsigned int getMesh(Geometry* geometry);
+
+	/// <summary>
+	/// Upload raw vertex data as a new mesh.
+	/// Missing normals, smooth normals or texture coordinates are filled with zeros.
+	/// </summary>
+	/// <returns>The mesh ID</returns>
+	unsigned int addMesh(const std::vector<GLfloat>& vertices, const std::vector<GLfloat>& normals,
+		const std::vector<GLfloat>& smoothNormals, const std::vector<GLfloat>& texCoords, const std::vector<GLuint>& indices);
+
+	/// <summary>
+	/// Get where a mesh is stored in the shared buffers
+	/// </summary>
+	const MeshInfo& getInfo(unsigned int mesh) const;
+
+	/// <summary>
+	/// Bind the VAO of the shared buffers. Must be done before draw.
+	/// </summary>
+	void bind();
+
+	/// <summary>
+	/// Draw a mesh with whatever shader is bound
+	/// </summary>
+	void draw(unsigned int mesh);
+
+	size_t getMeshCount() const;
+	size_t getVertexCount() const;
+	size_t getIndexCount() const;
+private:
+	void reserve(size_t vertices, size_t indices);
+	static size_t grow(size_t capacity, size_t required);
+
+	VertexArrayObject _vao;
+	VertexBufferObject _positionVBO;
+	VertexBufferObject _normalVBO;
+	VertexBufferObject _smoothNormalVBO;
+	VertexBufferObject _texCoordVBO;
+	ElementBufferObject _ebo;
+
+	// used space, in vertices and indices
+	size_t _vertexCount;
+	size_t _indexCount;
+
+	std::vector<MeshInfo> _meshes;
+	std::unordered_map<Geometry*, unsigned int> _geometryMeshes;
+
+	// scratch for padding incomplete attributes
+	std::vector<GLfloat> _padding;
+};
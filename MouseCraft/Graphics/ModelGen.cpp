@@ -1,5 +1,7 @@
 #include "ModelGen.h"
+#include "../ResourceCache.h"
 #include <vector>
+#include <string>
 
 using std::vector;
 
@@ -201,4 +203,24 @@ Model* ModelGen::makeCube(float width, float height, float depth) {
 	g->setIndices(indices);
 
 	return new Model(g);
+}
+
+Model* ModelGen::getCube(float width, float height, float depth) {
+	std::string key = "cube:" + std::to_string(width) + "," + std::to_string(height) + "," + std::to_string(depth);
+	Model* model = ResourceCache<Model>::Instance().Get(key);
+	if (model == nullptr) {
+		model = makeCube(width, height, depth);
+		ResourceCache<Model>::Instance().Add(key, model);
+	}
+	return model;
+}
+
+Model* ModelGen::getQuad(ModelGen::Axis facing, float width, float height) {
+	std::string key = "quad:" + std::to_string((int)facing) + "," + std::to_string(width) + "," + std::to_string(height);
+	Model* model = ResourceCache<Model>::Instance().Get(key);
+	if (model == nullptr) {
+		model = makeQuad(facing, width, height);
+		ResourceCache<Model>::Instance().Add(key, model);
+	}
+	return model;
 }
\ No newline at end of file
@@ -9,4 +9,10 @@ public:
 	};
 	static Model* makeQuad(ModelGen::Axis facing, float width, float height);
 	static Model* makeCube(float width, float height, float depth);
+	// Cube shared by everything asking for this size, generated on first use and kept in ResourceCache<Model>.
+	// The renderer uploads a mesh per geometry and keeps it, so use this for anything spawned or loaded repeatedly.
+	// A texture set on it applies to everything using that size.
+	static Model* getCube(float width, float height, float depth);
+	// Quad shared the same way as getCube.
+	static Model* getQuad(ModelGen::Axis facing, float width, float height);
 };
\ No newline at end of file
@@ -1,31 +1,29 @@
 #pragma once
-#include "Model.h"
-#include "Color.h"
+#include "Geometry.h"
 #include <glm/glm.hpp>
-class RenderData {
-public:
-	RenderData(
-		Model* m,
-		glm::mat4 transform,
-		float shininess,
-		float smoothness,
-		Color c = Color(1.0f, 1.0f, 1.0f)):
 
-		_transform(transform),
-		_color(c),
-		_model(new Model(*m)),
-		_smoothness(smoothness),
-		_shininess(shininess)
-	{}
-	Model* getModel() { return _model; }
-	glm::mat4 getTransform() { return _transform; }
-	Color getColor() { return _color; }
-	float getSmoothness() { return _smoothness; }
-	float getShininess() { return _shininess; }
-private:
-	Model* _model;
-	glm::mat4 _transform;
-	Color _color;
-	float _shininess;
-	float _smoothness;
-};
\ No newline at end of file
+/// <summary>
+/// One object to draw, captured in LateUpdate and drawn by the next Update.
+/// Plain data so a frame's worth of them can be kept in lists that are reused every frame.
+/// </summary>
+struct RenderData {
+	unsigned int mesh;		// MeshRegistry ID
+	unsigned int material;	// RenderSystem material ID
+	glm::mat4x3 transform;	// world transform, the missing row is always 0 0 0 1
+	glm::vec4 color;
+};
+
+/// <summary>
+/// A UI element to draw. UI geometry is rebuilt whenever an element changes (ie. new text)
+/// so it's copied into the frame's UI buffer when captured instead of being kept in the MeshRegistry.
+/// </summary>
+struct UIRenderData {
+	unsigned int firstVertex;	// ranges of the frame's UI geometry, indices count from firstVertex
+	unsigned int vertexCount;
+	unsigned int firstIndex;
+	unsigned int indexCount;
+	unsigned int material;
+	glm::mat4x3 transform;
+	glm::vec4 color;
+	bool transparent;
+};
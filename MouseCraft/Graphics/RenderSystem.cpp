@@ -9,8 +9,16 @@
 #include "../Loading/ImageLoader.h"
 #include "RenderUtil.h"
 #include "OutlineComponent.h"
+#include "../Util/AffineMath.h"
+#include "../Core/TaskScheduler.h"
+#include <limits>
 
-#define TEXTURE_SIZE 2048
+#define TEXTURE_BUDGET (512 * 1024 * 1024)	// bytes of video memory for texture arrays
+#define TEXTURE_UPLOADS_PER_FRAME 2
+#define CAPTURE_CHUNK_SIZE 256	// renderables per capture task
+#define MATERIAL_RECLAIM_FRAMES 120	// frames a material has to go undrawn before its slot can be reused
+#define BLOOM_THRESHOLD 0.44f	// brightness that starts to glow
+#define BLOOM_INTENSITY 2.0f	// spread over the levels, which are added up
 
 using std::string;
 using std::vector;
@@ -23,94 +31,87 @@ using glm::identity;
 using glm::inverse;
 using glm::transpose;
 
-RenderSystem::RenderSystem() : System() {
+RenderSystem::RenderSystem() : System(), _hasCamera(false), _bloomQuality(BLOOM_HIGH) {
+	// Update only draws the lists captured last frame, so it can overlap systems that
+	// modify components. Capturing happens in LateUpdate once every system is done.
+	RunOnMainThread(true);
+	Writes<RenderSystem>();
+
 	initShaders();
-	initVertexBuffers();
 	initTextures();
 	initRenderBuffers();
 
+	_meshes = new MeshRegistry();
 	_screenQuad = ModelGen::makeQuad(ModelGen::Axis::Z, 2, 2);
+	_screenQuadMesh = _meshes->getMesh(_screenQuad->getGeometry());
+	_gBufferBatch = new InstanceBatcher();
+	_outlineBatch = new InstanceBatcher();
+	_uiBatch = new UIBatcher();
 
 	_renderingList = new vector<RenderData>();
 	_accumulatingList = new vector<RenderData>();
 
-	_uiRenderingList = new vector<RenderData>();
-	_uiAccumulatingList = new vector<RenderData>();
+	_uiRenderingList = new vector<UIRenderData>();
+	_uiAccumulatingList = new vector<UIRenderData>();
 
-	_lightRenderingList = new vector<LightData>();
-	_lightRenderingList->reserve(MAX_LIGHTS);
-	_lightAccumulatingList = new vector<LightData>();
-	_lightAccumulatingList->reserve(MAX_LIGHTS);
+	_lightsRendering = new LightClusters();
+	_lightsAccumulating = new LightClusters();
 
 	_outlineRenderingList = new vector<RenderData>();
 	_outlineAccumulatingList = new vector<RenderData>();
 
-	_masterGeometry = new CombinedGeometry();
-	_masterOutlineGeometry = new CombinedGeometry();
-
 	glEnable(GL_FRAMEBUFFER_SRGB);
 	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
 
-	profiler.InitializeTimers(1);
+	profiler.InitializeTimers(2);	// draw, list capture
 	profiler.LogOutput("Rendering.log");	// optional
 
-	loadTexture("res/models/test/blank.bmp");
-
-	_vao->bind();
+	// shown until other textures are streamed in, so it's loaded right away
+	_textures->setPlaceholder("res/models/test/blank.bmp");
 }
 
 RenderSystem::~RenderSystem() {
-	delete _vao;
-	delete _positionVBO;
-	delete _ebo;
 	delete _textures;
 	delete _fbo;
 	delete _outlineFBO;
 	delete _postFBO;
-	delete _bloomFBO;
+	for (BloomLevel& level : _bloomLevels) {
+		delete level.blurredFBO;
+		delete level.tempFBO;
+		delete level.blurred;
+		delete level.temp;
+	}
 	delete _screenQuad;
-	delete _masterGeometry;
-	delete _ubo;
+	delete _gBufferBatch;
+	delete _meshes;
+	delete _lightsRendering;
+	delete _lightsAccumulating;
+	delete _materialUBO;
+	delete _outlineBatch;
+	delete _uiBatch;
 
 	for (auto a : *_staticGeometries) {
 		delete a;
 	}
-
-	for (auto a : *_staticTextures) {
-		delete a;
-	}
-}
-
-void RenderSystem::initVertexBuffers() {
-	_vao = new VertexArrayObject();
-	_positionVBO = new VertexBufferObject(3);
-	_normalVBO = new VertexBufferObject(3);
-	_texCoordVBO = new VertexBufferObject(2);
-	_ebo = new ElementBufferObject();
-
-	_vao->setBuffer(0, *_positionVBO);
-	_vao->setBuffer(1, *_normalVBO);
-	_vao->setBuffer(2, *_texCoordVBO);
-
-	_vao->setElementBuffer(*_ebo);
 }
 
 void RenderSystem::initTextures() {
-	_staticTextures = new vector<Image*>();
-	_textures = new GLTextureArray(TEXTURE_SIZE, TEXTURE_SIZE, 50, 5, GL_SRGB8_ALPHA8);
+	_textures = new TextureResidency(TEXTURE_BUDGET);
 }
 
 void RenderSystem::initRenderBuffers() {
 	_albedoBuffer = new GLTexture();
 	_normalBuffer = new GLTexture();
-	_positionBuffer = new GLTexture();
 	_specularBuffer = new GLTexture();
+	_depthBuffer = new GLTexture();
 	_outlineBuffer = new GLTexture();
 	_postBuffer = new GLTexture();
-	_bloomBuffer = new GLTexture();
 
-	vector<GLTexture*> buffers = { _albedoBuffer, _normalBuffer, _positionBuffer, _specularBuffer };
-	_fbo = new FrameBufferObject(1280, 720, buffers);
+	// 14 bytes a pixel: srgb albedo, octahedral normal, shininess and smoothness, and the depth
+	// the lighting pass rebuilds view space positions from
+	vector<GLTexture*> buffers = { _albedoBuffer, _normalBuffer, _specularBuffer };
+	vector<GLuint> formats = { GL_SRGB8_ALPHA8, GL_RG16, GL_RG8 };
+	_fbo = new FrameBufferObject(1280, 720, buffers, formats, _depthBuffer);
 
 	vector<GLTexture*> outlineBuffers = { _outlineBuffer };
 	_outlineFBO = new FrameBufferObject(1280, 720, outlineBuffers);
@@ -118,14 +119,34 @@ void RenderSystem::initRenderBuffers() {
 	vector<GLTexture*> postBuffers = { _postBuffer };
 	_postFBO = new FrameBufferObject(1280, 720, postBuffers);
 
-	vector<GLTexture*> bloomBuffers = { _bloomBuffer };
-	_bloomFBO = new FrameBufferObject(1280, 720, bloomBuffers);
-
-	vector<GLTexture*> noBuffers = {};
-	_resizeInFBO = new FrameBufferObject(TEXTURE_SIZE, TEXTURE_SIZE, noBuffers);
-	_resizeOutFBO = new FrameBufferObject(TEXTURE_SIZE, TEXTURE_SIZE, noBuffers);
+	// blurs read past the edges, those should repeat the edge instead of the other side
+	auto clampToEdge = [](GLTexture* texture) {
+		texture->bind(GL_TEXTURE0);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	};
+	clampToEdge(_postBuffer);
+
+	int width = 1280;
+	int height = 720;
+	for (BloomLevel& level : _bloomLevels) {
+		width = std::max(width / 2, 1);
+		height = std::max(height / 2, 1);
+		level.width = width;
+		level.height = height;
+		level.blurred = new GLTexture();
+		level.temp = new GLTexture();
+		vector<GLTexture*> blurred = { level.blurred };
+		level.blurredFBO = new FrameBufferObject(width, height, blurred);
+		vector<GLTexture*> temp = { level.temp };
+		level.tempFBO = new FrameBufferObject(width, height, temp);
+		clampToEdge(level.blurred);
+		clampToEdge(level.temp);
+	}
 
-	_ubo = new UniformBufferObject();
+	_materialUBO = new UniformBufferObject();
+	// the whole block is always uploaded, a smaller buffer than the block is undefined
+	_materialUniforms.resize(MAX_MATERIALS);
 }
 
 void RenderSystem::setWindow(Window* window) {
@@ -133,13 +154,17 @@ void RenderSystem::setWindow(Window* window) {
 }
 
 void RenderSystem::initShaders() {
-	loadShader("gbuffer");
-	loadShader("lighting");
-	loadShader("outline");
-	loadShader("ui");
-	loadShader("final");
-	loadShader("bloom1");
-	loadShader("bloom2");
+	loadShader(GBUFFER_SHADER, "gbuffer");
+	loadShader(LIGHTING_SHADER, "lighting");
+	loadShader(OUTLINE_SHADER, "outline");
+	loadShader(UI_SHADER, "ui");
+	loadShader(FINAL_SHADER, "final");
+	loadShader(BLOOM_DOWN_SHADER, "bloomdown");
+	loadShader(BLOOM_BLUR_SHADER, "bloomblur");
+	loadShader(BLOOM_UP_SHADER, "bloomup");
+
+	// binding points stay with the program, the passes only bind buffers to them
+	_shaders[GBUFFER_SHADER].setBindingPoint("Materials", MATERIALS_BINDING);
 }
 
 void RenderSystem::setShader(Shader& shader) {
@@ -155,13 +180,20 @@ void RenderSystem::clearShader() {
 void RenderSystem::Update(float dt) {
 	profiler.StartTimer(0);
 
+	streamTextures();
 	clearBuffers();
 	renderScene();
 
+	profiler.StopTimer(0);
+}
+
+void RenderSystem::LateUpdate(float dt) {
+	profiler.StartTimer(1);
+
 	accumulateList();
 	swapLists();
 
-	profiler.StopTimer(0);
+	profiler.StopTimer(1);
 	profiler.FrameFinish();
 }
 
@@ -172,9 +204,6 @@ void RenderSystem::clearBuffers() {
 	_outlineFBO->bind();
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	_outlineFBO->unbind();
-	_bloomFBO->bind();
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	_bloomFBO->unbind();
 	_postFBO->bind();
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	_postFBO->unbind();
@@ -182,21 +211,13 @@ void RenderSystem::clearBuffers() {
 }
 
 void RenderSystem::renderScene() {
-	if (_camera != nullptr && _renderingList->size() > 0) {
-		float windowRatio = (float)_window->getWidth() / _window->getHeight();
-		Transform viewTransform = _camera->getTransform();
-		mat4 view = inverse(viewTransform.getWorldTransformation());
-
-		float fov = _camera->getFOV();
-		float closeClip = _camera->getCloseClip();
-		float farClip = _camera->getFarClip();
-
-		mat4 projection = perspective(fov, windowRatio, closeClip, farClip);
+	if (_hasCamera && _renderingList->size() > 0) {
+		mat4 view = inverse(_cameraData.transform);
+		mat4 projection = projectionMatrix();
 
 		gBufferPass(view, projection);
 		outlinePass(view, projection);
-		makeLightsViewSpace(view);
-		lightingPass();
+		lightingPass(projection);
 		bloomPass();
 		finalizationPass();
 	}
@@ -205,174 +226,59 @@ void RenderSystem::renderScene() {
 
 void RenderSystem::gBufferPass(glm::mat4 viewMatrix, glm::mat4 projectionMatrix) {
 
-	// Set up all of the vertex data for all objects to be rendered
-	combineMasterGeometry(*_renderingList);
-	_positionVBO->buffer(_masterGeometry->getVertexData());
-	_normalVBO->buffer(_masterGeometry->getNormalData());
-	_texCoordVBO->buffer(_masterGeometry->getTexCoordData());
-	_ebo->buffer(_masterGeometry->getIndices());
-
-	setShader(_shaders["gbuffer"]);
-	_fbo->bind();
-
-	int index = 0;
-	for (RenderData render : *_renderingList) {
-		TextureInfo texInfo = getTexture(render.getModel()->getTexture());
-		vec4 color = convertColor(render.getColor());
-		mat4 model = render.getTransform();
-
-		mat4 mv =  viewMatrix * model;
-		mat4 mvp = projectionMatrix * mv;
-		mat4 invMVP = transpose(inverse(viewMatrix * model));
-
-		int loc = _masterGeometry->getVertexStart(index);
-		_vao->setBuffer(0, *_positionVBO, loc * 3 * sizeof(GLfloat));
-		_vao->setBuffer(1, *_normalVBO, loc * 3 * sizeof(GLfloat));
-		_vao->setBuffer(2, *_texCoordVBO, loc * 2 * sizeof(GLfloat));
-
-		_textures->bind(GL_TEXTURE0);
-
-		_shader->setUniformVec3("color", color);
-		_shader->setUniformFloat("shininess", render.getShininess());
-		_shader->setUniformFloat("smoothness", render.getSmoothness());
-
-		_shader->setUniformMatrix("transform", mvp);
-		_shader->setUniformMatrix("transformNoPerspective", mv);
-		_shader->setUniformMatrix("invTransform", invMVP);
-
-		_shader->setUniformInt("textureID", texInfo.id);
-		_shader->setUniformTexture("albedoTex", 0);
-
-		int start = _masterGeometry->getIndexStart(index);
-		int size = _masterGeometry->getIndexEnd(index) - start + 1;
-		glDrawElements(GL_TRIANGLES, size, GL_UNSIGNED_INT, (void *)(start * sizeof(GLuint)));
-
-		index++;
+	// model view and normal matrices for every object up front
+	const size_t count = _renderingList->size();
+	_modelViewMatrices.resize(count);
+	_normalMatrices.resize(count);
+	for (size_t i = 0; i < count; ++i)
+		AffineMath::Multiply(viewMatrix, mat4((*_renderingList)[i].transform), _modelViewMatrices[i]);
+	AffineMath::NormalMatrices(_modelViewMatrices.data(), _normalMatrices.data(), count);
+
+	// everything else about an object goes in its instance, the batcher groups them by mesh
+	_gBufferBatch->clear();
+	for (size_t i = 0; i < count; ++i) {
+		const RenderData& render = (*_renderingList)[i];
+		InstanceBatcher::Instance& instance = _gBufferBatch->add(render.mesh, render.material);
+		instance.modelView = _modelViewMatrices[i];
+		instance.normalMatrix[0] = _normalMatrices[i][0];
+		instance.normalMatrix[1] = _normalMatrices[i][1];
+		instance.normalMatrix[2] = _normalMatrices[i][2];
+		instance.color = render.color;
+		instance.material = render.material;
 	}
-	_fbo->unbind();
-}
-
-void RenderSystem::combineMasterGeometry(vector<RenderData>& data) {
-	_masterGeometry->clear();
-	std::vector<GLfloat>& vert = _masterGeometry->getVertexData();
-	std::vector<GLfloat>& texCoord = _masterGeometry->getTexCoordData();
-	std::vector<GLfloat>& normal = _masterGeometry->getNormalData();
-	std::vector<GLuint>& indices = _masterGeometry->getIndices();
-	for (RenderData render : data) {
-		Geometry* g = render.getModel()->getGeometry();
-
-		int startVertex = vert.size() / 3;
-		int startIndex = indices.size();
-		_masterGeometry->getIndexIndices().push_back(startIndex);
-		_masterGeometry->getVertexIndices().push_back(startVertex);
-
-		vert.insert(vert.end(), g->getVertexData().begin(), g->getVertexData().end());
-		texCoord.insert(texCoord.end(), g->getTexCoordData().begin(), g->getTexCoordData().end());
-		normal.insert(normal.end(), g->getNormalData().begin(), g->getNormalData().end());
-		indices.insert(indices.end(), g->getIndices().begin(), g->getIndices().end());
-	}
-	_masterGeometry->setVertexData(vert);
-	_masterGeometry->setTexCoordData(texCoord);
-	_masterGeometry->setNormalData(normal);
-	_masterGeometry->setIndices(indices);
-}
-
-vector<GLfloat>* RenderSystem::fetchSmoothNormals(Geometry* g) {
-	if (_smoothNormalCache.find(g) == _smoothNormalCache.end()) {
-		_smoothNormalCache[g] = calcSmoothNormals(g);
-	}
-	return _smoothNormalCache[g];
-}
-
-std::vector<GLfloat>* RenderSystem::calcSmoothNormals(Geometry* geometry) {
-	std::vector<GLfloat> normals = geometry->getNormalData();
-	std::vector<GLfloat> vertices = geometry->getVertexData();
-	std::map<std::vector<int>, std::pair<glm::vec3, std::vector<size_t>>> vertexIndexNormals;
-	size_t size = normals.size();
 
-	// Calculate the smooth normals
-	for (int i = 0; i < size; i += 3) {
-		std::vector<GLfloat> vertex = std::vector<GLfloat>(vertices.begin() + i, vertices.begin() + (i + 3));
-		std::vector<GLfloat> normal = std::vector<GLfloat>(normals.begin() + i, normals.begin() + (i + 3));
-
-		std::vector<int> vertInt = std::vector<int>();
-		for (GLfloat& f : vertex) {
-			vertInt.push_back((int)(round(f * 100.0f)));
-		}
-
-		std::vector<size_t>& indices = vertexIndexNormals[vertInt].second;
-		size_t size = indices.size();
-		if (size == 0) {
-			vertexIndexNormals[vertInt].first = glm::vec3(normal[0], normal[1], normal[2]);
-		}
-		else {
-			glm::vec3& f = vertexIndexNormals[vertInt].first;
-			f = f * ((float)(size) / (size + 1.0f)) + vec3(normal[0], normal[1], normal[2]) * (1.0f / (size + 1.0f));
-		}
-		indices.push_back(i);
-	}
-
-	// Propogate the smooth normals back to the indices
-	std::vector<GLfloat>* smoothNormals = new std::vector<GLfloat>(normals);
-	for (auto& pair : vertexIndexNormals) {
-		std::vector<size_t> indices = pair.second.second;
-		glm::vec3 smoothNormal = normalize(pair.second.first);
-		//glm::vec3 smoothNormal = vec3(0.0f, 0.0f, 0.0f);
-		
-		for (size_t i : indices) {
-			(*smoothNormals)[i] = smoothNormal.x;
-			(*smoothNormals)[i + 1] = smoothNormal.y;
-			(*smoothNormals)[i + 2] = smoothNormal.z;
-		}
+	// materials only change when a new one shows up
+	if (_materialsDirty) {
+		_materialUBO->bufferData(_materialUniforms.data(), _materialUniforms.size() * sizeof(vec4));
+		_materialsDirty = false;
 	}
-	return smoothNormals;
-}
-
-void RenderSystem::combineOutlineGeometry(vector<RenderData>& data) {
-	_masterOutlineGeometry->clear();
-	std::vector<GLfloat>& vert = _masterOutlineGeometry->getVertexData();
-	std::vector<GLfloat>& texCoord = _masterOutlineGeometry->getTexCoordData();
-	std::vector<GLfloat>& normal = _masterOutlineGeometry->getNormalData();
-	std::vector<GLuint>& indices = _masterOutlineGeometry->getIndices();
-	for (RenderData render : data) {
-		Geometry* g = render.getModel()->getGeometry();
+	_materialUBO->bind(MATERIALS_BINDING);
 
-		int startVertex = vert.size() / 3;
-		int startIndex = indices.size();
-		_masterOutlineGeometry->getIndexIndices().push_back(startIndex);
-		_masterOutlineGeometry->getVertexIndices().push_back(startVertex);
+	setShader(_shaders[GBUFFER_SHADER]);
+	_fbo->bind();
 
-		std::vector<GLfloat>* smoothNormals = fetchSmoothNormals(g);
+	_textures->bind(*_shader, "textures", 0);
+	_shader->setUniformMatrix("projection", projectionMatrix);
 
-		vert.insert(vert.end(), g->getVertexData().begin(), g->getVertexData().end());
-		texCoord.insert(texCoord.end(), g->getTexCoordData().begin(), g->getTexCoordData().end());
-		normal.insert(normal.end(), smoothNormals->begin(), smoothNormals->end());
-		indices.insert(indices.end(), g->getIndices().begin(), g->getIndices().end());
-	}
-	_masterOutlineGeometry->setVertexData(vert);
-	_masterOutlineGeometry->setTexCoordData(texCoord);
-	_masterOutlineGeometry->setNormalData(normal);
-	_masterOutlineGeometry->setIndices(indices);
-}
+	_gBufferBatch->draw(*_meshes);
 
-void RenderSystem::makeLightsViewSpace(glm::mat4 viewMatrix) {
-	glm::mat4 normalMatrix = transpose(inverse(viewMatrix));
-	for (LightData& l : *_lightRenderingList) {
-		l.position = viewMatrix * l.position;
-		l.direction = normalMatrix * l.direction;
-	}
+	_fbo->unbind();
 }
 
 void RenderSystem::outlinePass(glm::mat4 viewMatrix, glm::mat4 projectionMatrix) {
 	if (_outlineRenderingList->size() > 0) {
-		// Set up all of the vertex data for all objects to be rendered
-		combineOutlineGeometry(*_outlineRenderingList);
-		_positionVBO->buffer(_masterOutlineGeometry->getVertexData());
-		_normalVBO->buffer(_masterOutlineGeometry->getNormalData());
-		_texCoordVBO->buffer(_masterOutlineGeometry->getTexCoordData());
-		_ebo->buffer(_masterOutlineGeometry->getIndices());
+		// same resident meshes as the gbuffer, the vertex shader pushes them out along the smooth normals
+		_outlineBatch->clear();
+		for (const RenderData& render : *_outlineRenderingList) {
+			InstanceBatcher::Instance& instance = _outlineBatch->add(render.mesh, 0);
+			AffineMath::Multiply(viewMatrix, mat4(render.transform), instance.modelView);
+			instance.normalMatrix[0] = instance.normalMatrix[1] = instance.normalMatrix[2] = vec4(0.0f);	// unused
+			instance.color = render.color;	// alpha carries the line width
+			instance.material = 0;
+		}
 
-		setShader(_shaders["outline"]);
+		setShader(_shaders[OUTLINE_SHADER]);
+		_shader->setUniformMatrix("projection", projectionMatrix);
 
 		glCullFace(GL_FRONT);
 
@@ -382,204 +288,220 @@ void RenderSystem::outlinePass(glm::mat4 viewMatrix, glm::mat4 projectionMatrix)
 		RenderUtil::checkGLError("glBlitFramebuffer");
 
 		_outlineFBO->bind();
-		int index = 0;
-		for (RenderData render : *_outlineRenderingList) {
-			vec4 color = convertColor(render.getColor());
-			color.a = 1.0f;
-			mat4 model = render.getTransform();
-
-			mat4 mv = viewMatrix * model;
-			mat4 mvp = projectionMatrix * mv;
-			mat4 invMVP = transpose(inverse(viewMatrix * model));
-
-			int loc = _masterOutlineGeometry->getVertexStart(index);
-			_vao->setBuffer(0, *_positionVBO, loc * 3 * sizeof(GLfloat));
-			_vao->setBuffer(1, *_normalVBO, loc * 3 * sizeof(GLfloat));
-			_vao->setBuffer(2, *_texCoordVBO, loc * 2 * sizeof(GLfloat));
-
-			_shader->setUniformVec3("color", color);
-			_shader->setUniformMatrix("transform", mvp);
-			_shader->setUniformFloat("lineWidth", render.getColor().getAlpha());
-
-			int start = _masterOutlineGeometry->getIndexStart(index);
-			int size = _masterOutlineGeometry->getIndexEnd(index) - start + 1;
-			glDrawElements(GL_TRIANGLES, size, GL_UNSIGNED_INT, (void *)(start * sizeof(GLuint)));
-
-			index++;
-		}
+		_outlineBatch->draw(*_meshes);
 		_outlineFBO->unbind();
 		glCullFace(GL_BACK);
 	}
 }
 
-void RenderSystem::lightingPass() {
-	_vao->setBuffer(0, *_positionVBO);
-	_vao->setBuffer(1, *_normalVBO);
-	_vao->setBuffer(2, *_texCoordVBO);
+void RenderSystem::lightingPass(glm::mat4 projectionMatrix) {
+	_meshes->bind();
 	_postFBO->bind();
 
-	Geometry* quad = _screenQuad->getGeometry();
-	setShader(_shaders["lighting"]);
+	setShader(_shaders[LIGHTING_SHADER]);
 
 	_albedoBuffer->bind(GL_TEXTURE0);
 	_normalBuffer->bind(GL_TEXTURE1);
-	_positionBuffer->bind(GL_TEXTURE2);
+	_depthBuffer->bind(GL_TEXTURE2);
 	_specularBuffer->bind(GL_TEXTURE3);
 	_outlineBuffer->bind(GL_TEXTURE4);
 
 	_shader->setUniformTexture("albedoTex", 0);
 	_shader->setUniformTexture("normalTex", 1);
-	_shader->setUniformTexture("positionTex", 2);
+	_shader->setUniformTexture("depthTex", 2);
 	_shader->setUniformTexture("specularTex", 3);
 	_shader->setUniformTexture("outlineTex", 4);
+	_shader->setUniformMatrix("invProjection", inverse(projectionMatrix));
 
-	_shader->setUniformInt("numLights", _lightRenderingList->size());
 	_shader->setUniformVec3("ambientColor", vec3(0.06f, 0.17f, 0.27f));
 
-	_ubo->bind(0);
-	_shader->setBindingPoint("Lights", 0);
-	_ubo->buffer((*_lightRenderingList)[0], MAX_LIGHTS);
+	_lightsRendering->upload();
+	_lightsRendering->bind(*_shader, 5);
 
-	_positionVBO->buffer(quad->getVertexData());
-	_normalVBO->buffer(quad->getNormalData());
-	_texCoordVBO->buffer(quad->getTexCoordData());
-	_ebo->buffer(quad->getIndices());
-	glDrawElements(GL_TRIANGLES, quad->getIndices().size(), GL_UNSIGNED_INT, 0);
-	_ubo->unbind(0);
+	_meshes->draw(_screenQuadMesh);
 
 	_postFBO->unbind();
 }
 
 void RenderSystem::bloomPass() {
-	// Horizontal Pass
-	_vao->setBuffer(0, *_positionVBO);
-	_vao->setBuffer(1, *_normalVBO);
-	_vao->setBuffer(2, *_texCoordVBO);
-	_bloomFBO->bind();
-
-	Geometry* quad = _screenQuad->getGeometry();
-	setShader(_shaders["bloom1"]);
-
-	_postBuffer->bind(GL_TEXTURE0);
-	_shader->setUniformTexture("screenTex", 0);
-
-	_positionVBO->buffer(quad->getVertexData());
-	_normalVBO->buffer(quad->getNormalData());
-	_texCoordVBO->buffer(quad->getTexCoordData());
-	_ebo->buffer(quad->getIndices());
-	glDrawElements(GL_TRIANGLES, quad->getIndices().size(), GL_UNSIGNED_INT, 0);
-	_bloomFBO->unbind();
-
-	// Vertical Pass
-	_vao->setBuffer(0, *_positionVBO);
-	_vao->setBuffer(1, *_normalVBO);
-	_vao->setBuffer(2, *_texCoordVBO);
-	_postFBO->bind();
-	glClear(GL_DEPTH_BUFFER_BIT);
+	const int levels = (int)_bloomQuality;
+	if (levels == 0) {
+		return;
+	}
 
-	setShader(_shaders["bloom2"]);
+	// every pass covers its whole target, so depth is neither tested nor cleared
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	glDisable(GL_DEPTH_TEST);
+	_meshes->bind();
+
+	auto drawInto = [this](FrameBufferObject* target, const BloomLevel& level, GLTexture* source) {
+		target->bind();
+		glViewport(0, 0, level.width, level.height);
+		source->bind(GL_TEXTURE0);
+		_meshes->draw(_screenQuadMesh);
+	};
+
+	// bright pass into the first level, every further level is the last one halved,
+	// blurred at each size so the blur widens with the levels for the same number of taps
+	for (int i = 0; i < levels; ++i) {
+		const BloomLevel& level = _bloomLevels[i];
+		setShader(_shaders[BLOOM_DOWN_SHADER]);
+		_shader->setUniformTexture("screenTex", 0);
+		_shader->setUniformFloat("threshold", i == 0 ? BLOOM_THRESHOLD : 0.0f);
+		drawInto(level.blurredFBO, level, i == 0 ? _postBuffer : _bloomLevels[i - 1].blurred);
+
+		setShader(_shaders[BLOOM_BLUR_SHADER]);
+		_shader->setUniformTexture("screenTex", 0);
+		_shader->setUniformVec2("direction", glm::vec2(1.0f, 0.0f));
+		drawInto(level.tempFBO, level, level.blurred);
+		_shader->setUniformVec2("direction", glm::vec2(0.0f, 1.0f));
+		drawInto(level.blurredFBO, level, level.temp);
+	}
 
-	_postBuffer->bind(GL_TEXTURE0);
-	_bloomBuffer->bind(GL_TEXTURE1);
+	// back up from the smallest level, each one added onto the next larger one
+	setShader(_shaders[BLOOM_UP_SHADER]);
 	_shader->setUniformTexture("screenTex", 0);
-	_shader->setUniformTexture("tempTex", 1);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_ONE, GL_ONE);
+	for (int i = levels - 1; i > 0; --i) {
+		drawInto(_bloomLevels[i - 1].blurredFBO, _bloomLevels[i - 1], _bloomLevels[i].blurred);
+	}
+	glDisable(GL_BLEND);
 
-	_positionVBO->buffer(quad->getVertexData());
-	_normalVBO->buffer(quad->getNormalData());
-	_texCoordVBO->buffer(quad->getTexCoordData());
-	_ebo->buffer(quad->getIndices());
-	glDrawElements(GL_TRIANGLES, quad->getIndices().size(), GL_UNSIGNED_INT, 0);
-	_postFBO->unbind();
+	_bloomLevels[0].blurredFBO->unbind();
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+	glEnable(GL_DEPTH_TEST);
 }
 
 void RenderSystem::finalizationPass() {
-	_vao->setBuffer(0, *_positionVBO);
-	_vao->setBuffer(1, *_normalVBO);
-	_vao->setBuffer(2, *_texCoordVBO);
+	_meshes->bind();
 
-	Geometry* quad = _screenQuad->getGeometry();
-	setShader(_shaders["final"]);
+	setShader(_shaders[FINAL_SHADER]);
 
+	// bloom is added here instead of in a full resolution pass of its own
 	_postBuffer->bind(GL_TEXTURE0);
+	_bloomLevels[0].blurred->bind(GL_TEXTURE1);
 	_shader->setUniformTexture("screenTex", 0);
+	_shader->setUniformTexture("bloomTex", 1);
+	_shader->setUniformFloat("bloomStrength", _bloomQuality == BLOOM_OFF ? 0.0f : BLOOM_INTENSITY / (float)_bloomQuality);
 
-	_positionVBO->buffer(quad->getVertexData());
-	_normalVBO->buffer(quad->getNormalData());
-	_texCoordVBO->buffer(quad->getTexCoordData());
-	_ebo->buffer(quad->getIndices());
-	glDrawElements(GL_TRIANGLES, quad->getIndices().size(), GL_UNSIGNED_INT, 0);
+	_meshes->draw(_screenQuadMesh);
 }
 
 void RenderSystem::uiPass() {
 	glClear(GL_DEPTH_BUFFER_BIT);
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	float windowRatio = (float)_window->getWidth() / _window->getHeight();
-
-	setShader(_shaders["ui"]);
-
-	int index = 0;
-	for (RenderData render : *_uiRenderingList) {
-		TextureInfo texInfo = getTexture(render.getModel()->getTexture(), false);
-		Geometry* g = render.getModel()->getGeometry();
-		vec4 color = convertColor(render.getColor());
-		mat4 model = render.getTransform();
-
-		mat4 matrix = 2.0f * glm::translate(model, vec3(-0.5, -0.5, 0));
-		matrix[3][3] = 1.0f; // To fix the scaling to be what we want
-
-		int loc = 0;
-
-		// Manually adjust texture coordinates
-		float widthScale = (float)texInfo.width / TEXTURE_SIZE;
-		float heightScale = (float)texInfo.height / TEXTURE_SIZE;
-		vector<GLfloat> texCoords = vector<GLfloat>(g->getTexCoordData().begin(), g->getTexCoordData().end());
-		for (int i = 0; i < texCoords.size(); i += 2) {
-			texCoords[i] *= widthScale;
-			texCoords[i + 1] *= heightScale;
-		}
-
-		_vao->setBuffer(0, *_positionVBO, loc * 3 * sizeof(GLfloat));
-		_vao->setBuffer(1, *_normalVBO, loc * 3 * sizeof(GLfloat));
-		_vao->setBuffer(2, *_texCoordVBO, loc * 2 * sizeof(GLfloat));
-		
-		_positionVBO->buffer(g->getVertexData());
-		_normalVBO->buffer(g->getNormalData());
-		_texCoordVBO->buffer(texCoords);
-		_ebo->buffer(g->getIndices());
-
-		_textures->bind(GL_TEXTURE0);
 
-		_shader->setUniformVec4("color", color);
-		_shader->setUniformMatrix("transform", matrix);
-
-		_shader->setUniformInt("textureID", texInfo.id);
-		_shader->setUniformTexture("tex", 0);
+	// placements are looked up here, textures may have moved since the capture
+	_uiBatch->clear();
+	for (const UIRenderData& render : *_uiRenderingList) {
+		const TextureResidency::Placement& placement = _textures->getPlacement(_materials[render.material].texture.id);
+		UIBatcher::Sprite sprite;
+		sprite.transform = 2.0f * glm::translate(mat4(render.transform), vec3(-0.5, -0.5, 0));
+		sprite.transform[3][3] = 1.0f; // To fix the scaling to be what we want
+		sprite.color = render.color;
+		// unscaled images only fill part of their layer
+		sprite.region = placement.region;
+		sprite.sizeClass = placement.sizeClass;
+		sprite.layer = placement.layer;
+		sprite.transparent = render.transparent;
+		_uiBatch->add(sprite,
+			_uiRenderingGeometry.vertices.data() + render.firstVertex * UIBatcher::SOURCE_VERTEX_SIZE, render.vertexCount,
+			_uiRenderingGeometry.indices.data() + render.firstIndex, render.indexCount);
+	}
 
-		int start = 0;
-		int size = g->getIndices().size();
-		glDrawElements(GL_TRIANGLES, size, GL_UNSIGNED_INT, (void *)(start * sizeof(GLuint)));
+	setShader(_shaders[UI_SHADER]);
+	_textures->bind(*_shader, "textures", 0);
+	_uiBatch->draw();
+}
 
-		index++;
+void RenderSystem::captureUIGeometry(Geometry& geometry, UIRenderData& render) {
+	// copied now, components may rebuild their geometry while the frame is drawn
+	const std::vector<GLfloat>& positions = geometry.getVertexData();
+	const std::vector<GLfloat>& texCoords = geometry.getTexCoordData();
+	const std::vector<GLuint>& indices = geometry.getIndices();
+	std::vector<GLfloat>& vertices = _uiAccumulatingGeometry.vertices;
+	std::vector<GLuint>& frameIndices = _uiAccumulatingGeometry.indices;
+
+	const size_t count = positions.size() / 3;
+	const size_t start = vertices.size();
+	vertices.resize(start + count * UIBatcher::SOURCE_VERTEX_SIZE);
+	for (size_t i = 0; i < count; ++i) {
+		GLfloat* v = &vertices[start + i * UIBatcher::SOURCE_VERTEX_SIZE];
+		v[0] = positions[i * 3];
+		v[1] = positions[i * 3 + 1];
+		v[2] = positions[i * 3 + 2];
+		v[3] = i * 2 + 1 < texCoords.size() ? texCoords[i * 2] : 0.0f;
+		v[4] = i * 2 + 1 < texCoords.size() ? texCoords[i * 2 + 1] : 0.0f;
 	}
-	glDisable(GL_BLEND);
+
+	render.firstVertex = (unsigned int)(start / UIBatcher::SOURCE_VERTEX_SIZE);
+	render.vertexCount = (unsigned int)count;
+	render.firstIndex = (unsigned int)frameIndices.size();
+	render.indexCount = (unsigned int)indices.size();
+	frameIndices.insert(frameIndices.end(), indices.begin(), indices.end());
 }
 
 void RenderSystem::swapLists() {
 	swap(_renderingList, _accumulatingList);
 	swap(_uiRenderingList, _uiAccumulatingList);
-	// Sort the UI rendering list from back to front
-	std::sort(_uiRenderingList->begin(), _uiRenderingList->end(), [](RenderData a, RenderData b) {
-		return a.getTransform()[3][2] > b.getTransform()[3][2];
-	});
-	swap(_lightRenderingList, _lightAccumulatingList);
+	std::swap(_uiRenderingGeometry, _uiAccumulatingGeometry);
+	// the UI batcher sorts by depth when it draws
+	std::swap(_lightsRendering, _lightsAccumulating);
 	swap(_outlineRenderingList, _outlineAccumulatingList);
 	_accumulatingList->clear();
 	_uiAccumulatingList->clear();
-	_lightAccumulatingList->clear();
+	_uiAccumulatingGeometry.vertices.clear();
+	_uiAccumulatingGeometry.indices.clear();
+	_lightsAccumulating->clear();
 	_outlineAccumulatingList->clear();
 }
 
+unsigned int RenderSystem::getMaterial(string* texture, float shininess, float smoothness, bool scale) {
+	// the same path always gets the same texture ID, whichever string it comes from
+	const TextureInfo& info = getTexture(texture, scale);
+	MaterialKey key(info.id, shininess, smoothness);
+	auto it = _materialLookup.find(key);
+	if (it != _materialLookup.end()) {
+		return it->second;
+	}
+
+	unsigned int id;
+	if (_materials.size() < MAX_MATERIALS) {
+		_materials.push_back(Material());
+		id = _materials.size() - 1;
+		_materials[id].generation = 0;
+	}
+	else {
+		// take the slot that went undrawn the longest, the first one stays as the fallback
+		id = 0;
+		for (unsigned int i = 1; i < _materials.size(); ++i) {
+			if (_captureFrame - _materials[i].lastUsed >= MATERIAL_RECLAIM_FRAMES
+				&& (id == 0 || _materials[i].lastUsed < _materials[id].lastUsed)) {
+				id = i;
+			}
+		}
+		if (id == 0) {
+			std::cerr << "ERROR: Ran out of materials, using the first one instead" << std::endl;
+			return 0;
+		}
+		_materialLookup.erase(_materials[id].key);
+		++_materials[id].generation;
+	}
+
+	Material& material = _materials[id];
+	material.texture = info;
+	material.shininess = shininess;
+	material.smoothness = smoothness;
+	material.key = key;
+	material.lastUsed = _captureFrame;
+	_materialUniforms[id] = vec4(shininess, smoothness, 0.0f, 0.0f);
+	updateMaterialTexture(id);
+	_materialsDirty = true;
+	_materialLookup[key] = id;
+	return id;
+}
+
 TextureInfo& RenderSystem::getTexture(string* path, bool scale) {
 	if (path == nullptr) {
 		return _defaultTextureValue;
@@ -589,147 +511,364 @@ TextureInfo& RenderSystem::getTexture(string* path, bool scale) {
 }
 
 TextureInfo& RenderSystem::loadTexture(const string& path, bool scale) {
-	Image* img = ImageLoader::loadImage(path);
-	if (scale) {
-		Image* tmp = img;
-		img = scaleImage(tmp, _textures->getWidth(), _textures->getHeight());
-		delete tmp;
-	}
-	int id = _staticTextures->size();
-	_texturePathToInfo[path] = TextureInfo(
-		id,
-		scale,
-		scale ? _textures->getWidth() : img->getWidth(),
-		scale ? _textures->getHeight() : img->getHeight()
-	);
-	_staticTextures->push_back(img);
-	_textures->setImage(id, *img, GL_UNSIGNED_BYTE);
-	_textures->genMipmaps();
+	int id = _textures->addTexture(path, scale);
+	if (id < 0) {
+		std::cerr << "ERROR: " << path << " shows the placeholder instead" << std::endl;
+		_texturePathToInfo[path] = _defaultTextureValue;
+		return _texturePathToInfo[path];
+	}
+	int width, height;
+	_textures->getSize(id, width, height);
+	_texturePathToInfo[path] = TextureInfo(id, scale, width, height);
 	return _texturePathToInfo[path];
 }
 
-Image* RenderSystem::scaleImage(Image* input, int width, int height) {
-	GLTexture tmpTex, tmpTex2;
-	Image* tmpImg = new Image(NULL, width, height);
+void RenderSystem::streamTextures() {
+	// whatever was drawn last frame counts as used, evicted textures start loading again
+	for (const RenderData& render : *_renderingList) {
+		_materials[render.material].lastUsed = _captureFrame;
+		_textures->touch(_materials[render.material].texture.id);
+	}
+	for (const UIRenderData& render : *_uiRenderingList) {
+		_materials[render.material].lastUsed = _captureFrame;
+		_textures->touch(_materials[render.material].texture.id);
+	}
 
-	GLuint imageFormat = GL_RGBA8;
-	switch (input->getChannels()) {
-	case 1:
-		imageFormat = GL_R8;
-		break;
-	case 2:
-		imageFormat = GL_RG8;
-		break;
-	case 3:
-		imageFormat = GL_RGB8;
-		break;
+	if (_textures->update(TEXTURE_UPLOADS_PER_FRAME)) {
+		for (unsigned int i = 0; i < _materials.size(); ++i) {
+			updateMaterialTexture(i);
+		}
 	}
-	tmpTex.setImage(*input, false, imageFormat, GL_UNSIGNED_BYTE);
-	tmpTex2.setImage(*tmpImg, false, GL_RGBA8, GL_UNSIGNED_BYTE);
-	_resizeInFBO->buffer(GL_COLOR_ATTACHMENT0, tmpTex);
-	_resizeOutFBO->buffer(GL_COLOR_ATTACHMENT0, tmpTex2);
-	
-	_resizeOutFBO->blit(*_resizeInFBO, input->getWidth(), input->getHeight());
-
-	_resizeOutFBO->bind(GL_FRAMEBUFFER);
-	delete tmpImg;
-	std::vector<unsigned char>* data = new std::vector<unsigned char>(width * height * 4);
-	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, &(*data)[0]);
-	RenderUtil::checkGLError("glReadPixels");
-	tmpImg = new Image(&(*data)[0], width, height, 4);
-	glClear(GL_DEPTH_BUFFER_BIT);
+}
+
+void RenderSystem::updateMaterialTexture(unsigned int material) {
+	// the placeholder's layer until the texture is resident
+	const TextureResidency::Placement& placement = _textures->getPlacement(_materials[material].texture.id);
+	_materialUniforms[material].z = (float)placement.layer;
+	_materialUniforms[material].w = (float)placement.sizeClass;
+	_materialsDirty = true;
+}
 
-	_resizeOutFBO->unbind(GL_FRAMEBUFFER);
+TextureResidency::ClassStats RenderSystem::getTextureStats(int sizeClass) const {
+	return _textures->getClassStats(sizeClass);
+}
 
-	return tmpImg;
+void RenderSystem::setBloomQuality(BloomQuality quality) {
+	_bloomQuality = quality;
 }
 
-bool RenderSystem::loadShader(string shaderName) {
+RenderSystem::BloomQuality RenderSystem::getBloomQuality() const {
+	return _bloomQuality;
+}
+
+bool RenderSystem::loadShader(ShaderType type, string shaderName) {
 	static const string shaderPath = "res/shaders/";
 	string vsh = TextLoader::load(shaderPath + shaderName + ".vsh");
 	string fsh = TextLoader::load(shaderPath + shaderName + ".fsh");
-	_shaders[shaderName] = Shader(shaderName, vsh, fsh);
-	return _shaders[shaderName].compile();
+	_shaders[type] = Shader(shaderName, vsh, fsh);
+	return _shaders[type].compile();
 }
 
-vec4 RenderSystem::convertColor(Color c) {
+vec4 RenderSystem::convertColor(Color c) const {
 	return vec4(c.getRed(), c.getGreen(), c.getBlue(), c.getAlpha());
 }
 
 void RenderSystem::accumulateList() {
-	auto renderables = ComponentManager<Renderable>::Instance().All();
-	auto uiRenderables = ComponentManager<UIComponent>::Instance().All();
-	auto cameras = ComponentManager<Camera>::Instance().All();
-	auto lights = ComponentManager<Light>::Instance().All();
-	for (Renderable* r : renderables) {
-		if (!r->GetActive()) continue;
-		Entity* e = r->GetEntity();
-		Transform t = r->getTransform();
-		_accumulatingList->push_back(
-			RenderData(
-				r->getModel(),
-				t.getWorldTransformation(),
-				r->getShininess(),
-				r->getSmoothness(),
-				r->getColor()
-			)
-		);
-		OutlineComponent* o = e->GetComponent<OutlineComponent>();
-		if (o != nullptr) {
-			Color c = o->getColor();
-			c.setAlpha(o->getWidth());
-			_outlineAccumulatingList->push_back(
-				RenderData(
-					r->getModel(),
-					t.getWorldTransformation(),
-					r->getShininess(),
-					r->getSmoothness(),
-					c
-				)
-			);
-		}
-	}
-	for (UIComponent* r : uiRenderables) {
-		Transform t = r->GetEntity()->transform;
-		vector<Model*> models = r->models;
-		Color c = r->color;
-		for (Model* m : models) {
-			_uiAccumulatingList->push_back(
-				RenderData(
-					m,
-					t.getWorldTransformation(),
-					0.0f,
-					0.0f,
-					c
-				)
-			);
-		}
-	}
+	const auto& uiRenderables = ComponentManager<UIComponent>::Instance().All();
+	const auto& cameras = ComponentManager<Camera>::Instance().All();
+	const auto& lights = ComponentManager<Light>::Instance().All();
+
+	// camera first, the sort keys need it
+	_hasCamera = false;
 	for (Camera* c : cameras) {
 		// Todo: Support for multiple cameras
 		// For now we will just take the first camera and leave;
-		_camera = c;
+		_cameraData.transform = c->getTransform().getWorldTransformation();
+		_cameraData.fov = c->getFOV();
+		_cameraData.closeClip = c->getCloseClip();
+		_cameraData.farClip = c->getFarClip();
+		_hasCamera = true;
 		break;
 	}
-	for (int i = 0; i < lights.size() && i < MAX_LIGHTS; i++) {
-		Light* l = lights[i];
+	if (_hasCamera) {
+		_frustum = Frustum(projectionMatrix() * inverse(_cameraData.transform));
+	}
+
+	captureRenderables();
+	captureOutlines();
+
+	for (UIComponent* r : uiRenderables) {
+		UIRenderData render;
+		render.transform = glm::mat4x3(r->GetEntity()->transform.getWorldTransformation());
+		render.color = convertColor(r->color);
+		render.transparent = r->IsTransparent();
+		for (Model* m : r->models) {
+			captureUIGeometry(*m->getGeometry(), render);
+			render.material = getMaterial(m->getTexture(), 0.0f, 0.0f, false);
+			_uiAccumulatingList->push_back(render);
+		}
+	}
+	_cullStats.lightsDrawn = 0;
+	_cullStats.lightsCulled = 0;
+	if (!_hasCamera) {
+		return;
+	}
+
+	// lights are shaded in view space, the lighting pass uses the camera captured with them
+	const mat4 view = inverse(_cameraData.transform);
+	const glm::mat3 viewRotation(view);
+	for (Light* l : lights) {
 		Entity* e = l->GetEntity();
+		bool point = l->getType() == Light::LightType::Point;
+		float range = point ? lightRadius(l) : 0.0f;
 
-		LightData internalLight; // The light used by the rendering system
-		internalLight.type = l->getType();
-		internalLight.blank1 = 0;
-		internalLight.blank2 = 0;
-		internalLight.blank3 = 0;
+		// point lights that can't reach anything on screen are skipped
+		if (point && (range <= 0.0f || !_frustum.intersectsSphere(e->transform.getWorldPosition(), range))) {
+			_cullStats.lightsCulled++;
+			continue;
+		}
+		_cullStats.lightsDrawn++;
+
+		LightClusters::LightData internalLight; // The light used by the rendering system
 		internalLight.color = convertColor(l->getColor());
 		internalLight.attenuation = glm::vec4(
 			l->getConstantAttenuation(),
 			l->getLinearAttenuation(),
 			l->getQuadraticAttenuation(),
-			0.0f
+			(float)l->getType()
 		);
-		internalLight.position = glm::vec4(e->transform.getWorldPosition(), 1.0f);
-		internalLight.direction = glm::vec4(e->transform.getWorldForward(), 1.0f);
+		internalLight.position = glm::vec4(vec3(view * glm::vec4(e->transform.getWorldPosition(), 1.0f)), range);
+		internalLight.direction = glm::vec4(viewRotation * e->transform.getWorldForward(), 0.0f);
+
+		_lightsAccumulating->addLight(internalLight);
+	}
+	_lightsAccumulating->build(projectionMatrix(), _cameraData.closeClip, _cameraData.farClip);
+}
 
-		_lightAccumulatingList->push_back(internalLight);
+void RenderSystem::captureRenderables() {
+	TaskScheduler& scheduler = TaskScheduler::instance();
+
+	_captureBuffers.resize(std::max(1u, scheduler.GetWorkerCount()));
+	for (CaptureBuffer& buffer : _captureBuffers) {
+		buffer.packets.clear();
+		buffer.keys.clear();
+		buffer.unresolved.clear();
+		buffer.moved.clear();
+		buffer.removed.clear();
 	}
-}
\ No newline at end of file
+
+	updateCullTree();
+
+	// only what the camera can see gets a packet
+	_visibleRenderables.clear();
+	if (_hasCamera) {
+		_cullTree.Query(
+			[this](const glm::vec3& min, const glm::vec3& max) { return _frustum.test(min, max); },
+			[this](void* data) { _visibleRenderables.push_back(static_cast<Renderable*>(data)); });
+	}
+	_cullStats.drawn = _visibleRenderables.size();
+	_cullStats.culled = _cullTree.GetLeafCount() - _visibleRenderables.size();
+
+	// Workers only read components and the IDs cached on them, so no GL and no shared writes.
+	// Each chunk appends to the buffer of the thread running it.
+	auto capture = [this, &scheduler](unsigned int begin, unsigned int end) {
+		int worker = scheduler.GetWorkerIndex();
+		CaptureBuffer& buffer = _captureBuffers[worker < 0 ? 0 : worker];
+		for (unsigned int i = begin; i < end; ++i) {
+			Renderable* r = _visibleRenderables[i];
+			if (!isResolved(r)) {
+				buffer.unresolved.push_back(r);
+				continue;
+			}
+			buffer.packets.push_back(makePacket(r));
+			buffer.keys.push_back(sortKey(buffer.packets.back()));
+		}
+	};
+	scheduler.ParallelFor((unsigned int)_visibleRenderables.size(), CAPTURE_CHUNK_SIZE, capture);
+
+	// new meshes and materials get uploaded the first time they're seen
+	for (CaptureBuffer& buffer : _captureBuffers) {
+		for (Renderable* r : buffer.unresolved) {
+			resolveRenderable(r);
+			buffer.packets.push_back(makePacket(r));
+			buffer.keys.push_back(sortKey(buffer.packets.back()));
+		}
+	}
+
+	// merge and sort, the packets don't move until the next capture
+	_sortItems.clear();
+	for (const CaptureBuffer& buffer : _captureBuffers) {
+		for (size_t i = 0; i < buffer.packets.size(); ++i) {
+			SortItem item;
+			item.key = buffer.keys[i];
+			item.packet = &buffer.packets[i];
+			_sortItems.push_back(item);
+		}
+	}
+	_sortScratch.resize(_sortItems.size());
+	RadixSort::Sort(_sortItems.data(), _sortScratch.data(), _sortItems.size());
+
+	_accumulatingList->resize(_sortItems.size());
+	for (size_t i = 0; i < _sortItems.size(); ++i) {
+		(*_accumulatingList)[i] = *_sortItems[i].packet;
+	}
+}
+
+void RenderSystem::updateCullTree() {
+	const auto& renderables = ComponentManager<Renderable>::Instance().All();
+	TaskScheduler& scheduler = TaskScheduler::instance();
+	const unsigned int frame = ++_captureFrame;
+	_cullStamps.resize(_cullTree.GetCapacity());
+
+	// Only renderables whose world transform was recomputed (or that changed geometry) get new bounds.
+	// Every leaf that is still in use gets stamped, so leaves of destroyed renderables can be found.
+	auto findChanges = [this, &renderables, &scheduler, frame](unsigned int begin, unsigned int end) {
+		int worker = scheduler.GetWorkerIndex();
+		CaptureBuffer& buffer = _captureBuffers[worker < 0 ? 0 : worker];
+		for (unsigned int i = begin; i < end; ++i) {
+			Renderable* r = renderables[i];
+			Entity* e = r->GetEntity();
+			Model* model = r->getModel();
+			if (!r->GetActive() || e == nullptr || model == nullptr) {
+				if (r->_cullProxy >= 0) buffer.removed.push_back(r);
+				continue;
+			}
+			if (r->_cullProxy >= 0) {
+				_cullStamps[r->_cullProxy] = frame;
+			}
+
+			Geometry* g = model->getGeometry();
+			unsigned int version = e->transform.getWorldVersion();
+			if (r->_cullProxy < 0 || version != r->_boundsVersion || g != r->_boundsGeometry) {
+				BoundsUpdate update;
+				update.renderable = r;
+				update.version = version;
+				AffineMath::TransformBounds(e->transform.getWorldTransformation(), g->getBoundsMin(), g->getBoundsMax(), update.min, update.max);
+				buffer.moved.push_back(update);
+			}
+		}
+	};
+	scheduler.ParallelFor((unsigned int)renderables.size(), CAPTURE_CHUNK_SIZE, findChanges);
+
+	// the tree itself is updated here, most moves stay inside the leaf's margin and cost nothing
+	for (CaptureBuffer& buffer : _captureBuffers) {
+		for (Renderable* r : buffer.removed) {
+			_cullTree.Remove(r->_cullProxy);
+			r->_cullProxy = -1;
+		}
+		for (const BoundsUpdate& update : buffer.moved) {
+			Renderable* r = update.renderable;
+			if (r->_cullProxy < 0) {
+				r->_cullProxy = _cullTree.Insert(update.min, update.max, r);
+				if (_cullStamps.size() < (size_t)_cullTree.GetCapacity())
+					_cullStamps.resize(_cullTree.GetCapacity());
+				_cullStamps[r->_cullProxy] = frame;
+			}
+			else {
+				_cullTree.Move(r->_cullProxy, update.min, update.max);
+			}
+			r->_boundsVersion = update.version;
+			r->_boundsGeometry = r->getModel()->getGeometry();
+		}
+	}
+
+	// nobody stamped these, their renderable was destroyed (don't touch it)
+	for (int proxy = 0; proxy < _cullTree.GetCapacity(); ++proxy) {
+		if (_cullTree.IsLeaf(proxy) && _cullStamps[proxy] != frame) {
+			_cullTree.Remove(proxy);
+		}
+	}
+}
+
+void RenderSystem::captureOutlines() {
+	// few objects have one, walking the outlines beats a component lookup per renderable
+	const auto& outlines = ComponentManager<OutlineComponent>::Instance().All();
+	for (OutlineComponent* o : outlines) {
+		Entity* e = o->GetEntity();
+		if (e == nullptr) continue;
+		Renderable* r = e->GetComponent<Renderable>();
+		if (r == nullptr || !r->GetActive() || r->getModel() == nullptr) continue;
+		if (r->_cullProxy >= 0 && _hasCamera
+			&& _frustum.test(_cullTree.GetMin(r->_cullProxy), _cullTree.GetMax(r->_cullProxy)) == AABBTree::OUTSIDE) {
+			continue;
+		}
+		if (!isResolved(r)) {
+			resolveRenderable(r);
+		}
+
+		RenderData outline = makePacket(r);
+		outline.color = convertColor(o->getColor());
+		outline.color.a = o->getWidth();
+		_outlineAccumulatingList->push_back(outline);
+	}
+}
+
+void RenderSystem::resolveRenderable(Renderable* r) {
+	Model* model = r->getModel();
+	r->_meshID = _meshes->getMesh(model->getGeometry());
+	r->_materialID = getMaterial(model->getTexture(), r->getShininess(), r->getSmoothness());
+	r->_materialGeneration = _materials[r->_materialID].generation;
+	r->_resolvedTexture = model->getTexture();
+}
+
+bool RenderSystem::isResolved(Renderable* r) const {
+	// the material slot may have been reused while the renderable wasn't drawn
+	return r->_meshID >= 0
+		&& r->_resolvedTexture == r->getModel()->getTexture()
+		&& _materials[r->_materialID].generation == r->_materialGeneration;
+}
+
+RenderData RenderSystem::makePacket(Renderable* r) const {
+	RenderData render;
+	render.mesh = r->_meshID;
+	render.material = r->_materialID;
+	render.transform = glm::mat4x3(r->GetEntity()->transform.getWorldTransformation());
+	render.color = convertColor(r->getColor());
+	return render;
+}
+
+mat4 RenderSystem::projectionMatrix() const {
+	float windowRatio = (_window != nullptr) ? (float)_window->getWidth() / _window->getHeight() : 1.0f;
+	return perspective(_cameraData.fov, windowRatio, _cameraData.closeClip, _cameraData.farClip);
+}
+
+float RenderSystem::lightRadius(Light* l) {
+	// distance where the attenuated light falls below 1/256 of its brightest channel
+	Color color = l->getColor();
+	float brightest = std::max(color.getRed(), std::max(color.getGreen(), color.getBlue()));
+	if (!(brightest > 0.0f)) {
+		return 0.0f;
+	}
+	float constant = l->getConstantAttenuation() - 256.0f * brightest;
+	float linear = l->getLinearAttenuation();
+	float quadratic = l->getQuadraticAttenuation();
+	if (quadratic > 0.0f) {
+		// no real root: too dim at any distance
+		float discriminant = linear * linear - 4.0f * quadratic * constant;
+		if (!(discriminant > 0.0f)) {
+			return 0.0f;
+		}
+		return std::max(0.0f, (-linear + std::sqrt(discriminant)) / (2.0f * quadratic));
+	}
+	if (linear > 0.0f) {
+		return std::max(0.0f, -constant / linear);
+	}
+	return std::numeric_limits<float>::max();
+}
+
+const RenderSystem::CullStats& RenderSystem::getCullStats() const {
+	return _cullStats;
+}
+
+uint64_t RenderSystem::sortKey(const RenderData& render) const {
+	// mesh (24 bits) | material (16 bits) | distance (24 bits)
+	// mesh and material group the instanced batches, front to back inside a batch helps early z
+	float distance = 0.0f;
+	if (_hasCamera && _cameraData.farClip > 0.0f) {
+		distance = glm::length(render.transform[3] - vec3(_cameraData.transform[3])) / _cameraData.farClip;
+	}
+	uint64_t depth = (uint64_t)(glm::clamp(distance, 0.0f, 1.0f) * 0xFFFFFF);
+	return ((uint64_t)(render.mesh & 0xFFFFFF) << 40)
+		| ((uint64_t)(render.material & 0xFFFF) << 24)
+		| depth;
+}
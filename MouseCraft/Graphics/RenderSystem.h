@@ -5,121 +5,249 @@
 #include <vector>
 #include <glm/glm.hpp>
 #include <map>
+#include <tuple>
 #include "Shader.h"
 #include "RenderData.h"
+#include "Model.h"
+#include "Color.h"
 #include "BufferObjects/VertexArrayObject.h"
 #include "BufferObjects/VertexBufferObject.h"
 #include "BufferObjects/ElementBufferObject.h"
 #include "BufferObjects/FrameBufferObject.h"
 #include "BufferObjects/UniformBufferObject.h"
-#include "CombinedGeometry.h"
+#include "MeshRegistry.h"
+#include "InstanceBatcher.h"
+#include "UIBatcher.h"
 #include "Camera.h"
 #include "GLTexture.h"
 #include "GLTextureArray.h"
 #include "Light.h"
+#include "LightClusters.h"
 #include "../Util/CpuProfiler.h"
+#include "../Util/RadixSort.h"
+#include "../Util/AABBTree.h"
+#include "Frustum.h"
 #include "TextureInfo.h"
+#include "TextureResidency.h"
 
-#define MAX_LIGHTS 50
+#define MAX_MATERIALS 1024	// must match gbuffer.vsh
+
+class Renderable;
 
 class RenderSystem : public System {
 public:
 	RenderSystem();
 	~RenderSystem();
-	void initVertexBuffers();
 	void initTextures();
 	void initRenderBuffers();
 	void setWindow(Window* window);
 	void Update(float dt) override;
+	void LateUpdate(float dt) override;
 	void swapLists();
-private:						        // Data Alignment
-	struct LightData {        // (Total: 16N)
-		Light::LightType type;	// 1N
-		int blank1;				// 1N
-		int blank2;				// 1N
-		int blank3;				// 1N
-		glm::vec4 color;		// 4N
-		glm::vec4 position;		// 4N
-		glm::vec4 direction;	// 4N
-		glm::vec4 attenuation;  // 4N (Constant, Linear, Quadratic, unused)
+
+	// What frustum culling did with the last captured frame
+	struct CullStats {
+		size_t drawn;
+		size_t culled;
+		size_t lightsDrawn;
+		size_t lightsCulled;
+	};
+	const CullStats& getCullStats() const;
+
+	// How far a point light reaches before it's too dim to see, 0 if it lights nothing
+	static float lightRadius(Light* l);
+
+	// How full one texture size class is, see TextureResidency
+	TextureResidency::ClassStats getTextureStats(int sizeClass) const;
+
+	// How many levels bloom is blurred over, starting at half resolution and halving from there.
+	// Fewer levels make a tighter glow for less fill rate.
+	enum BloomQuality {
+		BLOOM_OFF,
+		BLOOM_LOW,		// 1/2
+		BLOOM_MEDIUM,	// 1/2, 1/4
+		BLOOM_HIGH		// 1/2, 1/4, 1/8
+	};
+	void setBloomQuality(BloomQuality quality);
+	BloomQuality getBloomQuality() const;
+private:
+	// texture ID, shininess, smoothness
+	typedef std::tuple<int, float, float> MaterialKey;
+	// How a renderable looks, shared by everything using the same texture and values.
+	struct Material {
+		TextureInfo texture;
+		float shininess;
+		float smoothness;
+		MaterialKey key;
+		unsigned int lastUsed;		// capture frame it was last drawn in
+		unsigned int generation;	// bumped when the slot is reused, renderables compare it to the one they resolved
 	};
 
-	bool loadShader(std::string shaderName);
+	// Camera state captured with the render lists so drawing never touches live components.
+	struct CameraData {
+		glm::mat4 transform;
+		float fov;
+		float closeClip;
+		float farClip;
+	};
+
+	// New world bounds of a renderable whose transform or geometry changed
+	struct BoundsUpdate {
+		Renderable* renderable;
+		unsigned int version;
+		glm::vec3 min;
+		glm::vec3 max;
+	};
+
+	// Packets one worker captured, merged once every worker is done.
+	struct CaptureBuffer {
+		std::vector<RenderData> packets;
+		std::vector<uint64_t> keys;
+		std::vector<Renderable*> unresolved;	// resolving needs GL, done on the main thread
+		std::vector<BoundsUpdate> moved;
+		std::vector<Renderable*> removed;	// stopped being drawable, leave the culling tree
+		char padding[64];	// keeps the workers' vectors off each other's cache lines
+	};
+	struct SortItem {
+		uint64_t key;
+		const RenderData* packet;
+	};
+
+	enum ShaderType {
+		GBUFFER_SHADER,
+		LIGHTING_SHADER,
+		OUTLINE_SHADER,
+		UI_SHADER,
+		FINAL_SHADER,
+		BLOOM_DOWN_SHADER,
+		BLOOM_BLUR_SHADER,
+		BLOOM_UP_SHADER,
+		SHADER_COUNT
+	};
+
+	// uniform block binding points
+	enum {
+		MATERIALS_BINDING = 1
+	};
+
+	// every UI vertex of a frame, position and texture coordinate interleaved (UIBatcher::SOURCE_VERTEX_SIZE)
+	struct UIGeometry {
+		std::vector<GLfloat> vertices;
+		std::vector<GLuint> indices;
+	};
+
+	bool loadShader(ShaderType type, std::string shaderName);
 	void initShaders();
 	void setShader(Shader& s);
 	void clearShader();
 	void accumulateList();
+	void captureRenderables();
+	void updateCullTree();
+	void captureOutlines();
+	void resolveRenderable(Renderable* r);
+	bool isResolved(Renderable* r) const;
+	RenderData makePacket(Renderable* r) const;
+	uint64_t sortKey(const RenderData& render) const;
+	glm::mat4 projectionMatrix() const;
 	void clearBuffers();
 	void renderScene();
 	void gBufferPass(glm::mat4 viewMatrix, glm::mat4 projectionMatrix);
 	void outlinePass(glm::mat4 viewMatrix, glm::mat4 projectionMatrix);
-	void lightingPass();
+	void lightingPass(glm::mat4 projectionMatrix);
 	void bloomPass();
 	void finalizationPass();
 	void uiPass();
-	void combineMasterGeometry(std::vector<RenderData>& data);
-	void combineOutlineGeometry(std::vector<RenderData>& data);
-	void makeLightsViewSpace(glm::mat4 viewMatrix);
+	void captureUIGeometry(Geometry& geometry, UIRenderData& render);
+	unsigned int getMaterial(std::string* texture, float shininess, float smoothness, bool scale = true);
 	TextureInfo& getTexture(std::string* path, bool scale = true);
 	TextureInfo& loadTexture(const std::string& path, bool scaleImage = true);
-	std::vector<GLfloat>* fetchSmoothNormals(Geometry* g);
-	std::vector<GLfloat>* calcSmoothNormals(Geometry* geometry);
-	Image* scaleImage(Image* input, int width, int height);
-	glm::vec4 convertColor(Color c);
+	void streamTextures();
+	void updateMaterialTexture(unsigned int material);
+	glm::vec4 convertColor(Color c) const;
 
 	Window* _window;
 	std::vector<RenderData>* _renderingList;
 	std::vector<RenderData>* _accumulatingList;
-	std::map<std::string, Shader> _shaders;
+	Shader _shaders[SHADER_COUNT];
 	Shader* _shader;
 
-	std::vector<RenderData>* _uiRenderingList;
-	std::vector<RenderData>* _uiAccumulatingList;
+	std::vector<UIRenderData>* _uiRenderingList;
+	std::vector<UIRenderData>* _uiAccumulatingList;
+	UIGeometry _uiRenderingGeometry;
+	UIGeometry _uiAccumulatingGeometry;
 
 	std::vector<RenderData>* _outlineRenderingList;
 	std::vector<RenderData>* _outlineAccumulatingList;
 
-	VertexArrayObject* _vao;
-	VertexBufferObject* _positionVBO;
-	VertexBufferObject* _normalVBO;
-	VertexBufferObject* _texCoordVBO;
-	ElementBufferObject* _ebo;
+	// list capture, kept between frames to reuse the memory
+	std::vector<CaptureBuffer> _captureBuffers;	// one per worker
+	std::vector<SortItem> _sortItems;
+	std::vector<SortItem> _sortScratch;
+
+	// culling, every drawable renderable has a leaf that moves when its transform changes
+	AABBTree _cullTree;
+	std::vector<unsigned int> _cullStamps;	// per tree node, last capture that saw its renderable
+	unsigned int _captureFrame = 0;
+	std::vector<Renderable*> _visibleRenderables;
+	Frustum _frustum;
+	CullStats _cullStats = {};
 
 	FrameBufferObject* _fbo;
 	FrameBufferObject* _outlineFBO;
 	FrameBufferObject* _postFBO;
-	FrameBufferObject* _bloomFBO;
 
-	UniformBufferObject* _ubo;
-	Camera* _camera;
+	UniformBufferObject* _materialUBO;
+	CameraData _cameraData;
+	bool _hasCamera;
 
-	FrameBufferObject* _resizeInFBO;
-	FrameBufferObject* _resizeOutFBO;
-	
-	GLTextureArray* _textures;
+	TextureResidency* _textures;
 	GLTexture* _albedoBuffer;
 	GLTexture* _normalBuffer;
-	GLTexture* _positionBuffer;
 	GLTexture* _specularBuffer;
+	GLTexture* _depthBuffer;
 	GLTexture* _outlineBuffer;
 	GLTexture* _postBuffer;
-	GLTexture* _bloomBuffer;
 
-	CombinedGeometry* _masterGeometry;
-	CombinedGeometry* _masterOutlineGeometry;
+	// bloom mip chain, each level half the size of the one before
+	static const int BLOOM_LEVELS = BLOOM_HIGH;
+	struct BloomLevel {
+		GLTexture* blurred;		// the level's result, the next level is downsampled from it
+		GLTexture* temp;		// horizontal blur
+		FrameBufferObject* blurredFBO;
+		FrameBufferObject* tempFBO;
+		int width;
+		int height;
+	};
+	BloomLevel _bloomLevels[BLOOM_LEVELS];
+	BloomQuality _bloomQuality;
+
+	// every mesh drawn in the 3D passes lives here
+	MeshRegistry* _meshes;
+	InstanceBatcher* _gBufferBatch;
+	InstanceBatcher* _outlineBatch;
+	UIBatcher* _uiBatch;
 
 	Model* _screenQuad;
+	unsigned int _screenQuadMesh;
 	CpuProfiler profiler;
 
+	// per object matrices for the gbuffer pass, kept to reuse the memory
+	std::vector<glm::mat4> _modelViewMatrices;
+	std::vector<glm::mat4> _normalMatrices;
+
 	std::map<std::string, TextureInfo> _texturePathToInfo;
-	
-	std::map<Geometry*, std::vector<GLfloat>*> _smoothNormalCache;
+
+	// keyed by texture ID (interned by path) and values, slots nothing drew for a while are reused when full
+	std::vector<Material> _materials;
+	std::map<MaterialKey, unsigned int> _materialLookup;
+	std::vector<glm::vec4> _materialUniforms;	// Materials block contents, always MAX_MATERIALS long
+	bool _materialsDirty = false;
 
 	std::vector<Geometry*>* _staticGeometries;
-	std::vector<Image*>* _staticTextures;
 
-	std::vector<LightData>* _lightRenderingList;
-	std::vector<LightData>* _lightAccumulatingList;
+	// lights in view space, binned into the clusters of the camera they were captured with
+	LightClusters* _lightsRendering;
+	LightClusters* _lightsAccumulating;
 
 	TextureInfo _defaultTextureValue = TextureInfo(0, false, 1, 1);
 };
\ No newline at end of file
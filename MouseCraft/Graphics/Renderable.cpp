@@ -8,9 +8,15 @@
 #include <sstream>
 
 Renderable::Renderable() :
+	_model(nullptr),
 	_shininess(0.5),
-	_smoothness(25.0)
-{}
+	_smoothness(25.0),
+	_cullProxy(-1),
+	_boundsVersion(0),
+	_boundsGeometry(nullptr)
+{
+	invalidateRenderIDs();
+}
 
 Model* Renderable::getModel() {
 	return _model;
@@ -18,14 +24,16 @@ Model* Renderable::getModel() {
 
 void Renderable::setModel(Model& model) {
 	_model = &model;
+	invalidateRenderIDs();
 }
 
-Transform Renderable::getTransform() {
+const Transform& Renderable::getTransform() {
+	static const Transform none;
 	Entity* e = GetEntity();
 	if (e != nullptr) {
 		return e->transform;
 	}
-	return Transform();
+	return none;
 }
 
 Color Renderable::getColor() {
@@ -38,6 +46,7 @@ void Renderable::setColor(Color color) {
 
 void Renderable::setShininess(float f) {
 	_shininess = f;
+	invalidateRenderIDs();
 }
 
 float Renderable::getShininess() {
@@ -46,6 +55,14 @@ float Renderable::getShininess() {
 
 void Renderable::setRoughness(float f) {
 	_smoothness = f;
+	invalidateRenderIDs();
+}
+
+void Renderable::invalidateRenderIDs() {
+	_meshID = -1;
+	_materialID = -1;
+	_materialGeneration = 0;
+	_resolvedTexture = nullptr;
 }
 
 float Renderable::getSmoothness() {
@@ -87,7 +104,7 @@ Component* Renderable::CreateFromJson(json json)
 		if (json["model_gen"]["type"].get<std::string>() == "cube")
 		{
 			auto& jval = json["model_gen"]["size"];
-			c->_model = ModelGen::makeCube(jval[0].get<float>(), jval[1].get<float>(), jval[2].get<float>());
+			c->_model = ModelGen::getCube(jval[0].get<float>(), jval[1].get<float>(), jval[2].get<float>());
 		}
 		else
 		{
@@ -12,7 +12,7 @@ public:
 	Renderable();
 	Model* getModel();
 	void setModel(Model& model);
-	Transform getTransform();
+	const Transform& getTransform();
 	Color getColor();
 	void setColor(Color color);
 	void setShininess(float f);
@@ -25,6 +25,20 @@ private:
 	float _shininess;
 	float _smoothness;
 
+	// IDs the RenderSystem resolved for the current model and material, -1 until it has.
+	// Setters reset them, list capture only reads them so it can run on worker threads.
+	friend class RenderSystem;
+	int _meshID;
+	int _materialID;
+	unsigned int _materialGeneration;	// of the material slot when it was resolved
+	std::string* _resolvedTexture;	// texture the material was made for, models can swap theirs
+	void invalidateRenderIDs();
+
+	// leaf in the RenderSystem's culling tree, -1 if not in it
+	int _cullProxy;
+	unsigned int _boundsVersion;	// world transform version the leaf was fitted to
+	Geometry* _boundsGeometry;
+
 	static Component* CreateFromJson(json json);
 	static PrefabRegistrar reg;
 };
\ No newline at end of file
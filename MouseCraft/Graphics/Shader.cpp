@@ -2,11 +2,13 @@
 #include "../Loading/TextLoader.h"
 #include <glm/gtc/type_ptr.hpp>
 #include <iostream>
+#include <algorithm>
 
 using std::cerr;
 using std::endl;
 using std::string;
 using glm::mat4;
+using glm::vec2;
 using glm::vec3;
 using glm::vec4;
 using glm::value_ptr;
@@ -56,6 +58,8 @@ bool Shader::compile() {
 
 	glDeleteShader(vertShader);
 	glDeleteShader(fragShader);
+
+	reflect();
 	return true;
 }
 
@@ -89,44 +93,99 @@ GLuint Shader::getProgram() {
 	return _program;
 }
 
-void Shader::setUniformMatrix(string name, mat4 matrix) {
-	const char* cstr = name.c_str();
-	GLint pos = glGetUniformLocation(_program, cstr);
-	glUniformMatrix4fv(pos, 1, GL_FALSE, value_ptr(matrix));
+GLint Shader::getUniformLocation(UniformID name) const {
+	auto it = std::lower_bound(_uniforms.begin(), _uniforms.end(), std::make_pair(name.hash, (GLint)-1),
+		[](const std::pair<uint32_t, GLint>& a, const std::pair<uint32_t, GLint>& b) { return a.first < b.first; });
+	return (it != _uniforms.end() && it->first == name.hash) ? it->second : -1;
+}
+
+void Shader::setUniformMatrix(UniformID name, const mat4& matrix) {
+	GLint pos = getUniformLocation(name);
+	if (pos >= 0) glUniformMatrix4fv(pos, 1, GL_FALSE, value_ptr(matrix));
+}
+
+void Shader::setUniformVec2(UniformID name, vec2 vector) {
+	GLint pos = getUniformLocation(name);
+	if (pos >= 0) glUniform2f(pos, vector.x, vector.y);
+}
+
+void Shader::setUniformVec3(UniformID name, vec3 vector) {
+	GLint pos = getUniformLocation(name);
+	if (pos >= 0) glUniform3f(pos, vector.r, vector.g, vector.b);
+}
+
+void Shader::setUniformVec4(UniformID name, vec4 vector) {
+	GLint pos = getUniformLocation(name);
+	if (pos >= 0) glUniform4f(pos, vector.r, vector.g, vector.b, vector.a);
 }
 
-void Shader::setUniformVec3(string name, vec3 vector) {
-	const char* cstr = name.c_str();
-	GLint pos = glGetUniformLocation(_program, cstr);
-	glUniform3f(pos, vector.r, vector.g, vector.b);
+void Shader::setUniformTexture(UniformID name, GLuint index) {
+	GLint pos = getUniformLocation(name);
+	if (pos >= 0) glUniform1i(pos, index);
 }
 
-void Shader::setUniformVec4(string name, vec4 vector) {
-	const char* cstr = name.c_str();
-	GLint pos = glGetUniformLocation(_program, cstr);
-	glUniform4f(pos, vector.r, vector.g, vector.b, vector.a);
+void Shader::setUniformTextures(UniformID name, const GLint* indices, GLsizei count) {
+	GLint pos = getUniformLocation(name);
+	if (pos >= 0) glUniform1iv(pos, count, indices);
 }
 
-void Shader::setUniformTexture(string name, GLuint index) {
-	const char* cstr = name.c_str();
-	GLint pos = glGetUniformLocation(_program, cstr);
-	glUniform1i(pos, index);
+void Shader::setUniformInt(UniformID name, GLint value) {
+	GLint pos = getUniformLocation(name);
+	if (pos >= 0) glUniform1i(pos, value);
 }
 
-void Shader::setUniformInt(string name, GLint value) {
-	const char* cstr = name.c_str();
-	GLint pos = glGetUniformLocation(_program, cstr);
-	glUniform1i(pos, value);
+void Shader::setUniformFloat(UniformID name, GLfloat value) {
+	GLint pos = getUniformLocation(name);
+	if (pos >= 0) glUniform1f(pos, value);
 }
 
-void Shader::setUniformFloat(string name, GLfloat value) {
-	const char* cstr = name.c_str();
-	GLint pos = glGetUniformLocation(_program, cstr);
-	glUniform1f(pos, value);
+void Shader::setBindingPoint(UniformID name, GLint value) {
+	auto it = std::lower_bound(_blocks.begin(), _blocks.end(), std::make_pair(name.hash, (GLuint)0),
+		[](const std::pair<uint32_t, GLuint>& a, const std::pair<uint32_t, GLuint>& b) { return a.first < b.first; });
+	if (it != _blocks.end() && it->first == name.hash) {
+		glUniformBlockBinding(_program, it->second, value);
+	}
 }
 
-void Shader::setBindingPoint(string name, GLint value) {
-	const char* cstr = name.c_str();
-	GLuint index = glGetUniformBlockIndex(_program, cstr);
-	glUniformBlockBinding(_program, index, value);
-}
\ No newline at end of file
+void Shader::reflect() {
+	_uniforms.clear();
+	_blocks.clear();
+
+	GLint count = 0;
+	GLint maxLength = 0;
+	glGetProgramiv(_program, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(_program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+	std::vector<GLchar> name(maxLength + 1);
+	for (GLint i = 0; i < count; ++i) {
+		GLsizei length = 0;
+		GLint size = 0;
+		GLenum type = 0;
+		glGetActiveUniform(_program, i, (GLsizei)name.size(), &length, &size, &type, name.data());
+		GLint location = glGetUniformLocation(_program, name.data());
+		if (location < 0) continue; // lives in a block
+
+		// arrays are reported as "name[0]", look them up by "name"
+		string uniform(name.data(), length);
+		if (uniform.size() > 3 && uniform.compare(uniform.size() - 3, 3, "[0]") == 0) {
+			uniform.resize(uniform.size() - 3);
+		}
+		_uniforms.push_back(std::make_pair(UniformID(uniform).hash, location));
+	}
+
+	glGetProgramiv(_program, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+	glGetProgramiv(_program, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxLength);
+	name.resize(maxLength + 1);
+	for (GLint i = 0; i < count; ++i) {
+		GLsizei length = 0;
+		glGetActiveUniformBlockName(_program, i, (GLsizei)name.size(), &length, name.data());
+		_blocks.push_back(std::make_pair(UniformID(string(name.data(), length)).hash, (GLuint)i));
+	}
+
+	std::sort(_uniforms.begin(), _uniforms.end());
+	std::sort(_blocks.begin(), _blocks.end());
+	for (size_t i = 1; i < _uniforms.size(); ++i) {
+		if (_uniforms[i].first == _uniforms[i - 1].first) {
+			cerr << "ERROR: Two uniforms in shader \"" << _name << "\" hash to the same ID, rename one" << endl;
+		}
+	}
+}
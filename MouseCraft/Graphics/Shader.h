@@ -2,26 +2,54 @@
 #include "../GL/glad.h"
 #include "glm/glm.hpp"
 #include <string>
+#include <vector>
+#include <cstdint>
 #include "GLTexture.h"
 
+// Hashed uniform or uniform block name. Converts implicitly from a string literal
+// so setUniform*("color", ...) still works, but no string is built or compared.
+struct UniformID {
+	constexpr UniformID(const char* name) : hash(hashName(name, 2166136261u)) {}
+	explicit UniformID(const std::string& name) : hash(hashName(name.c_str(), 2166136261u)) {}
+
+	// FNV-1a
+	static constexpr uint32_t hashName(const char* s, uint32_t h) {
+		return (*s) ? hashName(s + 1, (h ^ (uint8_t)*s) * 16777619u) : h;
+	}
+
+	uint32_t hash;
+};
+
 class Shader {
 public:
 	Shader();
 	Shader(std::string name, std::string vertSrc, std::string fragSrc);
 	bool compile();
 	GLuint getProgram();
-	void setUniformMatrix(std::string name, glm::mat4 matrix);
-	void setUniformVec3(std::string name, glm::vec3 vector);
-	void setUniformVec4(std::string name, glm::vec4 vector);
-	void setUniformTexture(std::string name, GLuint index);
-	void setUniformInt(std::string name, GLint value);
-	void setUniformFloat(std::string name, GLfloat value);
-	void setBindingPoint(std::string name, GLint value);
+	// Location of an active uniform, -1 if the program doesn't use it
+	GLint getUniformLocation(UniformID name) const;
+	void setUniformMatrix(UniformID name, const glm::mat4& matrix);
+	void setUniformVec2(UniformID name, glm::vec2 vector);
+	void setUniformVec3(UniformID name, glm::vec3 vector);
+	void setUniformVec4(UniformID name, glm::vec4 vector);
+	void setUniformTexture(UniformID name, GLuint index);
+	// Point a sampler array at count texture units
+	void setUniformTextures(UniformID name, const GLint* indices, GLsizei count);
+	void setUniformInt(UniformID name, GLint value);
+	void setUniformFloat(UniformID name, GLfloat value);
+	// Ties a uniform block to a binding point. Sticks to the program, so once after compiling is enough.
+	void setBindingPoint(UniformID name, GLint value);
 private:
+	// Fills the location tables with every active uniform and block, done once after linking
+	void reflect();
 	void printShaderError(GLuint shader);
 	void printProgramError(GLuint program);
 	std::string vertSrc;
 	std::string fragSrc;
 	std::string _name;
 	GLuint _program;
-};
\ No newline at end of file
+
+	// sorted by hash
+	std::vector<std::pair<uint32_t, GLint>> _uniforms;
+	std::vector<std::pair<uint32_t, GLuint>> _blocks;
+};
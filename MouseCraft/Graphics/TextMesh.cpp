@@ -0,0 +1,80 @@
+#include "TextMesh.h"
+#include <map>
+#include <mutex>
+
+#define GRID_SIZE 10		// glyphs per row and column
+#define FIRST_GLYPH 32		// the space, first glyph on the grid
+#define LAST_GLYPH 126
+
+const TextMesh::FontMetrics& TextMesh::getMetrics(const std::string& font) {
+	static std::mutex mutex;
+	static std::map<std::string, FontMetrics*> fonts;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = fonts.find(font);
+	if (it != fonts.end()) {
+		return *it->second;
+	}
+
+	// rows start at the top of the texture, characters not on the grid show a space
+	FontMetrics* metrics = new FontMetrics();
+	metrics->texture = new std::string(font);
+	const float step = 1.0f / GRID_SIZE;
+	for (int c = 0; c < 256; ++c) {
+		int index = (c >= FIRST_GLYPH && c <= LAST_GLYPH) ? c - FIRST_GLYPH : 0;
+		float u = step * (index % GRID_SIZE);
+		float v = 1.0f - step * (index / GRID_SIZE);
+		metrics->glyphs[c] = glm::vec4(u, v - step, u + step, v);
+	}
+	fonts[font] = metrics;
+	return *metrics;
+}
+
+void TextMesh::build(Geometry& geometry, const std::string& text, const FontMetrics& font, float glyphWidth, float glyphHeight) {
+	const size_t count = text.length();
+	std::vector<GLfloat>& vertices = geometry.getVertexData();
+	std::vector<GLfloat>& normals = geometry.getNormalData();
+	std::vector<GLfloat>& texCoords = geometry.getTexCoordData();
+	std::vector<GLuint>& indices = geometry.getIndices();
+	vertices.resize(count * 12);
+	normals.resize(count * 12);
+	texCoords.resize(count * 8);
+	indices.resize(count * 6);
+
+	// same corners and winding as ModelGen::makeQuad facing Z
+	const float halfWidth = glyphWidth / 2.0f;
+	const float halfHeight = glyphHeight / 2.0f;
+	for (size_t i = 0; i < count; ++i) {
+		const glm::vec4& uv = font.glyphs[(unsigned char)text[i]];
+		const float left = glyphWidth * i - halfWidth;
+		const float right = left + glyphWidth;
+
+		GLfloat* v = &vertices[i * 12];
+		v[0] = left;	v[1] = -halfHeight;	v[2] = 0.0f;
+		v[3] = right;	v[4] = -halfHeight;	v[5] = 0.0f;
+		v[6] = left;	v[7] = halfHeight;	v[8] = 0.0f;
+		v[9] = right;	v[10] = halfHeight;	v[11] = 0.0f;
+
+		GLfloat* n = &normals[i * 12];
+		for (int j = 0; j < 12; j += 3) {
+			n[j] = 0.0f;
+			n[j + 1] = 0.0f;
+			n[j + 2] = 1.0f;
+		}
+
+		GLfloat* t = &texCoords[i * 8];
+		t[0] = uv.x;	t[1] = uv.y;
+		t[2] = uv.z;	t[3] = uv.y;
+		t[4] = uv.x;	t[5] = uv.w;
+		t[6] = uv.z;	t[7] = uv.w;
+
+		GLuint* e = &indices[i * 6];
+		const GLuint first = (GLuint)(i * 4);
+		e[0] = first;
+		e[1] = first + 1;
+		e[2] = first + 3;
+		e[3] = first;
+		e[4] = first + 3;
+		e[5] = first + 2;
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <string>
+#include "Geometry.h"
+
+/// <summary>
+/// Builds a line of bitmap font text into a single mesh, one quad per glyph, so a whole
+/// text block is drawn with one draw call. Rebuilding reuses the geometry's memory.
+/// </summary>
+class TextMesh {
+public:
+	/// <summary>
+	/// Where every character is on a font's texture. Made once per font and kept for the
+	/// rest of the program, so texture is a stable pointer materials can be looked up by.
+	/// </summary>
+	struct FontMetrics {
+		std::string* texture;
+		glm::vec4 glyphs[256];	// texture coordinates of the bottom left and top right corner
+	};
+
+	/// <summary>
+	/// Get the metrics of a font, fonts are a grid of 10 x 10 glyphs starting at the space character.
+	/// </summary>
+	/// <param name="font">Path of the font's texture</param>
+	static const FontMetrics& getMetrics(const std::string& font);
+
+	/// <summary>
+	/// Replace the contents of geometry with a quad for every character of text. The first
+	/// glyph is centered on the origin and the rest follow it to the right.
+	/// </summary>
+	/// <param name="glyphWidth">Distance from one glyph to the next</param>
+	/// <param name="glyphHeight">Height of a glyph</param>
+	static void build(Geometry& geometry, const std::string& text, const FontMetrics& font, float glyphWidth, float glyphHeight);
+};
@@ -0,0 +1,326 @@
+#include "TextureResidency.h"
+#include "../Loading/ImageLoader.h"
+#include <algorithm>
+#include <iostream>
+
+#define ATLAS_MAX_SIZE 1024	// larger unscaled images get a layer of their own
+#define INITIAL_LAYERS 2
+
+// layer size and mip levels of each class, the atlas first
+static const int CLASS_SIZES[TextureResidency::CLASS_COUNT] = { 2048, 256, 512, 1024, 2048 };
+static const int CLASS_LEVELS[TextureResidency::CLASS_COUNT] = { 3, 5, 6, 7, 8 };
+
+// atlas rectangles start on multiples of this so they stay aligned in every mip level,
+// and keep at least this much space to their neighbours so filtering doesn't bleed
+static const int ATLAS_ALIGNMENT = 1 << (CLASS_LEVELS[TextureResidency::ATLAS_CLASS] - 1);
+
+static int atlasSize(int size) {
+	return (size + ATLAS_ALIGNMENT - 1) / ATLAS_ALIGNMENT * ATLAS_ALIGNMENT + ATLAS_ALIGNMENT;
+}
+
+TextureResidency::TextureResidency(size_t budget) :
+	_budget(budget), _allocated(0), _maxLayers(256), _frame(0), _changed(false), _placeholder(-1) {
+	glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &_maxLayers);
+	_placeholderPlacement = Placement{ ATLAS_CLASS, 0, glm::vec4(0.0f) };
+	for (int i = 0; i < CLASS_COUNT; ++i) {
+		_classes[i].size = CLASS_SIZES[i];
+		_classes[i].levels = CLASS_LEVELS[i];
+		_classes[i].array = nullptr;
+		_classes[i].evictions = 0;
+	}
+}
+
+TextureResidency::~TextureResidency() {
+	for (SizeClass& c : _classes) {
+		delete c.array;
+	}
+}
+
+int TextureResidency::setPlaceholder(const std::string& path) {
+	int id = create(path, true);
+	if (id < 0 || !reserve(id)) {
+		return -1;
+	}
+
+	// skips the loader, it has to be there before the first frame
+	Texture& t = _textures[id];
+	TextureStreamer::Destination destination = { _classes[t.sizeClass].array, t.layer, t.x, t.y, t.width, t.height };
+	if (!_streamer.loadNow(path, destination)) {
+		t.state = FAILED;
+		return -1;
+	}
+	t.state = RESIDENT;
+	_placeholder = id;
+	_placeholderPlacement = t.placement;
+	return id;
+}
+
+int TextureResidency::addTexture(const std::string& path, bool scale) {
+	int id = create(path, scale);
+	if (id >= 0 && !load(id)) {
+		std::cerr << "ERROR: No room for " << path << " within the texture budget, it loads once something else is evicted" << std::endl;
+	}
+	return id;
+}
+
+int TextureResidency::create(const std::string& path, bool scale) {
+	int width, height;
+	if (!ImageLoader::getImageSize(path, width, height)) {
+		std::cerr << "ERROR: Could not read " << path << std::endl;
+		return -1;
+	}
+
+	// the smallest class the image fits in, or the atlas if it's small and keeps its size
+	const int largest = std::max(width, height);
+	int sizeClass = CLASS_COUNT - 1;
+	for (int i = CLASS_COUNT - 1; i > ATLAS_CLASS; --i) {
+		if (CLASS_SIZES[i] >= largest) {
+			sizeClass = i;
+		}
+	}
+	if (!scale && largest <= ATLAS_MAX_SIZE) {
+		sizeClass = ATLAS_CLASS;
+	}
+
+	Texture t;
+	t.path = path;
+	t.sizeClass = sizeClass;
+	t.width = scale ? CLASS_SIZES[sizeClass] : std::min(width, CLASS_SIZES[sizeClass]);
+	t.height = scale ? CLASS_SIZES[sizeClass] : std::min(height, CLASS_SIZES[sizeClass]);
+	t.layer = -1;
+	t.x = 0;
+	t.y = 0;
+	t.state = EVICTED;
+	t.lastUse = _frame;
+	t.placement = _placeholderPlacement;
+	_textures.push_back(t);
+	return (int)_textures.size() - 1;
+}
+
+void TextureResidency::touch(int texture) {
+	if (texture < 0 || texture >= (int)_textures.size()) {
+		return;
+	}
+	Texture& t = _textures[texture];
+	t.lastUse = _frame;
+	if (t.state == EVICTED) {
+		load(texture);
+	}
+	else if (t.layer >= 0) {
+		_classes[t.sizeClass].layers[t.layer].lastUse = _frame;
+	}
+}
+
+bool TextureResidency::update(int maxUploads) {
+	for (const TextureStreamer::Finished& finished : _streamer.update(maxUploads)) {
+		Texture& t = _textures[finished.handle];
+		Layer& layer = _classes[t.sizeClass].layers[t.layer];
+		--layer.loading;
+		if (finished.uploaded) {
+			t.state = RESIDENT;
+			_changed = true;
+		}
+		else {
+			// packed space stays taken until the layer is cleared
+			t.state = FAILED;
+			layer.textures.erase(std::find(layer.textures.begin(), layer.textures.end(), finished.handle));
+			t.layer = -1;
+		}
+	}
+	++_frame;
+
+	bool changed = _changed;
+	_changed = false;
+	return changed;
+}
+
+const TextureResidency::Placement& TextureResidency::getPlacement(int texture) const {
+	if (texture < 0 || texture >= (int)_textures.size() || _textures[texture].state != RESIDENT) {
+		return _placeholderPlacement;
+	}
+	return _textures[texture].placement;
+}
+
+void TextureResidency::getSize(int texture, int& width, int& height) const {
+	width = _textures[texture].width;
+	height = _textures[texture].height;
+}
+
+void TextureResidency::bind(Shader& shader, UniformID samplers, GLuint firstUnit) {
+	GLint units[CLASS_COUNT];
+	for (int i = 0; i < CLASS_COUNT; ++i) {
+		units[i] = firstUnit + i;
+		glActiveTexture(GL_TEXTURE0 + units[i]);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, _classes[i].array ? _classes[i].array->getID() : 0);
+	}
+	shader.setUniformTextures(samplers, units, CLASS_COUNT);
+}
+
+TextureResidency::ClassStats TextureResidency::getClassStats(int sizeClass) const {
+	const SizeClass& c = _classes[sizeClass];
+	ClassStats stats = {};
+	stats.size = c.size;
+	stats.layers = (int)c.layers.size();
+	stats.evictions = c.evictions;
+	stats.bytes = layerBytes(c) * c.layers.size();
+
+	double usedTexels = 0.0;
+	for (const Layer& layer : c.layers) {
+		if (!layer.textures.empty()) {
+			++stats.usedLayers;
+		}
+		for (int id : layer.textures) {
+			++stats.textures;
+			usedTexels += (double)_textures[id].width * _textures[id].height;
+		}
+	}
+	if (!c.layers.empty()) {
+		stats.occupancy = (float)(usedTexels / ((double)c.size * c.size * c.layers.size()));
+	}
+	return stats;
+}
+
+size_t TextureResidency::getAllocatedBytes() const {
+	return _allocated;
+}
+
+size_t TextureResidency::getBudget() const {
+	return _budget;
+}
+
+void TextureResidency::setBudget(size_t budget) {
+	// arrays don't shrink, a smaller budget only stops them growing
+	_budget = budget;
+}
+
+bool TextureResidency::load(int texture) {
+	if (!reserve(texture)) {
+		return false;
+	}
+	Texture& t = _textures[texture];
+	++_classes[t.sizeClass].layers[t.layer].loading;
+	t.state = LOADING;
+
+	TextureStreamer::Destination destination = { _classes[t.sizeClass].array, t.layer, t.x, t.y, t.width, t.height };
+	_streamer.request(texture, t.path, destination);
+	return true;
+}
+
+bool TextureResidency::reserve(int texture) {
+	Texture& t = _textures[texture];
+	if (!allocate(t)) {
+		return false;
+	}
+	SizeClass& c = _classes[t.sizeClass];
+	Layer& layer = c.layers[t.layer];
+	layer.textures.push_back(texture);
+	layer.lastUse = std::max(layer.lastUse, t.lastUse);
+
+	const float size = (float)c.size;
+	if (t.sizeClass == ATLAS_CLASS) {
+		// half a texel in from the edges, so filtering never reaches a neighbour
+		t.placement = Placement{ t.sizeClass, t.layer,
+			glm::vec4((t.x + 0.5f) / size, (t.y + 0.5f) / size, (t.width - 1.0f) / size, (t.height - 1.0f) / size) };
+	}
+	else {
+		t.placement = Placement{ t.sizeClass, t.layer, glm::vec4(0.0f, 0.0f, t.width / size, t.height / size) };
+	}
+	return true;
+}
+
+bool TextureResidency::allocate(Texture& texture) {
+	SizeClass& c = _classes[texture.sizeClass];
+	const bool packed = texture.sizeClass == ATLAS_CLASS;
+	auto place = [&](int layer) {
+		Layer& l = c.layers[layer];
+		if (packed) {
+			if (!l.packer.Insert(atlasSize(texture.width), atlasSize(texture.height), texture.x, texture.y)) {
+				return false;
+			}
+		}
+		else if (!l.textures.empty()) {
+			return false;
+		}
+		texture.layer = layer;
+		return true;
+	};
+
+	// free space first, then a bigger array, then whatever was drawn longest ago
+	for (int i = 0; i < (int)c.layers.size(); ++i) {
+		if (place(i)) {
+			return true;
+		}
+	}
+	const int oldLayers = (int)c.layers.size();
+	if (grow(c)) {
+		for (int i = oldLayers; i < (int)c.layers.size(); ++i) {
+			if (place(i)) {
+				return true;
+			}
+		}
+	}
+	int victim = findVictim(c);
+	if (victim >= 0) {
+		evict(c, victim);
+		return place(victim);
+	}
+	return false;
+}
+
+bool TextureResidency::grow(SizeClass& c) {
+	const int oldLayers = (int)c.layers.size();
+	const size_t bytes = layerBytes(c);
+	int layers = std::min(oldLayers ? oldLayers * 2 : INITIAL_LAYERS, _maxLayers);
+	if (_allocated + (layers - oldLayers) * bytes > _budget) {
+		layers = oldLayers + (int)((_budget - std::min(_budget, _allocated)) / bytes);
+	}
+	if (layers <= oldLayers) {
+		return false;
+	}
+
+	if (c.array) {
+		c.array->setLayers(layers);
+	}
+	else {
+		c.array = new GLTextureArray(c.size, c.size, layers, c.levels, GL_SRGB8_ALPHA8);
+	}
+	Layer empty = { std::vector<int>(), 0, 0, RectPacker(c.size, c.size) };
+	c.layers.resize(layers, empty);
+	_allocated += (layers - oldLayers) * bytes;
+	_changed = true;
+	return true;
+}
+
+int TextureResidency::findVictim(const SizeClass& c) const {
+	// not while loading, and not if it was drawn this frame or the last, those are likely drawn again
+	int victim = -1;
+	for (int i = 0; i < (int)c.layers.size(); ++i) {
+		const Layer& layer = c.layers[i];
+		if (layer.textures.empty() || layer.loading > 0 || layer.lastUse + 1 >= _frame) {
+			continue;
+		}
+		if (std::find(layer.textures.begin(), layer.textures.end(), _placeholder) != layer.textures.end()) {
+			continue;
+		}
+		if (victim < 0 || layer.lastUse < c.layers[victim].lastUse) {
+			victim = i;
+		}
+	}
+	return victim;
+}
+
+void TextureResidency::evict(SizeClass& c, int layer) {
+	Layer& l = c.layers[layer];
+	for (int id : l.textures) {
+		_textures[id].state = EVICTED;
+		_textures[id].layer = -1;
+	}
+	l.textures.clear();
+	l.packer.Clear();
+	++c.evictions;
+	_changed = true;
+}
+
+size_t TextureResidency::layerBytes(const SizeClass& c) {
+	return TextureStreamer::chainSize(c.size, c.size, c.levels);
+}
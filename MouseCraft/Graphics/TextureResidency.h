@@ -0,0 +1,149 @@
+#pragma once
+#include "../GL/glad.h"
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include "GLTextureArray.h"
+#include "TextureStreamer.h"
+#include "Shader.h"
+#include "../Util/RectPacker.h"
+
+/// <summary>
+/// Decides where every texture lives on the GPU and which ones stay there.
+/// Textures are sorted into size classes, one texture array per class:
+///		class 0		shared 2048 layers, small unscaled images (UI, fonts) are packed into them
+///		class 1-4	256, 512, 1024 and 2048 layers, one texture each
+/// A scaled texture is stretched to the smallest class that holds its larger side, so a
+/// 250x250 image takes a 256 layer instead of a 2048 one. Arrays are created when their class
+/// is first used and double in layers as it fills up, as long as everything stays within the
+/// budget. Past that the least recently drawn layer of the class is evicted; its textures show
+/// the placeholder and load again the next time they are drawn.
+///
+/// Shaders get one sampler2DArray per class, see bind(). GL thread only.
+/// </summary>
+class TextureResidency {
+public:
+	static const int CLASS_COUNT = 5;	// must match gbuffer.fsh and ui.fsh
+	static const int ATLAS_CLASS = 0;
+
+	/// <summary>
+	/// How to sample a texture
+	/// </summary>
+	struct Placement {
+		int sizeClass;
+		int layer;
+		glm::vec4 region;	// offset and size of the texture in the layer, in texture coordinates
+	};
+
+	/// <summary>
+	/// How full a size class is
+	/// </summary>
+	struct ClassStats {
+		int size;			// width and height of a layer
+		int layers;			// allocated
+		int usedLayers;		// holding at least one texture
+		int textures;		// resident or loading
+		int evictions;		// layers evicted since the start
+		float occupancy;	// fraction of the allocated texels textures use
+		size_t bytes;		// video memory of the array, mips included
+	};
+
+	/// <param name="budget">Bytes all the arrays together may use</param>
+	explicit TextureResidency(size_t budget);
+	~TextureResidency();
+
+	/// <summary>
+	/// Load the texture shown for everything else until it's there. Loaded before returning, never evicted.
+	/// </summary>
+	/// <returns>The texture's ID, -1 if it couldn't be loaded</returns>
+	int setPlaceholder(const std::string& path);
+
+	/// <summary>
+	/// Add a texture and start loading it.
+	/// </summary>
+	/// <param name="scale">Stretch to fill a whole layer (3D textures), otherwise keep the image's size (UI)</param>
+	/// <returns>The texture's ID, -1 if the file can't be read</returns>
+	int addTexture(const std::string& path, bool scale);
+
+	/// <summary>
+	/// Mark a texture as drawn this frame. Evicted textures start loading again.
+	/// </summary>
+	void touch(int texture);
+
+	/// <summary>
+	/// Upload finished loads and start a new frame.
+	/// </summary>
+	/// <returns>True if any placement changed since the last call</returns>
+	bool update(int maxUploads);
+
+	/// <summary>
+	/// Where a texture is, the placeholder's placement until it's resident
+	/// </summary>
+	const Placement& getPlacement(int texture) const;
+
+	/// <summary>
+	/// Size of a texture in its layer
+	/// </summary>
+	void getSize(int texture, int& width, int& height) const;
+
+	/// <summary>
+	/// Bind every class's array to a texture unit, starting at firstUnit, and point the sampler array at them.
+	/// </summary>
+	void bind(Shader& shader, UniformID samplers, GLuint firstUnit);
+
+	ClassStats getClassStats(int sizeClass) const;
+	size_t getAllocatedBytes() const;
+	size_t getBudget() const;
+	void setBudget(size_t budget);
+private:
+	enum State { EVICTED, LOADING, RESIDENT, FAILED };
+
+	struct Texture {
+		std::string path;
+		int width;		// size in the layer
+		int height;
+		int sizeClass;
+		int layer;
+		int x;
+		int y;
+		State state;
+		unsigned int lastUse;
+		Placement placement;
+	};
+
+	struct Layer {
+		std::vector<int> textures;
+		unsigned int lastUse;
+		int loading;
+		RectPacker packer;	// atlas class only
+	};
+
+	struct SizeClass {
+		int size;
+		int levels;
+		GLTextureArray* array;
+		std::vector<Layer> layers;
+		int evictions;
+	};
+
+	int create(const std::string& path, bool scale);
+	bool load(int texture);
+	bool reserve(int texture);
+	bool allocate(Texture& texture);
+	bool grow(SizeClass& sizeClass);
+	int findVictim(const SizeClass& sizeClass) const;
+	void evict(SizeClass& sizeClass, int layer);
+	static size_t layerBytes(const SizeClass& sizeClass);
+
+	size_t _budget;
+	size_t _allocated;
+	int _maxLayers;
+	unsigned int _frame;
+	bool _changed;
+	int _placeholder;
+	Placement _placeholderPlacement;
+
+	SizeClass _classes[CLASS_COUNT];
+	std::vector<Texture> _textures;
+	TextureStreamer _streamer;
+};
@@ -0,0 +1,353 @@
+#include "TextureStreamer.h"
+#include "../Loading/ImageLoader.h"
+#include "RenderUtil.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+// sRGB <-> linear tables for averaging mip levels
+struct SrgbTables {
+	float toLinear[256];
+	unsigned char fromLinear[4096];
+
+	SrgbTables() {
+		for (int i = 0; i < 256; ++i) {
+			float c = i / 255.0f;
+			toLinear[i] = (c <= 0.04045f) ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+		}
+		for (int i = 0; i < 4096; ++i) {
+			float l = i / 4095.0f;
+			float c = (l <= 0.0031308f) ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+			fromLinear[i] = (unsigned char)std::min(255.0f, c * 255.0f + 0.5f);
+		}
+	}
+};
+
+static const SrgbTables& srgbTables() {
+	static const SrgbTables tables;
+	return tables;
+}
+
+// levels the destination's array has, but none smaller than 1x1 for the image
+static int levelsFor(const TextureStreamer::Destination& d) {
+	int levels = 1;
+	while ((d.width >> levels) > 0 || (d.height >> levels) > 0) {
+		++levels;
+	}
+	return std::min(levels, d.target->getMipmapLevels());
+}
+
+// any channel count to RGBA, missing channels are 0 and alpha is opaque like a GL upload would make them
+static void expandToRGBA(Image& image, std::vector<unsigned char>& out) {
+	const int channels = image.getChannels();
+	const size_t count = (size_t)image.getWidth() * image.getHeight();
+	const unsigned char* in = image.getData();
+	out.resize(count * 4);
+	for (size_t i = 0; i < count; ++i) {
+		for (int c = 0; c < 4; ++c) {
+			out[i * 4 + c] = (c < channels) ? in[i * channels + c] : (c == 3 ? 255 : 0);
+		}
+	}
+}
+
+// bilinear, sampling at texel centers
+static void resize(const unsigned char* src, int srcWidth, int srcHeight, unsigned char* dst, int dstWidth, int dstHeight) {
+	const float scaleX = (float)srcWidth / dstWidth;
+	const float scaleY = (float)srcHeight / dstHeight;
+	for (int y = 0; y < dstHeight; ++y) {
+		float sy = std::max(0.0f, (y + 0.5f) * scaleY - 0.5f);
+		int y0 = std::min((int)sy, srcHeight - 1);
+		int y1 = std::min(y0 + 1, srcHeight - 1);
+		float fy = std::min(sy - y0, 1.0f);
+		const unsigned char* row0 = src + (size_t)y0 * srcWidth * 4;
+		const unsigned char* row1 = src + (size_t)y1 * srcWidth * 4;
+		unsigned char* out = dst + (size_t)y * dstWidth * 4;
+		for (int x = 0; x < dstWidth; ++x) {
+			float sx = std::max(0.0f, (x + 0.5f) * scaleX - 0.5f);
+			int x0 = std::min((int)sx, srcWidth - 1);
+			int x1 = std::min(x0 + 1, srcWidth - 1);
+			float fx = std::min(sx - x0, 1.0f);
+			for (int c = 0; c < 4; ++c) {
+				float top = row0[x0 * 4 + c] + (row0[x1 * 4 + c] - row0[x0 * 4 + c]) * fx;
+				float bottom = row1[x0 * 4 + c] + (row1[x1 * 4 + c] - row1[x0 * 4 + c]) * fx;
+				out[x * 4 + c] = (unsigned char)(top + (bottom - top) * fy + 0.5f);
+			}
+		}
+	}
+}
+
+// 2x2 box filter, odd edges repeat their last texel
+static void downsample(const unsigned char* src, int srcWidth, int srcHeight, unsigned char* dst, int dstWidth, int dstHeight) {
+	const SrgbTables& tables = srgbTables();
+	for (int y = 0; y < dstHeight; ++y) {
+		const unsigned char* row0 = src + (size_t)std::min(y * 2, srcHeight - 1) * srcWidth * 4;
+		const unsigned char* row1 = src + (size_t)std::min(y * 2 + 1, srcHeight - 1) * srcWidth * 4;
+		unsigned char* out = dst + (size_t)y * dstWidth * 4;
+		for (int x = 0; x < dstWidth; ++x) {
+			const int x0 = std::min(x * 2, srcWidth - 1) * 4;
+			const int x1 = std::min(x * 2 + 1, srcWidth - 1) * 4;
+			for (int c = 0; c < 3; ++c) {
+				float linear = (tables.toLinear[row0[x0 + c]] + tables.toLinear[row0[x1 + c]] +
+					tables.toLinear[row1[x0 + c]] + tables.toLinear[row1[x1 + c]]) * 0.25f;
+				out[x * 4 + c] = tables.fromLinear[(int)(linear * 4095.0f + 0.5f)];
+			}
+			out[x * 4 + 3] = (unsigned char)((row0[x0 + 3] + row0[x1 + 3] + row1[x0 + 3] + row1[x1 + 3] + 2) / 4);
+		}
+	}
+}
+
+TextureStreamer::TextureStreamer() :
+	_inFlight(0), _stopping(false), _pbo(0), _mapped(nullptr), _slotSize(0), _nextSlot(0) {
+	for (Slot& slot : _slots) {
+		slot.offset = 0;
+		slot.fence = 0;
+	}
+	_loader = std::thread(&TextureStreamer::loaderLoop, this);
+}
+
+TextureStreamer::~TextureStreamer() {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stopping = true;
+	}
+	_wake.notify_all();
+	_loader.join();
+
+	for (Slot& slot : _slots) {
+		if (slot.fence) {
+			glDeleteSync(slot.fence);
+		}
+	}
+	if (_pbo) {
+		if (_mapped) {
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _pbo);
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		}
+		glDeleteBuffers(1, &_pbo);
+	}
+}
+
+void TextureStreamer::request(int handle, const std::string& path, const Destination& destination) {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_jobs.push_back(Job{ handle, path, destination, levelsFor(destination) });
+	}
+	_wake.notify_one();
+}
+
+bool TextureStreamer::loadNow(const std::string& path, const Destination& destination) {
+	Result result;
+	prepare(Job{ -1, path, destination, levelsFor(destination) }, result);
+	if (result.pixels.empty()) {
+		return false;
+	}
+	// straight from memory, nothing else is waiting on this upload
+	const Destination& d = result.destination;
+	size_t offset = 0;
+	for (int level = 0; level < result.levels; ++level) {
+		int width = std::max(1, d.width >> level);
+		int height = std::max(1, d.height >> level);
+		d.target->setImageLevel(d.layer, level, d.x >> level, d.y >> level, width, height, GL_RGBA, GL_UNSIGNED_BYTE, &result.pixels[offset]);
+		offset += (size_t)width * height * 4;
+	}
+	return true;
+}
+
+const std::vector<TextureStreamer::Finished>& TextureStreamer::update(int maxUploads) {
+	_finished.clear();
+	for (int n = 0; n < maxUploads; ++n) {
+		Result result;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			if (_done.empty()) {
+				break;
+			}
+			result = std::move(_done.front());
+			_done.pop_front();
+		}
+		if (result.pixels.empty()) {
+			// the loader already said why
+			_finished.push_back(Finished{ result.handle, false });
+			continue;
+		}
+
+		if (!ensureRing(result.pixels.size())) {
+			// already taken from _done, report it so residency shows the placeholder and frees the layer
+			_finished.push_back(Finished{ result.handle, false });
+			continue;
+		}
+
+		// the GPU may still be reading this slot's last upload, try again next frame
+		Slot& slot = _slots[_nextSlot];
+		if (slot.fence) {
+			GLenum status = glClientWaitSync(slot.fence, 0, 0);
+			if (status == GL_TIMEOUT_EXPIRED) {
+				std::lock_guard<std::mutex> lock(_mutex);
+				_done.push_front(std::move(result));
+				break;
+			}
+			glDeleteSync(slot.fence);
+			slot.fence = 0;
+		}
+
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _pbo);
+		if (_mapped) {
+			memcpy(_mapped + slot.offset, result.pixels.data(), result.pixels.size());
+		}
+		else {
+			void* dst = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, slot.offset, result.pixels.size(),
+				GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+			if (!dst) {
+				RenderUtil::checkGLError("glMapBufferRange");
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+				std::lock_guard<std::mutex> lock(_mutex);
+				_done.push_front(std::move(result));
+				break;
+			}
+			memcpy(dst, result.pixels.data(), result.pixels.size());
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		}
+		upload(result, slot.offset);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		_nextSlot = (_nextSlot + 1) % RING_SLOTS;
+		_finished.push_back(Finished{ result.handle, true });
+	}
+	return _finished;
+}
+
+size_t TextureStreamer::getPendingCount() const {
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _jobs.size() + _inFlight + _done.size();
+}
+
+size_t TextureStreamer::chainSize(int width, int height, int levels) {
+	size_t size = 0;
+	for (int level = 0; level < levels; ++level) {
+		size += (size_t)std::max(1, width >> level) * std::max(1, height >> level) * 4;
+	}
+	return size;
+}
+
+void TextureStreamer::loaderLoop() {
+	while (true) {
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_wake.wait(lock, [this] { return _stopping || !_jobs.empty(); });
+			if (_stopping) {
+				return;
+			}
+			job = std::move(_jobs.front());
+			_jobs.pop_front();
+			++_inFlight;
+		}
+
+		Result result;
+		prepare(job, result);
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		_done.push_back(std::move(result));
+		--_inFlight;
+	}
+}
+
+void TextureStreamer::prepare(const Job& job, Result& result) {
+	const Destination& d = job.destination;
+	result.handle = job.handle;
+	result.destination = d;
+	result.levels = job.levels;
+	result.pixels.clear();
+
+	Image* image = ImageLoader::loadImage(job.path);
+	if (!image) {
+		return;
+	}
+	std::vector<unsigned char> rgba;
+	expandToRGBA(*image, rgba);
+
+	result.pixels.resize(chainSize(d.width, d.height, result.levels));
+	if (image->getWidth() == d.width && image->getHeight() == d.height) {
+		memcpy(result.pixels.data(), rgba.data(), rgba.size());
+	}
+	else {
+		resize(rgba.data(), image->getWidth(), image->getHeight(), result.pixels.data(), d.width, d.height);
+	}
+	delete image;
+
+	size_t offset = 0;
+	for (int level = 1; level < result.levels; ++level) {
+		int srcWidth = std::max(1, d.width >> (level - 1));
+		int srcHeight = std::max(1, d.height >> (level - 1));
+		size_t next = offset + (size_t)srcWidth * srcHeight * 4;
+		downsample(&result.pixels[offset], srcWidth, srcHeight, &result.pixels[next],
+			std::max(1, d.width >> level), std::max(1, d.height >> level));
+		offset = next;
+	}
+}
+
+void TextureStreamer::upload(const Result& result, size_t offset) {
+	const Destination& d = result.destination;
+	for (int level = 0; level < result.levels; ++level) {
+		int width = std::max(1, d.width >> level);
+		int height = std::max(1, d.height >> level);
+		// with a pixel unpack buffer bound the pointer is an offset into it
+		d.target->setImageLevel(d.layer, level, d.x >> level, d.y >> level, width, height, GL_RGBA, GL_UNSIGNED_BYTE, (const void*)offset);
+		offset += (size_t)width * height * 4;
+	}
+}
+
+bool TextureStreamer::ensureRing(size_t slotSize) {
+	if (slotSize <= _slotSize) {
+		return true;
+	}
+
+	// growing replaces the buffer, wait for the uploads still reading the old one
+	for (Slot& slot : _slots) {
+		if (slot.fence) {
+			glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+			glDeleteSync(slot.fence);
+			slot.fence = 0;
+		}
+	}
+	if (_pbo) {
+		if (_mapped) {
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _pbo);
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+			_mapped = nullptr;
+		}
+		glDeleteBuffers(1, &_pbo);
+		_pbo = 0;
+	}
+
+	const size_t size = slotSize * RING_SLOTS;
+	glGenBuffers(1, &_pbo);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _pbo);
+	if (GLAD_GL_ARB_buffer_storage) {
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_PIXEL_UNPACK_BUFFER, size, nullptr, flags);
+		_mapped = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, flags);
+	}
+	else {
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	RenderUtil::checkGLError("texture upload buffer");
+	if (GLAD_GL_ARB_buffer_storage && !_mapped) {
+		std::cerr << "ERROR: Could not map the texture upload buffer" << std::endl;
+		glDeleteBuffers(1, &_pbo);
+		_pbo = 0;
+		_slotSize = 0;
+		return false;
+	}
+
+	_slotSize = slotSize;
+	for (int i = 0; i < RING_SLOTS; ++i) {
+		_slots[i].offset = slotSize * i;
+	}
+	_nextSlot = 0;
+	return true;
+}
@@ -0,0 +1,118 @@
+#pragma once
+#include "../GL/glad.h"
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "GLTextureArray.h"
+
+/// <summary>
+/// Loads texture files into the layers of GLTextureArrays without stalling the render thread.
+/// A loader thread decodes each file, resizes it to its destination and builds its mip chain
+/// (box filter, averaged in linear space because the arrays are sRGB). update() copies the
+/// finished chains into a ring of pixel buffer objects and uploads from there, so the driver
+/// can copy to the GPU while the frame goes on. The ring is mapped once and stays mapped when
+/// ARB_buffer_storage is there, otherwise every slot is mapped unsynchronized when written;
+/// either way a fence per slot keeps it from being overwritten while the GPU still reads it.
+///
+/// The loader has its own thread instead of running as scheduler tasks: waiting on a task
+/// runs other tasks, which would put multi millisecond decodes on the main thread mid frame.
+/// Until a request is uploaded its destination should be drawn with a placeholder.
+/// </summary>
+class TextureStreamer {
+public:
+	/// <summary>
+	/// Where and how big a texture ends up. The image is stretched to width * height and
+	/// written at x, y of the layer. x and y must stay whole numbers at every mip level.
+	/// </summary>
+	struct Destination {
+		GLTextureArray* target;
+		int layer;
+		int x;
+		int y;
+		int width;
+		int height;
+	};
+
+	/// <summary>
+	/// A request update() is done with
+	/// </summary>
+	struct Finished {
+		int handle;
+		bool uploaded;	// false if the file couldn't be loaded or uploaded, the destination wasn't touched
+	};
+
+	TextureStreamer();
+	~TextureStreamer();
+
+	/// <summary>
+	/// Queue a texture file for loading. The handle is the caller's name for the request,
+	/// update() reports it back once the texture is on the GPU.
+	/// </summary>
+	void request(int handle, const std::string& path, const Destination& destination);
+
+	/// <summary>
+	/// Load and upload a texture before returning, for textures that must always be there.
+	/// </summary>
+	bool loadNow(const std::string& path, const Destination& destination);
+
+	/// <summary>
+	/// Upload textures the loader finished, at most maxUploads of them. GL thread only.
+	/// </summary>
+	/// <returns>The requests that are on the GPU now or failed</returns>
+	const std::vector<Finished>& update(int maxUploads = 2);
+
+	/// <summary>
+	/// Requests that are not uploaded yet, failed ones included until update() drops them
+	/// </summary>
+	size_t getPendingCount() const;
+
+	/// <summary>
+	/// Bytes one ring slot holds, the largest mip chain that can be uploaded
+	/// </summary>
+	static size_t chainSize(int width, int height, int levels);
+private:
+	static const int RING_SLOTS = 3;
+
+	struct Job {
+		int handle;
+		std::string path;
+		Destination destination;
+		int levels;
+	};
+
+	// a decoded texture and its mip chain, RGBA8, level after level
+	struct Result {
+		int handle;
+		Destination destination;
+		int levels;
+		std::vector<unsigned char> pixels;	// empty if loading failed
+	};
+
+	struct Slot {
+		size_t offset;
+		GLsync fence;
+	};
+
+	void loaderLoop();
+	static void prepare(const Job& job, Result& result);
+	void upload(const Result& result, size_t offset);
+	bool ensureRing(size_t slotSize);
+
+	std::thread _loader;
+	mutable std::mutex _mutex;
+	std::condition_variable _wake;
+	std::deque<Job> _jobs;
+	std::deque<Result> _done;
+	size_t _inFlight;	// taken by the loader, not in _done yet
+	bool _stopping;
+
+	GLuint _pbo;
+	unsigned char* _mapped;	// persistent mapping, null when slots are mapped one at a time
+	size_t _slotSize;
+	Slot _slots[RING_SLOTS];
+	int _nextSlot;
+	std::vector<Finished> _finished;
+};
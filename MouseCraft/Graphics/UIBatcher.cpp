@@ -0,0 +1,121 @@
+#include "UIBatcher.h"
+#include "../Util/RadixSort.h"
+#include <cstring>
+
+#define VERTEX_SIZE 11	// floats per batched vertex, position, texture coordinate, color, size class and layer
+#define TRANSPARENT_BIT ((uint64_t)1 << 32)
+
+UIBatcher::UIBatcher() : _vbo(VERTEX_SIZE), _drawCount(0) {
+	const int stride = VERTEX_SIZE * sizeof(GLfloat);
+	_vao.setAttribute(0, _vbo, 3, stride, 0);
+	_vao.setAttribute(1, _vbo, 2, stride, 3 * sizeof(GLfloat));
+	_vao.setAttribute(2, _vbo, 4, stride, 5 * sizeof(GLfloat));
+	_vao.setAttribute(3, _vbo, 2, stride, 9 * sizeof(GLfloat));
+	_vao.setElementBuffer(_ebo);
+	_vao.unbind();
+}
+
+void UIBatcher::clear() {
+	_sources.clear();
+}
+
+void UIBatcher::add(const Sprite& sprite, const GLfloat* vertices, size_t vertexCount, const GLuint* indices, size_t indexCount) {
+	if (indexCount == 0) {
+		return;
+	}
+	Source source = { sprite, vertices, vertexCount, indices, indexCount };
+	_sources.push_back(source);
+}
+
+void UIBatcher::draw() {
+	_drawCount = 0;
+	if (_sources.empty()) {
+		return;
+	}
+
+	_items.resize(_sources.size());
+	_scratch.resize(_sources.size());
+	for (size_t i = 0; i < _sources.size(); ++i) {
+		_items[i].key = sortKey(_sources[i].sprite);
+		_items[i].source = i;
+	}
+	RadixSort::Sort(_items.data(), _scratch.data(), _items.size());
+
+	// opaque sprites sort first, so they're one range of indices and the transparent ones the next
+	_vertices.clear();
+	_indices.clear();
+	size_t opaqueIndices = 0;
+	for (const SortItem& item : _items) {
+		expand(_sources[item.source]);
+		if (!(item.key & TRANSPARENT_BIT)) {
+			opaqueIndices = _indices.size();
+		}
+	}
+
+	_vao.bind();
+	_vbo.buffer(_vertices);
+	_ebo.buffer(_indices);
+
+	if (opaqueIndices > 0) {
+		glDisable(GL_BLEND);
+		glDrawElements(GL_TRIANGLES, (GLsizei)opaqueIndices, GL_UNSIGNED_INT, 0);
+		++_drawCount;
+	}
+	if (opaqueIndices < _indices.size()) {
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		glDepthMask(GL_FALSE);
+		glDrawElements(GL_TRIANGLES, (GLsizei)(_indices.size() - opaqueIndices), GL_UNSIGNED_INT,
+			(void *)(opaqueIndices * sizeof(GLuint)));
+		glDepthMask(GL_TRUE);
+		glDisable(GL_BLEND);
+		++_drawCount;
+	}
+	_vao.unbind();
+}
+
+size_t UIBatcher::getDrawCount() const {
+	return _drawCount;
+}
+
+uint64_t UIBatcher::sortKey(const Sprite& sprite) {
+	// flip the float's bits so they sort like the number, larger depth is further back
+	float depth = sprite.transform[3][2];
+	uint32_t bits;
+	std::memcpy(&bits, &depth, sizeof(bits));
+	bits = (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+
+	// opaque front to back, transparent back to front
+	if (sprite.transparent) {
+		return TRANSPARENT_BIT | (uint32_t)~bits;
+	}
+	return bits;
+}
+
+void UIBatcher::expand(const Source& source) {
+	const Sprite& s = source.sprite;
+	const GLuint baseVertex = (GLuint)(_vertices.size() / VERTEX_SIZE);
+	const size_t start = _vertices.size();
+	_vertices.resize(start + source.vertexCount * VERTEX_SIZE);
+
+	for (size_t i = 0; i < source.vertexCount; ++i) {
+		const GLfloat* in = source.vertices + i * SOURCE_VERTEX_SIZE;
+		GLfloat* out = &_vertices[start + i * VERTEX_SIZE];
+		glm::vec4 position = s.transform * glm::vec4(in[0], in[1], in[2], 1.0f);
+		out[0] = position.x;
+		out[1] = position.y;
+		out[2] = position.z;
+		out[3] = s.region.x + in[3] * s.region.z;
+		out[4] = s.region.y + in[4] * s.region.w;
+		out[5] = s.color.r;
+		out[6] = s.color.g;
+		out[7] = s.color.b;
+		out[8] = s.color.a;
+		out[9] = (GLfloat)s.sizeClass;
+		out[10] = (GLfloat)s.layer;
+	}
+
+	for (size_t i = 0; i < source.indexCount; ++i) {
+		_indices.push_back(baseVertex + source.indices[i]);
+	}
+}
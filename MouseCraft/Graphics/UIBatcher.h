@@ -0,0 +1,93 @@
+#pragma once
+#include "../GL/glad.h"
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+#include "BufferObjects/VertexArrayObject.h"
+#include "BufferObjects/VertexBufferObject.h"
+#include "BufferObjects/ElementBufferObject.h"
+
+/// <summary>
+/// Draws all of the UI with one vertex buffer. Every sprite's vertices are transformed to clip
+/// space on the CPU and written to the buffer together with their color and texture, so sprites
+/// don't need uniforms of their own and only a change of blend state splits a batch. Textures
+/// never do, every sprite samples the size class arrays of the TextureResidency.
+///
+/// Sprites are sorted with a stable radix sort on depth, opaque ones first and front to back
+/// so the depth test rejects what they cover, then transparent ones back to front with depth
+/// writes off. Sprites at the same depth keep the order they were added in.
+///
+/// Vertex attributes:
+///		0 clip space position
+///		1 texture coordinate in the texture's layer
+///		2 color
+///		3 texture size class and layer
+/// </summary>
+class UIBatcher {
+public:
+	static const int SOURCE_VERTEX_SIZE = 5;	// floats per added vertex, position and texture coordinate
+
+	/// <summary>
+	/// How to place and shade one sprite
+	/// </summary>
+	struct Sprite {
+		glm::mat4 transform;	// local to clip space, depth is taken from its translation
+		glm::vec4 color;
+		glm::vec4 region;		// part of the layer the texture covers
+		int sizeClass;
+		int layer;
+		bool transparent;
+	};
+
+	UIBatcher();
+
+	/// <summary>
+	/// Forget the sprites of the last frame, keeps the memory.
+	/// </summary>
+	void clear();
+
+	/// <summary>
+	/// Queue a sprite. The vertices and indices are read in draw() and must stay valid until then.
+	/// </summary>
+	/// <param name="vertices">vertexCount vertices of SOURCE_VERTEX_SIZE floats</param>
+	/// <param name="indices">Triangles, indexing vertices from 0</param>
+	void add(const Sprite& sprite, const GLfloat* vertices, size_t vertexCount, const GLuint* indices, size_t indexCount);
+
+	/// <summary>
+	/// Sort, upload and draw everything queued with the bound shader.
+	/// Leaves blending off and depth writes on.
+	/// </summary>
+	void draw();
+
+	/// <summary>
+	/// Number of draw calls the last draw issued
+	/// </summary>
+	size_t getDrawCount() const;
+private:
+	struct Source {
+		Sprite sprite;
+		const GLfloat* vertices;
+		size_t vertexCount;
+		const GLuint* indices;
+		size_t indexCount;
+	};
+
+	struct SortItem {
+		uint64_t key;
+		size_t source;
+	};
+
+	static uint64_t sortKey(const Sprite& sprite);
+	void expand(const Source& source);
+
+	std::vector<Source> _sources;
+	std::vector<SortItem> _items;
+	std::vector<SortItem> _scratch;
+	std::vector<GLfloat> _vertices;
+	std::vector<GLuint> _indices;
+
+	VertexArrayObject _vao;
+	VertexBufferObject _vbo;
+	ElementBufferObject _ebo;
+	size_t _drawCount;
+};
@@ -188,7 +188,7 @@ void InputSystem::Update(float dt)
 
 			// notify
 			EventManager::Notify(EventName::INPUT_BUTTON,
-				new TypeParam<ButtonEvent>(ButtonEvent{ player, b, isDown }));
+				ButtonEvent{ player, b, isDown });
 		}
 		else if (e.type == SDL_KEYDOWN || e.type == SDL_KEYUP)
 		{
@@ -213,23 +213,23 @@ void InputSystem::Update(float dt)
 				break;
 			case SDLK_j:
 				EventManager::Notify(EventName::INPUT_BUTTON,
-					new TypeParam<ButtonEvent>(ButtonEvent{ player, Button::PRIMARY, isDown }));
+					ButtonEvent{ player, Button::PRIMARY, isDown });
 				break;
 			case SDLK_k:
 				EventManager::Notify(EventName::INPUT_BUTTON,
-					new TypeParam<ButtonEvent>(ButtonEvent{ player, Button::SECONDARY, isDown }));
+					ButtonEvent{ player, Button::SECONDARY, isDown });
 				break;
 			case SDLK_l:
 				EventManager::Notify(EventName::INPUT_BUTTON,
-					new TypeParam<ButtonEvent>(ButtonEvent{ player, Button::AUX1, isDown }));
+					ButtonEvent{ player, Button::AUX1, isDown });
 				break;
 			case SDLK_SEMICOLON:
 				EventManager::Notify(EventName::INPUT_BUTTON,
-					new TypeParam<ButtonEvent>(ButtonEvent{ player, Button::AUX2, isDown }));
+					ButtonEvent{ player, Button::AUX2, isDown });
 				break;
             case SDLK_RETURN:
                 EventManager::Notify(EventName::INPUT_BUTTON,
-					new TypeParam<ButtonEvent>(ButtonEvent{ player, Button::OPTION, isDown }));
+					ButtonEvent{ player, Button::OPTION, isDown });
                 break;
             }
 		}
@@ -257,12 +257,12 @@ void InputSystem::Update(float dt)
 
 			// notify 
 			EventManager::Notify(EventName::INPUT_MOUSE_CLICK,
-				new TypeParam<MouseButtonEvent>(MouseButtonEvent{ pos, isRight, isDown }));
+				MouseButtonEvent{ pos, isRight, isDown });
 		}
 		else if (e.type == SDL_MOUSEMOTION)
 		{
 			EventManager::Notify(EventName::INPUT_MOUSE_MOVE,
-				new TypeParam<glm::ivec2>(glm::ivec2(e.motion.x, e.motion.y)));
+				glm::ivec2(e.motion.x, e.motion.y));
 		}
 	} // end while 
 
@@ -303,17 +303,17 @@ void InputSystem::NotifyAxis(Axis2DInput& axis, Axis which, int player)
 	if (axis.HasAxisChanged())
 	{
 		EventManager::Notify(EventName::INPUT_AXIS_2D,
-			new TypeParam<Axis2DEvent>(Axis2DEvent{ player, which, axis.GetAxis() }));
+			Axis2DEvent{ player, which, axis.GetAxis() });
 	}
 	if (axis.HasXChanged())
 	{
 		EventManager::Notify(EventName::INPUT_AXIS,
-			new TypeParam<AxisEvent>(AxisEvent{ player, static_cast<Axis>(which + 1), axis.GetX() }));
+			AxisEvent{ player, static_cast<Axis>(which + 1), axis.GetX() });
 	}
 	if (axis.HasYChanged())
 	{
 		EventManager::Notify(EventName::INPUT_AXIS,
-			new TypeParam<AxisEvent>(AxisEvent{ player, static_cast<Axis>(which + 2), axis.GetY() }));
+			AxisEvent{ player, static_cast<Axis>(which + 2), axis.GetY() });
 	}
 }
 
@@ -199,6 +199,11 @@ public:
 
 		profiler.InitializeTimers(1);
 		profiler.LogOutput("Input.log");
+
+		// pumps SDL events, subscribers to the input events are gameplay code
+		RunOnMainThread(true);
+		Writes<InputSystem>();
+		Writes<GameplayCode>();
 	};
 	~InputSystem()
 	{
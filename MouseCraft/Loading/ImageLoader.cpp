@@ -17,4 +17,9 @@ Image* ImageLoader::loadImage(string filename) {
 		return nullptr;
 	}
 	return new Image(data, width, height, channels);
+}
+
+bool ImageLoader::getImageSize(const string& filename, int& width, int& height) {
+	int channels;
+	return stbi_info(filename.c_str(), &width, &height, &channels) != 0;
 }
\ No newline at end of file
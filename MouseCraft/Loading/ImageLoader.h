@@ -5,4 +5,6 @@
 class ImageLoader {
 public:
 	static Image* loadImage(std::string filename);
+	// Reads only the header of an image file. Returns false if it can't be read.
+	static bool getImageSize(const std::string& filename, int& width, int& height);
 };
\ No newline at end of file
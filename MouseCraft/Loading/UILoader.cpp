@@ -3,13 +3,14 @@
 #include "../UI/TextComponent.h"
 #include "../UI/ImageComponent.h"
 #include "../Core/EntityManager.h"
+#include "../Core/ComponentManager.h"
 #include <sstream>
 #include "../Graphics/Color.h"
 
 //using namespace tinyxml2;
 
 Entity* UILoader::loadUI(std::string path, float width, float height) {
-	UIComponent* rootComponent = new UIComponent(100, 100, 0, 0);
+	UIComponent* rootComponent = ComponentManager<UIComponent>::Instance().Create<UIComponent>(100, 100, 0, 0);
 	rootComponent->color = Color(0, 0, 0);
 	rootComponent->screenSize = { width, height };
 	rootComponent->screenPosition = { 0, 0 };
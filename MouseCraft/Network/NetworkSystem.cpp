@@ -51,6 +51,12 @@ NetworkSystem::NetworkSystem(const Role role, const unsigned short port) : _tick
     }
     EventManager::Subscribe(EventName::INPUT_BUTTON, this);
     EventManager::Subscribe(EventName::INPUT_AXIS_2D, this);
+
+    // packets create and destroy entities and change scenes, re-dispatched input runs gameplay code
+    RunOnMainThread(true);
+    Writes<NetworkComponent>();
+    Writes<InputSystem>();
+    Writes<GameplayCode>();
 }
 
 NetworkSystem::~NetworkSystem() {
@@ -365,7 +371,7 @@ void NetworkSystem::processDatum(const Address &sender, PacketData *packet) {
                 glm::vec2 value(x, y);
 
 				Axis2DEvent eventData{ _connectionList[sender].PlayerID, axis, value };
-                EventManager::Notify(EventName::INPUT_AXIS_2D, new TypeParam<Axis2DEvent>(eventData));
+                EventManager::Notify(EventName::INPUT_AXIS_2D, eventData);
             }
             break;
         case NetDatum::DataType::PLAYER_BUTTON:
@@ -374,7 +380,7 @@ void NetworkSystem::processDatum(const Address &sender, PacketData *packet) {
                 bool down = packet->ReadByte();
 
 				ButtonEvent eventData{ _connectionList[sender].PlayerID, button, down };
-                EventManager::Notify(EventName::INPUT_BUTTON, new TypeParam<ButtonEvent>(eventData));
+                EventManager::Notify(EventName::INPUT_BUTTON, eventData);
             }
             break;
         default:
@@ -65,7 +65,7 @@ Entity * ObstacleFactory::CreateSimulated(OBSTACLES type, glm::vec3 position, bo
 	}
 	case VASE:
 	{
-		auto fieldModel = ModelGen::makeCube(16, 0.1, 16);
+		auto fieldModel = ModelGen::getCube(16, 0.1, 16);
 		c_render->setModel(*fieldModel);
 		c_render->setColor(Color(0.0, 0.0, 1.0));
 		c_render->SetEnabled(false);	// this is the field 
@@ -94,7 +94,7 @@ Entity * ObstacleFactory::CreateSimulated(OBSTACLES type, glm::vec3 position, bo
 	}
 	case LAMP:
 	{
-		auto fieldModel = ModelGen::makeCube(16, 0.1, 16);
+		auto fieldModel = ModelGen::getCube(16, 0.1, 16);
 		c_render->setModel(*fieldModel);
 		c_render->setColor(Color(1.0, 1.0, 0.0));
 		c_render->SetEnabled(false);	// this is the field 
@@ -196,7 +196,6 @@ Entity * ObstacleFactory::Create(OBSTACLES type, glm::vec3 pos, bool isUp, std::
 	case LAMP:
 	{	
 		// base entity is field 
-		auto fieldModel = ModelGen::makeCube(15, 0.1, 15);
 		c_render = PrefabLoader::LoadComponent("res/prefabs/components/obstacles/lamp_field_renderable.json");
 		c_net->AddComponentData({ {"type", "file"}, {"value", "res/prefabs/components/obstacles/lamp_field_renderable.json"} });
 		c_phys = PhysicsManager::instance()->createGridObject(pos.x, pos.z, 5, 5, isUp ? PhysObjectType::OBSTACLE_UP : PhysObjectType::OBSTACLE_DOWN);
@@ -218,7 +217,7 @@ Entity * ObstacleFactory::Create(OBSTACLES type, glm::vec3 pos, bool isUp, std::
 	}
 	default:
 		std::cerr << "ERROR: Obstacle Factory making unknown type!" << std::endl;
-		c_phys = new PhysicsComponent(PhysObjectType::OBSTACLE_DOWN, 0, 0, 0, 0);
+		c_phys = ComponentManager<PhysicsComponent>::Instance().Create<PhysicsComponent>(PhysObjectType::OBSTACLE_DOWN, 0, 0, 0, 0);
 		break;
 	}
 	
@@ -2,6 +2,7 @@
 
 #include <Windows.h>
 #include <iostream>
+#include <limits>
 #include "Core/OmegaEngine.h"
 #include "Core/Entity.h"
 #include "Core/Test/TestComponent.h"
@@ -9,9 +10,23 @@
 #include "Core/ComponentManager.h"
 #include "MainScene.h"
 #include "Core/EntityManager.h"
+#include "Core/TickManager.h"
+#include "Core/TransformHierarchy.h"
 #include "Core/Example/ExampleComponent.h"
 #include "Core/Example/ExampleSystem.h"
 #include "TestSubObs.h"
+#include "Util/AffineMath.h"
+#include "Util/RadixSort.h"
+#include "Util/AABBTree.h"
+#include "Util/RectPacker.h"
+#include "Graphics/Frustum.h"
+#include "Graphics/LightClusters.h"
+#include "Graphics/Light.h"
+#include "Graphics/RenderSystem.h"
+#include "Graphics/Shader.h"
+#include "Graphics/GLCallCounter.h"
+#include "Graphics/BufferObjects/UniformBufferObject.h"
+#include "UI/UIManager.h"
 
 #define GLM_EQUAL(v3a,v3b) glm::all(glm::epsilonEqual(v3a, v3b, glm::epsilon<float>()))
 
@@ -77,6 +92,76 @@ public:
 		SDL_assert(GLM_EQUAL(e_left->t().wScl(), glm::vec3(3, 2, 1)));
 	}
 
+	void Test_TransformHierarchy()
+	{
+		// standalone graph, outside of any scene so every change is instant
+		TransformHierarchy hierarchy;
+		auto root = EntityManager::Instance().Create();
+		auto a = EntityManager::Instance().Create();
+		auto b = EntityManager::Instance().Create();
+		auto c = EntityManager::Instance().Create();
+		auto d = EntityManager::Instance().Create();
+		root->AddChild(a);
+		a->AddChild(b);
+		root->AddChild(c);
+		c->AddChild(d);
+		b->transform.setLocalPosition(glm::vec3(0, 1, 0));
+		d->transform.setLocalPosition(glm::vec3(0, 0, 1));
+
+		hierarchy.Update(root);
+		SDL_assert(hierarchy.GetCount() == 5 && "Every enabled entity should be flattened.");
+		SDL_assert(GLM_EQUAL(b->t().wPos(), glm::vec3(0, 1, 0)));
+		SDL_assert(GLM_EQUAL(d->t().wPos(), glm::vec3(0, 0, 1)));
+
+		// nothing changed, nothing is recomputed
+		unsigned int vRoot = root->transform.getWorldVersion();
+		unsigned int vA = a->transform.getWorldVersion();
+		unsigned int vB = b->transform.getWorldVersion();
+		unsigned int vC = c->transform.getWorldVersion();
+		unsigned int vD = d->transform.getWorldVersion();
+		hierarchy.Update(root);
+		SDL_assert(root->transform.getWorldVersion() == vRoot && a->transform.getWorldVersion() == vA
+			&& b->transform.getWorldVersion() == vB && c->transform.getWorldVersion() == vC
+			&& d->transform.getWorldVersion() == vD && "Unchanged transforms shouldn't be recomputed.");
+
+		// a moved parent moves its children, the other subtree is left alone
+		a->transform.setLocalPosition(glm::vec3(2, 0, 0));
+		a->transform.setLocalScale(glm::vec3(2, 2, 2));
+		hierarchy.Update(root);
+		SDL_assert(a->transform.getWorldVersion() > vA && b->transform.getWorldVersion() > vB && "Moved subtree should be recomputed.");
+		SDL_assert(GLM_EQUAL(b->t().wPos(), glm::vec3(2, 2, 0)));
+		SDL_assert(GLM_EQUAL(b->t().wScl(), glm::vec3(2, 2, 2)));
+		SDL_assert(root->transform.getWorldVersion() == vRoot && c->transform.getWorldVersion() == vC
+			&& d->transform.getWorldVersion() == vD && "Untouched subtree shouldn't be recomputed.");
+
+		// reparented entity takes its new parent's world transformation
+		vC = c->transform.getWorldVersion();
+		vD = d->transform.getWorldVersion();
+		d->SetParent(a);
+		hierarchy.Update(root);
+		SDL_assert(hierarchy.GetCount() == 5);
+		SDL_assert(d->transform.getWorldVersion() > vD && "Reparented entity should be recomputed.");
+		SDL_assert(GLM_EQUAL(d->t().wPos(), glm::vec3(2, 0, 2)));
+		SDL_assert(c->transform.getWorldVersion() == vC && "Old parent shouldn't be recomputed.");
+
+		// disabled subtree drops out of the graph, comes back recomputed
+		a->SetEnabled(false);
+		hierarchy.Update(root);
+		SDL_assert(hierarchy.GetCount() == 2 && "Disabled subtree should be skipped.");
+		vB = b->transform.getWorldVersion();
+		a->SetEnabled(true);
+		hierarchy.Update(root);
+		SDL_assert(hierarchy.GetCount() == 5);
+		SDL_assert(b->transform.getWorldVersion() > vB);
+
+		// destroyed entity leaves the graph
+		c->Destroy();
+		hierarchy.Update(root);
+		SDL_assert(hierarchy.GetCount() == 4 && "Destroyed entity should be dropped.");
+
+		root->Destroy();
+	}
+
 	void Test_ECS()
 	{
 		// NOTE: Use SDL_assert b/c SDL2 is manhandling everything.
@@ -124,6 +209,9 @@ public:
 		auto sizeShouldBe4 = EntityManager::Instance().GetEntities();
 		SDL_assert(sizeShouldBe4.size() == 4 && "EntityManager failed (1)");
 
+		EntityHandle parent1Handle = parent1->GetHandle();
+		SDL_assert(EntityManager::Instance().Get(parent1Handle) == parent1 && "Handle lookup failed");
+
 		// test 
 		parent1->AddChild(child1);
 
@@ -137,6 +225,7 @@ public:
 		parent2->SetEnabled(false);
 
 		SDL_assert(parent2->GetEnabled() == false, "Instant disable failed");
+		SDL_assert(!child1->GetActive() && "Entity outside of the active scene is active");
 
 		// component test 
 		parent1->AddComponent(tc);
@@ -144,12 +233,15 @@ public:
 
 		SDL_assert(parent1->GetComponents().size() == 1 && "Component add failed (1)");
 		SDL_assert(parent2->GetComponents().size() == 1 && "Component add failed (2)");
+		SDL_assert(parent2->GetComponent<TestComponent>() == tdc && "Component lookup failed (1)");
+		SDL_assert(parent2->GetComponent<TestComponent>() == tdc && "Component lookup failed (2)");	// cached
 
 		parent1->RemoveComponent(tc);
 		parent2->RemoveComponent<TestComponent>();	// should still work despite derived
 
 		SDL_assert(parent1->GetComponents().size() == 0 && "Component remove failed (1)");
 		SDL_assert(parent2->GetComponents().size() == 0 && "Component remove failed (2)");
+		SDL_assert(parent2->GetComponent<TestComponent>() == nullptr && "Component lookup not invalidated");
 
 		// cleanup 
 		delete(parent1);
@@ -159,6 +251,12 @@ public:
 
 		auto sizeShouldBe0 = EntityManager::Instance().GetEntities();
 		SDL_assert(sizeShouldBe0.size() == 0 && "EntityManager failed (1)");
+		SDL_assert(EntityManager::Instance().Get(parent1Handle) == nullptr && "Handle still valid after delete");
+
+		Entity* reused = EntityManager::Instance().Create();
+		SDL_assert(reused->GetHandle() != parent1Handle && "Reused slot has the same handle");
+		SDL_assert(EntityManager::Instance().Get(parent1Handle) == nullptr && "Old handle resolves to new entity");
+		delete(reused);
 
 		// TESTS: deferred execution 
 
@@ -185,6 +283,8 @@ public:
 
 		// test
 		SDL_assert(s->root.GetChildren().size() == 0, "Deferred execution initial state failed.");
+		SDL_assert(s->root.GetActive() && "Scene root not active after transition");
+		SDL_assert(!child1->GetActive() && "Active status leaked before entity was added");
 
 		auto shouldBeNull = parent1->GetComponent<TestDerivedComponent>();
 		auto shouldBeOkay = parent2->GetComponent<TestComponent>();
@@ -204,8 +304,14 @@ public:
 		auto* t1 = ComponentManager<TestComponent>::Instance().Create<TestDerivedComponent>(new Entity());
 		// not like this lol
 		TestComponent test(new Entity);
+		unsigned int freedID = t->GetID();
 		delete t;
 
+		// IDs are reused, so the managers' sparse sets only grow with the most components alive
+		auto* t2 = ComponentManager<TestComponent>::Instance().Create<TestComponent>(new Entity());
+		SDL_assert(t2->GetID() == freedID && "Component ID not reused");
+		SDL_assert(ComponentManager<TestComponent>::Instance().All().back() == t2 && "Reused ID not registered");
+
 		//auto ec1 = ComponentManager<ExampleComponent>::Instance().Create<ExampleComponent>();
 		//auto ec2 = ComponentManager<ExampleComponent>::Instance().Create<ExampleComponent>();
 		//auto ec3 = ComponentManager<ExampleComponent>::Instance().Create<ExampleComponent>();
@@ -275,4 +381,600 @@ public:
 
 		health.Heal(100);	// nothing
 	}
-};
\ No newline at end of file
+
+	void Test_EventManager()
+	{
+		// subscriber that (un)subscribes others while being notified
+		struct Meddler : public ISubscriber
+		{
+			ISubscriber* toAdd = nullptr;
+			ISubscriber* toRemove = nullptr;
+			int calls = 0;
+			void Notify(EventName eventName, Param* params) override
+			{
+				++calls;
+				if (toAdd) EventManager::Subscribe(eventName, toAdd);
+				if (toRemove) EventManager::Unsubscribe(eventName, toRemove);
+			}
+		};
+
+		Meddler a, b, c;
+		a.toAdd = &c;		// added during dispatch, first called next dispatch
+		a.toRemove = &b;	// removed during dispatch, never called
+
+		EventManager::Subscribe(EventName::INPUT_RAW, &a);
+		EventManager::Subscribe(EventName::INPUT_RAW, &b);
+		EventManager::Notify(EventName::INPUT_RAW, 1.0f);
+
+		SDL_assert(a.calls == 1 && "Event dispatch failed");
+		SDL_assert(b.calls == 0 && "Unsubscribe during dispatch failed");
+		SDL_assert(c.calls == 0 && "Subscribe during dispatch failed (called too early)");
+		SDL_assert(EventManager::GetSubscriberCount(EventName::INPUT_RAW) == 2 && "Deferred subscription failed");
+
+		EventManager::Notify(EventName::INPUT_RAW, 1.0f);
+		SDL_assert(c.calls == 1 && "Subscribe during dispatch failed (not called)");
+
+		EventManager::Unsubscribe(EventName::INPUT_RAW, &a);
+		EventManager::Unsubscribe(EventName::INPUT_RAW, &c);
+		SDL_assert(EventManager::GetSubscriberCount(EventName::INPUT_RAW) == 0 && "Unsubscribe failed");
+	}
+
+	void Test_TickManager()
+	{
+		// counts its updates somewhere that outlives it, can remove another component while updating
+		struct Counter : public UpdatableComponent
+		{
+			int* updates;
+			int removeAt = 0;
+			Counter* victim = nullptr;
+			Counter(int* updates) : updates(updates) {}
+			void Update(float dt) override
+			{
+				++*updates;
+				if (victim && *updates == removeAt)
+				{
+					victim->GetEntity()->RemoveComponent(victim);
+					victim = nullptr;
+				}
+			}
+		};
+		// second bucket, updated in parallel
+		struct ConcurrentCounter : public Counter
+		{
+			ConcurrentCounter(int* updates) : Counter(updates) {}
+		};
+		TickManager::Instance().SetConcurrent<ConcurrentCounter>(true);
+
+		if (OmegaEngine::Instance().GetActiveScene() == nullptr)
+			OmegaEngine::Instance().ChangeScene(new MainScene());
+		Entity& root = OmegaEngine::Instance().GetActiveScene()->root;
+		const size_t othersActive = TickManager::Instance().GetActiveCount();
+
+		Entity* e = new Entity();
+		Entity* outside = new Entity();
+		root.AddChild(e, true);
+
+		// a1 removes a2 in its 5th update, a2 comes after it in the bucket so it misses that tick
+		int updates[7] = {};
+		Counter* a0 = new Counter(&updates[0]);
+		Counter* a1 = new Counter(&updates[1]);
+		Counter* a2 = new Counter(&updates[2]);
+		Counter* a3 = new Counter(&updates[3]);
+		a1->victim = a2;
+		a1->removeAt = 5;
+		ConcurrentCounter* b0 = new ConcurrentCounter(&updates[4]);
+		ConcurrentCounter* b1 = new ConcurrentCounter(&updates[5]);
+		Counter* c = new Counter(&updates[6]);
+		for (Component* comp : std::vector<Component*>{ a0, a1, a2, a3, b0, b1 })
+			e->AddComponent(comp);
+		outside->AddComponent(c);
+
+		const int ticks = 10;
+		for (int i = 0; i < ticks; ++i)
+		{
+			if (i == 3)
+				b1->SetEnabled(false);
+			TickManager::Instance().Tick(0.016f);
+		}
+
+		SDL_assert(updates[0] == ticks && updates[1] == ticks && updates[3] == ticks && "Component missed a tick");
+		SDL_assert(updates[2] == 4 && "Component removed mid-bucket was updated in the tick it was removed");
+		SDL_assert(updates[4] == ticks && "Concurrent component missed a tick");
+		SDL_assert(updates[5] == 3 && "Disabled component was still updated");
+		SDL_assert(updates[6] == 0 && "Component outside the scene was updated");
+		SDL_assert(e->GetComponents().size() == 5 && "Removed component is still attached");
+		SDL_assert(TickManager::Instance().GetActiveCount() == othersActive + 4 && "Active range out of date");
+
+		// cleanup
+		e->Destroy(true);
+		outside->Destroy();
+		SDL_assert(TickManager::Instance().GetActiveCount() == othersActive && "Destroyed components still registered");
+	}
+
+	void Benchmark_EventManager()
+	{
+		struct Accumulator : public ISubscriber
+		{
+			float total = 0;
+			void Notify(EventName eventName, Param* params) override
+			{
+				total += static_cast<TypeParam<float>*>(params)->Param;
+			}
+		};
+
+		const int dispatches = 10000;
+		const int subscriberCounts[] = { 1, 10, 100, 1000 };
+
+		CpuProfiler profiler;
+		profiler.InitializeTimers(1);
+
+		for (int count : subscriberCounts)
+		{
+			std::vector<Accumulator> subscribers(count);
+			for (auto& s : subscribers)
+				EventManager::Subscribe(EventName::INPUT_RAW, &s);
+
+			profiler.StartTimer(0);
+			for (int i = 0; i < dispatches; ++i)
+				EventManager::Notify(EventName::INPUT_RAW, 1.0f);
+			profiler.StopTimer(0);
+
+			for (auto& s : subscribers)
+				EventManager::Unsubscribe(EventName::INPUT_RAW, &s);
+
+			double perDispatch = (double)profiler.GetDuration(0) / dispatches;
+			std::cout << "EventManager: " << count << " subscribers, "
+				<< perDispatch << "ns per dispatch, "
+				<< perDispatch / count << "ns per subscriber" << std::endl;
+		}
+	}
+
+	void Benchmark_AffineMath()
+	{
+		const int count = 100000;
+
+		std::vector<glm::vec3> positions(count), rotations(count), scales(count);
+		for (int i = 0; i < count; ++i)
+		{
+			float f = (float)i;
+			positions[i] = glm::vec3(f * 0.001f, -f * 0.001f, 0.5f);
+			rotations[i] = glm::vec3(f * 0.01f, f * 0.02f, f * 0.03f);
+			scales[i] = glm::vec3(1.0f + (i % 3), 1.0f, 2.0f);
+		}
+		std::vector<glm::quat> quats(rotations.begin(), rotations.end());
+
+		std::vector<glm::mat4> glmLocal(count), glmWorld(count), glmNormal(count);
+		std::vector<glm::mat4> affLocal(count), affWorld(count), affNormal(count);
+		const glm::mat4 parent = glm::translate(glm::mat4(1.0f), glm::vec3(1, 2, 3)) * glm::mat4(glm::quat(glm::vec3(0.3f, 0.2f, 0.1f)));
+
+		CpuProfiler profiler;
+		profiler.InitializeTimers(6);
+
+		// glm (what Transform and the renderer used to do)
+		profiler.StartTimer(0);
+		for (int i = 0; i < count; ++i)
+			glmLocal[i] = glm::scale(glm::translate(glm::mat4(1.0f), positions[i]) * (glm::mat4)quats[i], scales[i]);
+		profiler.StopTimer(0);
+
+		profiler.StartTimer(1);
+		for (int i = 0; i < count; ++i)
+			glmWorld[i] = parent * glmLocal[i];
+		profiler.StopTimer(1);
+
+		profiler.StartTimer(2);
+		for (int i = 0; i < count; ++i)
+			glmNormal[i] = glm::transpose(glm::inverse(glmWorld[i]));
+		profiler.StopTimer(2);
+
+		// affine kernels
+		profiler.StartTimer(3);
+		for (int i = 0; i < count; ++i)
+			affLocal[i] = AffineMath::Compose(positions[i], quats[i], scales[i]);
+		profiler.StopTimer(3);
+
+		profiler.StartTimer(4);
+		for (int i = 0; i < count; ++i)
+			AffineMath::Multiply(parent, affLocal[i], affWorld[i]);
+		profiler.StopTimer(4);
+
+		profiler.StartTimer(5);
+		AffineMath::NormalMatrices(affWorld.data(), affNormal.data(), count);
+		profiler.StopTimer(5);
+
+		// every entry, relative to its magnitude (translations grow up to ~100)
+		auto matEqual = [](const glm::mat4& a, const glm::mat4& b)
+		{
+			for (int c = 0; c < 4; ++c)
+				for (int r = 0; r < 4; ++r)
+					if (glm::abs(a[c][r] - b[c][r]) > 0.001f * glm::max(1.0f, glm::abs(a[c][r])))
+						return false;
+			return true;
+		};
+
+		for (int i = 0; i < count; ++i)
+		{
+			SDL_assert(matEqual(glmLocal[i], affLocal[i]) && "Affine compose mismatch");
+			SDL_assert(matEqual(glmWorld[i], affWorld[i]) && "Affine concatenation mismatch");
+			// only the 3x3 of a normal matrix is kept, the rest is identity
+			SDL_assert(matEqual(glm::mat4(glm::mat3(glmNormal[i])), affNormal[i]) && "Normal matrix mismatch");
+			// parent is rigid, so the world scale is the local one (Transform::getWorldScale)
+			SDL_assert(glm::all(glm::epsilonEqual(AffineMath::ExtractScale(affWorld[i]), scales[i], 0.001f)) && "Scale extraction mismatch");
+		}
+
+		const char* names[] = { "compose", "multiply", "normal matrix" };
+		for (int k = 0; k < 3; ++k)
+		{
+			std::cout << "AffineMath: " << names[k] << " glm "
+				<< (double)profiler.GetDuration(k) / count << "ns, affine "
+				<< (double)profiler.GetDuration(k + 3) / count << "ns" << std::endl;
+		}
+	}
+
+	void Test_RadixSort()
+	{
+		struct Item { uint64_t key; int order; };
+		const int count = 10000;
+
+		// keys with repeats and a few high bits so every pass has something to do
+		std::vector<Item> items(count), scratch(count);
+		uint64_t x = 88172645463325252ull;
+		for (int i = 0; i < count; ++i)
+		{
+			x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+			items[i].key = (x % 64) << 40 | (x % 5);
+			items[i].order = i;
+		}
+		std::vector<Item> expected = items;
+		std::stable_sort(expected.begin(), expected.end(), [](const Item& a, const Item& b) { return a.key < b.key; });
+
+		RadixSort::Sort(items.data(), scratch.data(), items.size());
+		for (int i = 0; i < count; ++i)
+		{
+			SDL_assert(items[i].key == expected[i].key && "Radix sort out of order");
+			SDL_assert(items[i].order == expected[i].order && "Radix sort not stable");
+		}
+
+		// sorting again keeps equal keys in place
+		RadixSort::Sort(items.data(), scratch.data(), items.size());
+		for (int i = 0; i < count; ++i)
+			SDL_assert(items[i].order == expected[i].order && "Radix sort changed sorted input");
+	}
+
+	void Test_AABBTree()
+	{
+		const int count = 1000;
+		AABBTree tree(0.1f);
+		std::vector<glm::vec3> mins(count), maxs(count);
+		std::vector<int> proxies(count);
+
+		// boxes scattered on a grid, then every other one moved and every third removed
+		for (int i = 0; i < count; ++i)
+		{
+			glm::vec3 p((i % 10) * 4.0f - 20.0f, (i / 10 % 10) * 4.0f - 20.0f, (i / 100) * 4.0f - 20.0f);
+			mins[i] = p - glm::vec3(0.5f);
+			maxs[i] = p + glm::vec3(0.5f);
+			proxies[i] = tree.Insert(mins[i], maxs[i], &proxies[i]);
+		}
+		for (int i = 0; i < count; i += 2)
+		{
+			mins[i] += glm::vec3(1.5f, 0.0f, 0.0f);
+			maxs[i] += glm::vec3(1.5f, 0.0f, 0.0f);
+			tree.Move(proxies[i], mins[i], maxs[i]);
+		}
+		for (int i = 0; i < count; i += 3)
+		{
+			tree.Remove(proxies[i]);
+			proxies[i] = -1;
+		}
+		SDL_assert(tree.GetLeafCount() == count - (count + 2) / 3 && "AABB tree lost leaves");
+		SDL_assert(tree.GetHeight() < 32 && "AABB tree is unbalanced");
+
+		// the tree must return everything a brute force frustum test finds
+		glm::mat4 viewProjection = glm::perspective(1.0f, 1.5f, 0.1f, 30.0f)
+			* glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f, 0.2f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		Frustum frustum(viewProjection);
+		std::vector<bool> found(count, false);
+		tree.Query(
+			[&frustum](const glm::vec3& min, const glm::vec3& max) { return frustum.test(min, max); },
+			[&proxies, &found](void* data) { found[static_cast<int*>(data) - &proxies[0]] = true; });
+
+		int visible = 0;
+		for (int i = 0; i < count; ++i)
+		{
+			if (proxies[i] < 0) continue;
+			if (frustum.test(mins[i], maxs[i]) == AABBTree::OUTSIDE) continue;
+			++visible;
+			SDL_assert(found[i] && "AABB tree query missed a visible box");
+		}
+		SDL_assert(visible > 0 && visible < count && "Frustum test didn't cull anything");
+	}
+
+	void Test_RectPacker()
+	{
+		const int size = 512;
+		RectPacker packer(size, size);
+		struct Rect { int x, y, w, h; };
+		std::vector<Rect> placed;
+
+		// random rectangles until it's full, none may overlap or stick out
+		uint32_t x = 2463534242u;
+		for (int i = 0; i < 500; ++i)
+		{
+			x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+			Rect r = { 0, 0, 4 + (int)(x % 60), 4 + (int)(x / 60 % 60) };
+			if (!packer.Insert(r.w, r.h, r.x, r.y))
+				continue;
+			SDL_assert(r.x >= 0 && r.y >= 0 && r.x + r.w <= size && r.y + r.h <= size && "Rectangle outside the packer");
+			for (const Rect& o : placed)
+				SDL_assert((r.x >= o.x + o.w || o.x >= r.x + r.w || r.y >= o.y + o.h || o.y >= r.y + r.h) && "Rectangles overlap");
+			placed.push_back(r);
+		}
+		SDL_assert(packer.GetOccupancy() > 0.75f && "Rectangle packer wastes too much space");
+
+		int px, py;
+		SDL_assert(!packer.Insert(size + 1, 1, px, py) && "Rectangle wider than the packer fit");
+		packer.Clear();
+		SDL_assert(packer.Insert(size, size, px, py) && px == 0 && py == 0 && "Clear didn't free the space");
+	}
+
+	// Needs a GL context, run it after the engine created the window.
+	void Test_UIManager()
+	{
+		// counts how often the manager lays it out
+		struct CountingPanel : public UIComponent
+		{
+			int layouts = 0;
+			CountingPanel(float width, float height, float x, float y) : UIComponent(width, height, x, y) {}
+			void Layout(const UIComponent* parent) override
+			{
+				++layouts;
+				UIComponent::Layout(parent);
+			}
+		};
+
+		// pixel sized panels anchored bottom left, so rectangles are easy to read
+		auto panel = [](Entity* parent, float width, float height, float x, float y, const char* action)
+		{
+			auto e = EntityManager::Instance().Create();
+			auto c = ComponentManager<UIComponent>::Instance().Create<CountingPanel>(width, height, x, y);
+			c->xType = UNIT_PIXEL;
+			c->yType = UNIT_PIXEL;
+			c->vAnchor = ANCHOR_BOTTOM;
+			c->hAnchor = ANCHOR_LEFT;
+			c->ClickAction = action;
+			e->AddComponent(c);
+			if (parent)
+				parent->AddChild(e);
+			return c;
+		};
+
+		// root 0..100 square, rectangles are left..right x bottom..top, z is the depth in the tree
+		auto root = panel(nullptr, 100, 100, 0, 0, "");
+		auto a = panel(root->GetEntity(), 50, 50, 0, 0, "a");			// 0..50 x 0..50
+		auto a1 = panel(a->GetEntity(), 40, 40, 30, 0, "a1");			// 30..70 x 0..40, clipped to 30..50 by a
+		auto b = panel(root->GetEntity(), 50, 50, 50, 0, "b");			// 50..100 x 0..50
+		auto b1 = panel(b->GetEntity(), 10, 10, 5, 5, "");				// not clickable
+		auto c = panel(root->GetEntity(), 30, 30, 40, 10, "c");			// 40..70 x 10..40, above everything
+		c->zForce = 5;
+		auto d = panel(root->GetEntity(), 30, 20, 60, 60, "d");			// 60..90 x 60..80
+
+		static std::string clicked;
+		UIManager ui;
+		ui.DefineClickFunction("a", []() { clicked = "a"; });
+		ui.DefineClickFunction("a1", []() { clicked = "a1"; });
+		ui.DefineClickFunction("b", []() { clicked = "b"; });
+		ui.DefineClickFunction("c", []() { clicked = "c"; });
+		ui.DefineClickFunction("d", []() { clicked = "d"; });
+		// window coordinates go down from the top of the root
+		auto click = [&ui, root](float x, float y)
+		{
+			clicked = "";
+			ui.ClickUI(root, x, root->screenSize.y - y);
+			return clicked;
+		};
+
+		CountingPanel* panels[] = { root, a, a1, b, b1, c, d };
+		ui.Update(0.0f);
+		for (auto p : panels)
+			SDL_assert(p->layouts == 1 && "Every panel should be laid out once.");
+
+		// nothing changed, nothing is laid out
+		ui.Update(0.0f);
+		for (auto p : panels)
+			SDL_assert(p->layouts == 1 && "Unchanged panels shouldn't be laid out again.");
+
+		// a changed panel lays out itself and its subtree only
+		b->size = glm::vec2(50, 55);
+		ui.Update(0.0f);
+		SDL_assert(b->layouts == 2 && b1->layouts == 2 && "Changed subtree should be laid out again.");
+		SDL_assert(root->layouts == 1 && a->layouts == 1 && a1->layouts == 1 && c->layouts == 1 && d->layouts == 1
+			&& "Panels outside the changed subtree shouldn't be laid out again.");
+		SDL_assert(GLM_EQUAL(glm::vec3(b->screenSize, 0), glm::vec3(50, 55, 0)));
+
+		SDL_assert(click(10, 10) == "a");
+		// deeper panel is higher
+		SDL_assert(click(35, 5) == "a1");
+		// a1 reaches past a, but is clipped to it, so b gets the click
+		SDL_assert(click(60, 5) == "b");
+		// highest z wins where a, a1 and c overlap
+		SDL_assert(click(45, 20) == "c");
+		SDL_assert(click(75, 70) == "d");
+		// below d, but in the same grid cell and right of its bottom edge value (pointInRect used x there)
+		SDL_assert(click(75, 58) == "" && "Click below a panel shouldn't hit it.");
+
+		// a grown panel gets the clicks of its new area
+		d->size = glm::vec2(30, 30);
+		d->anchor = glm::vec2(60, 56);
+		ui.Update(0.0f);
+		SDL_assert(d->layouts == 2);
+		SDL_assert(click(75, 58) == "d" && "Click grid should follow a moved panel.");
+
+		root->GetEntity()->Destroy();
+	}
+
+	// needs a GL context for the cluster buffers
+	void Test_LightClusters()
+	{
+		// a light without intensity reaches nothing, whatever its attenuation
+		Light dark;
+		dark.setType(Light::LightType::Point);
+		dark.setColor(Color(0.0f, 0.0f, 0.0f));
+		SDL_assert(RenderSystem::lightRadius(&dark) == 0.0f && "Zero intensity light should have no radius.");
+		dark.setAttenuation(1.0f, 0.0f, 0.025f);
+		SDL_assert(RenderSystem::lightRadius(&dark) == 0.0f && "Zero intensity light should have no radius.");
+
+		// too dim to pass the cutoff at any distance, the quadratic has no real root
+		Light dim;
+		dim.setType(Light::LightType::Point);
+		dim.setColor(Color(0.001f, 0.001f, 0.001f));
+		dim.setAttenuation(1.0f, 0.0f, 0.025f);
+		const float dimRadius = RenderSystem::lightRadius(&dim);
+		SDL_assert(dimRadius == 0.0f && "Light below the cutoff should have no radius.");
+
+		Light bright;
+		bright.setType(Light::LightType::Point);
+		const float brightRadius = RenderSystem::lightRadius(&bright);
+		SDL_assert(brightRadius > 0.0f && brightRadius < 1000.0f);
+
+		const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+		auto pointLight = [](glm::vec3 position, float range)
+		{
+			LightClusters::LightData light;
+			light.color = glm::vec4(1.0f);
+			light.position = glm::vec4(position, range);
+			light.direction = glm::vec4(0.0f);
+			light.attenuation = glm::vec4(1.0f, 0.25f, 0.025f, 1.0f);
+			return light;
+		};
+
+		// zero and broken ranges are in the light list but in no cluster
+		LightClusters clusters;
+		clusters.addLight(pointLight(glm::vec3(0, 0, -10), RenderSystem::lightRadius(&dark)));
+		clusters.addLight(pointLight(glm::vec3(0, 0, -10), std::numeric_limits<float>::quiet_NaN()));
+		clusters.build(projection, 0.1f, 100.0f);
+		SDL_assert(clusters.getLightCount() == 2);
+		SDL_assert(clusters.getIndexCount() == 0 && "Light without a radius shouldn't be binned.");
+
+		// a visible light still is
+		clusters.clear();
+		clusters.addLight(pointLight(glm::vec3(0, 0, -10), brightRadius));
+		clusters.build(projection, 0.1f, 100.0f);
+		SDL_assert(clusters.getLightCount() == 1);
+		SDL_assert(clusters.getIndexCount() > 0 && "Visible light should be binned.");
+	}
+
+	// Pass the engine's render system to also count the GL calls of one real frame.
+	void Benchmark_ShaderUniforms(RenderSystem* renderSystem = nullptr)
+	{
+		const int count = 10000;
+		const char* vsh =
+			"#version 330 core\n"
+			"layout(location = 0) in vec3 position;\n"
+			"uniform mat4 transform;\n"
+			"uniform mat4 transformNoPerspective;\n"
+			"uniform mat4 invTransform;\n"
+			"layout (std140) uniform Object { mat4 blockTransform; vec4 blockColor; };\n"
+			"void main() { gl_Position = transform * transformNoPerspective * invTransform * blockTransform * vec4(position, 1.0); }\n";
+		const char* fsh =
+			"#version 330 core\n"
+			"out vec4 result;\n"
+			"uniform vec3 color;\n"
+			"uniform float shininess;\n"
+			"uniform float smoothness;\n"
+			"uniform int textureID;\n"
+			"layout (std140) uniform Object { mat4 blockTransform; vec4 blockColor; };\n"
+			"void main() { result = vec4(color * shininess * smoothness * float(textureID), 1.0) * blockColor; }\n";
+		Shader shader("benchmark", vsh, fsh);
+		bool compiled = shader.compile();
+		SDL_assert(compiled && "Benchmark shader failed to compile");
+		shader.setBindingPoint("Object", 0);
+		glUseProgram(shader.getProgram());
+
+		const glm::mat4 m(1.0f);
+		const glm::vec3 v(1.0f);
+		const char* names[] = { "transform", "transformNoPerspective", "invTransform" };
+
+		CpuProfiler profiler;
+		profiler.InitializeTimers(3);
+		uint64_t calls[3];
+		GLCallCounter::install();
+
+		// what every g-buffer draw used to do, a name lookup per set
+		GLCallCounter::reset();
+		profiler.StartTimer(0);
+		for (int i = 0; i < count; ++i)
+		{
+			for (const char* name : names)
+				glUniformMatrix4fv(glGetUniformLocation(shader.getProgram(), name), 1, GL_FALSE, &m[0][0]);
+			glUniform3f(glGetUniformLocation(shader.getProgram(), "color"), v.x, v.y, v.z);
+			glUniform1f(glGetUniformLocation(shader.getProgram(), "shininess"), 1.0f);
+			glUniform1f(glGetUniformLocation(shader.getProgram(), "smoothness"), 1.0f);
+			glUniform1i(glGetUniformLocation(shader.getProgram(), "textureID"), 0);
+		}
+		profiler.StopTimer(0);
+		calls[0] = GLCallCounter::getCount();
+
+		// same uniforms through the reflected location table
+		GLCallCounter::reset();
+		profiler.StartTimer(1);
+		for (int i = 0; i < count; ++i)
+		{
+			shader.setUniformMatrix("transform", m);
+			shader.setUniformMatrix("transformNoPerspective", m);
+			shader.setUniformMatrix("invTransform", m);
+			shader.setUniformVec3("color", v);
+			shader.setUniformFloat("shininess", 1.0f);
+			shader.setUniformFloat("smoothness", 1.0f);
+			shader.setUniformInt("textureID", 0);
+		}
+		profiler.StopTimer(1);
+		calls[1] = GLCallCounter::getCount();
+
+		// per object blocks uploaded together, each object binds its range
+		struct Block { glm::mat4 transform; glm::vec4 color; };
+		const size_t stride = UniformBufferObject::alignedSize(sizeof(Block));
+		std::vector<unsigned char> blocks(stride * count);
+		UniformBufferObject ubo;
+		GLCallCounter::reset();
+		profiler.StartTimer(2);
+		ubo.bufferData(blocks.data(), blocks.size());
+		for (int i = 0; i < count; ++i)
+			ubo.bindRange(0, stride * i, sizeof(Block));
+		profiler.StopTimer(2);
+		calls[2] = GLCallCounter::getCount();
+
+		// the frame that was captured last, drawn again
+		uint64_t frameCalls = 0;
+		if (renderSystem)
+		{
+			glUseProgram(0);
+			GLCallCounter::reset();
+			renderSystem->Update(0.0f);
+			frameCalls = GLCallCounter::getCount();
+		}
+
+		GLCallCounter::uninstall();
+		glUseProgram(0);
+
+		SDL_assert(calls[1] * 2 == calls[0] && "The location table should skip every glGetUniformLocation");
+		SDL_assert(calls[2] < (uint64_t)count + 8 && "A block should cost one bind per object");
+
+		const char* paths[] = { "name lookup", "location table", "uniform block" };
+		for (int k = 0; k < 3; ++k)
+		{
+			std::cout << "Uniforms: " << paths[k] << " "
+				<< (double)calls[k] / count << " GL calls, "
+				<< (double)profiler.GetDuration(k) / count << "ns per object" << std::endl;
+		}
+
+		if (renderSystem)
+		{
+			const size_t drawn = renderSystem->getCullStats().drawn;
+			std::cout << "Uniforms: frame " << frameCalls << " GL calls, "
+				<< drawn << " objects drawn";
+			if (drawn > 0)
+				std::cout << ", " << (double)frameCalls / drawn << " per object";
+			std::cout << std::endl;
+		}
+	}
+};
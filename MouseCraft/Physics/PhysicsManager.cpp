@@ -14,6 +14,13 @@ PhysicsManager::PhysicsManager()
 
 	profiler.InitializeTimers(4);
 	profiler.LogOutput("Physics.log");	// optional
+
+	// collision and landing callbacks run gameplay code, which spawns and destroys entities
+	RunOnMainThread(true);
+	Writes<PhysicsManager>();	// the box2d world and grid
+	Writes<PhysicsComponent>();
+	Writes<Transform>();
+	Writes<GameplayCode>();
 }
 
 PhysicsManager::~PhysicsManager()
@@ -44,7 +51,7 @@ void PhysicsManager::Update(float dt)
 	Resolve body status. This allows use to disable entities or components. 
 	Note: OmegaEngine guarantees that entity life/status will not change during system updates. 	
 	*/
-	auto physicComponents = ComponentManager<PhysicsComponent>::Instance().All();
+	const auto& physicComponents = ComponentManager<PhysicsComponent>::Instance().All();
 	for (auto& pc : physicComponents)
 	{
 		// performance should be ok referring to the latest revision of b2body.cpp 
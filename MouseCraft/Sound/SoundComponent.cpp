@@ -17,16 +17,15 @@ void SoundComponent::OnInitialized()
 void SoundComponent::PlaySound(float x, float y, float z)
 {
     //convert our information into a sound parameter
-    SoundParams * ourParam = new SoundParams;
+    SoundParams ourParam;
     //load sound handle
-    ourParam->sound = ourSound;
+    ourParam.sound = ourSound;
     //Include Location data from arguments
-    ourParam->x = x;
-    ourParam->y = y;
-    ourParam->z = z;
-    //convert to event required form, fire event
-    TypeParam<SoundParams*> param(ourParam);
-    EventManager::Notify(PLAY_SOUND, &param);
+    ourParam.x = x;
+    ourParam.y = y;
+    ourParam.z = z;
+    //fire event (wrapped in a TypeParam<SoundParams>)
+    EventManager::Notify(PLAY_SOUND, ourParam);
 }
 
 void SoundComponent::ChangeSound(SoundsList sound)
@@ -251,30 +251,26 @@ void SoundManager::Notify(EventName eventName, Param* param) {
     //switch based on event name to handle properly
     switch (eventName) {
         case PLAY_SONG: { //play a piece of BGM
-            TrackParams* TrackInfo;
             // Safetly cast generic param pointer to a specific type
-            TypeParam<TrackParams *> *p = dynamic_cast<TypeParam<TrackParams*> *>(param);
+            TypeParam<TrackParams> *p = dynamic_cast<TypeParam<TrackParams> *>(param);
             if (p != nullptr) {
                 // Successful type cast
                 //extract out the Track Params object
-                TrackInfo = p->Param;
+                const TrackParams& TrackInfo = p->Param;
                 //call the play song method with the Track Param data
-                PlaySong(TrackInfo->track, TrackInfo->x, TrackInfo->y, TrackInfo->z);
+                PlaySong(TrackInfo.track, TrackInfo.x, TrackInfo.y, TrackInfo.z);
             }
             break;
         }
         case PLAY_SOUND:{ //play a specific sound
-            SoundParams* SoundInfo;
             // Safetly cast generic param pointer to a specific type
-            TypeParam<SoundParams*> *sound = dynamic_cast<TypeParam<SoundParams*> *>(param);
+            TypeParam<SoundParams> *sound = dynamic_cast<TypeParam<SoundParams> *>(param);
             if (sound != nullptr) {
                 // Successful type cast
                 //extract out the Sound Params object
-                SoundInfo = sound->Param;
+                const SoundParams& SoundInfo = sound->Param;
                 //call the play sound method with the Sound Param data
-                PlaySound(SoundInfo->sound, SoundInfo->x, SoundInfo->y, SoundInfo->z);
-                //delete pointers so they don't stay in the heap
-                delete SoundInfo;
+                PlaySound(SoundInfo.sound, SoundInfo.x, SoundInfo.y, SoundInfo.z);
             }
             break;
         }
@@ -1,7 +1,24 @@
 #include "ImageComponent.h"
+#include <map>
+#include <memory>
+#include <mutex>
+
+// One string per path, shared by every image showing it. Never freed, the renderer may
+// still be reading the model's texture while the component changes it, but there are
+// only as many as there are image files.
+static std::string* internPath(const std::string& path) {
+	static std::mutex mtx;
+	static std::map<std::string, std::unique_ptr<std::string>> paths;
+
+	std::unique_lock<std::mutex> lock(mtx);
+	auto& interned = paths[path];
+	if (!interned)
+		interned.reset(new std::string(path));
+	return interned.get();
+}
 
 ImageComponent::ImageComponent(std::string imagePath, float width, float height, float x, float y) :
-    UIComponent(width, height, x, y), _imagePath(imagePath) {
+    UIComponent(width, height, x, y), _imagePath(imagePath), _texture(internPath(imagePath)) {
 
     //aspectRatio = float(texture.width) / texture.height;
     color = Color(1, 1, 1);
@@ -14,10 +31,14 @@ std::string ImageComponent::GetImagePath() {
 }
 
 void ImageComponent::SetImagePath(std::string path) {
-	_imagePath = path;
+	if (path != _imagePath) {
+		_imagePath = path;
+		_texture = internPath(path);
+		valid = false;
+	}
 }
 
 void ImageComponent::setupModels() {
 	UIComponent::setupModels();
-	models[0]->setTexture(new std::string(_imagePath));
+	models[0]->setTexture(_texture);
 }
\ No newline at end of file
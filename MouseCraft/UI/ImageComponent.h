@@ -14,4 +14,5 @@ public:
 	void SetImagePath(std::string path);
 private:
     std::string _imagePath;
+	std::string* _texture;	// one shared string per path, never freed
 };
\ No newline at end of file
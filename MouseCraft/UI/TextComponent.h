@@ -1,6 +1,7 @@
 #pragma once
 
 #include "UIManager.h"
+#include "../Graphics/TextMesh.h"
 
 /**
 Type of UIComponent that renders text to the panel, through the means of a bitmap font
@@ -12,7 +13,7 @@ public:
 
     TextComponent(std::string text, float fontSize, float x, float y, std::string fontPath = DEFAULT_FONT);
 
-    void Resize();
+    void Layout(const UIComponent* parent) override;
     bool IsTransparent();
 
 	void SetSpacing(float spacing);
@@ -21,11 +22,11 @@ public:
 	// Change the text on this component
     void SetText(std::string text);
 private:
-    glm::vec2 getUVfromChar(const char c);
     void generateVertices();
 
     std::string _text;
     float       _fontSize;
 	float		_spacing;
 	std::string	_fontPath;
+	const TextMesh::FontMetrics* _font;
 };
\ No newline at end of file
@@ -28,18 +28,31 @@ UIComponent::UIComponent(float width, float height, float x, float y) :
 
 UIComponent::~UIComponent() {
 	for (Model* model : models) {
+		delete model->getGeometry();
 		delete model;
 	}
 }
 
 void UIComponent::Resize() {
-	if (this->GetEntity() != nullptr) {
-		glm::vec2 parentSize = { 1.0f, 1.0f };
-		Entity* parent = this->GetEntity()->GetParent();
-		if (parent != nullptr && parent->GetComponent<UIComponent>() != nullptr) {
-			UIComponent* cmp = parent->GetComponent<UIComponent>();
-			parentSize = cmp->screenSize;
+	Entity* e = this->GetEntity();
+	if (e == nullptr) {
+		return;
+	}
+	Entity* parent = e->GetParent();
+	Layout(parent != nullptr ? parent->GetComponent<UIComponent>() : nullptr);
+
+	// Iterate resize on child panels
+	for (Entity* child : e->GetChildren()) {
+		UIComponent* comp = child->GetComponent<UIComponent>();
+		if (comp != nullptr) {
+			comp->Resize();
 		}
+	}
+}
+
+void UIComponent::Layout(const UIComponent* parent) {
+	if (this->GetEntity() != nullptr) {
+		glm::vec2 parentSize = parent != nullptr ? parent->screenSize : glm::vec2(1.0f, 1.0f);
 
 		// Calculate pixel size of panel based on Unit Type
 		switch (xType) {
@@ -65,27 +78,26 @@ void UIComponent::Resize() {
 			screenSize.x = screenSize.y * aspectRatio;
 		}
 
-		calculateScreenPosition();
+		calculateScreenPosition(parent);
 
 		// Generate vertices of quad from position and size of panel
 		setupModels();
 
-		// Iterate resize on child panels
-		auto children = this->GetEntity()->GetChildren();
-		for (Entity *child : children) {
-			UIComponent* comp = child->GetComponent<UIComponent>();
-			if (comp != nullptr) {
-				comp->Resize();
-			}
-		}
-
 		valid = true;
 	}
 }
 
 void UIComponent::setupModels() {
-	models.clear();
-	models.push_back(ModelGen::makeQuad(ModelGen::Axis::Z, screenSize.x, screenSize.y));
+	// keep the model, only its geometry changes size
+	Model* quad = ModelGen::makeQuad(ModelGen::Axis::Z, screenSize.x, screenSize.y);
+	if (models.empty()) {
+		models.push_back(quad);
+	}
+	else {
+		delete models[0]->getGeometry();
+		models[0]->setGeometry(quad->getGeometry());
+		delete quad;
+	}
 
 	// Shenanigans to set the position independent of parent location
 	// This is fine since the parents are resized first
@@ -104,18 +116,16 @@ bool UIComponent::IsTransparent() {
     return color.getAlpha() < 1.0f;
 }
 
-void UIComponent::calculateScreenPosition() {
+void UIComponent::calculateScreenPosition(const UIComponent* parent) {
 	Entity* e = GetEntity();
 	if (e != nullptr) {
 		glm::vec2 parentSize = { 1.0f, 1.0f };
 		glm::vec2 parentPosition = { 0.0f, 0.0f };
 		float parentZ = 0.0f;
-		Entity* parent = this->GetEntity()->GetParent();
-		if (parent != nullptr && parent->GetComponent<UIComponent>() != nullptr) {
-			UIComponent* cmp = parent->GetComponent<UIComponent>();
-			parentSize = cmp->screenSize;
-			parentPosition = cmp->screenPosition;
-			parentZ = cmp->z;
+		if (parent != nullptr) {
+			parentSize = parent->screenSize;
+			parentPosition = parent->screenPosition;
+			parentZ = parent->z;
 		}
 		// Calculate Anchor Position of panel based on anchor unit type
 		glm::vec2 screenAnchor;
@@ -37,8 +37,11 @@ public:
     UIComponent(float width, float height, float x, float y);
     ~UIComponent();
 
-	// Recalculates screen position and size
-    virtual void Resize();
+	// Recalculates screen position and size of this panel and every panel below it
+    void Resize();
+
+	// Recalculates screen position and size of this panel only, from its parent's (null for a root)
+	virtual void Layout(const UIComponent* parent);
 
 	// Determine whether this panel uses transparency
     virtual bool IsTransparent();
@@ -49,7 +52,7 @@ public:
 	// Whether or not this UIComponent and its children should be drawn
     bool                visible;
 
-	// UIComponent should be resized if Valid is set to false
+	// UIComponent should be resized if Valid is set to false, for changes the UIManager can't see (ie. new text)
 	bool				valid;
 
 	Color				color;
@@ -79,6 +82,6 @@ public:
 
 	std::vector<Model*> models;
 protected:
-	void calculateScreenPosition();
+	void calculateScreenPosition(const UIComponent* parent);
 	virtual void setupModels();
 };
\ No newline at end of file
@@ -2,42 +2,60 @@
 #include "ImageComponent.h"
 #include "TextComponent.h"
 #include "../Core/ComponentManager.h"
-#include <stack>
+#include <algorithm>
+
+#define CLICK_GRID_SIZE 16	// cells per side of a root's click grid
 
 using std::vector;
 
-UIManager::UIManager(){}
+UIManager::UIManager() {
+	// resizing positions the ui entities, gameplay code changes the panels
+	RunOnMainThread(false);
+	Writes<UIComponent>();
+	Writes<Transform>();
+	Reads<GameplayCode>();
+}
 
 void UIManager::Update(float dt) {
-	vector<UIComponent*> rootComponents;
-	
-	auto uiComponents = ComponentManager<UIComponent>::Instance().All();
-	for (auto component : uiComponents) {
-		Entity* e = component->GetEntity();
-		if (e != nullptr) {
-			Entity* parent = e->GetParent();
-			if (parent == nullptr || parent->GetComponent<UIComponent>() == nullptr) {
-				// If the entity doesn't have a parent or has a parent that doesn't have a UIComponent
-				// Then it is a root entity
-				rootComponents.push_back(component);
-			}
-		}
-	}
+	const auto& uiComponents = ComponentManager<UIComponent>::Instance().All();
+	bool rebuilt = updateTree(uiComponents);
+	layoutDirty();
 
-	for (UIComponent* component : rootComponents) {
-		Resize(component);
+	// the grids only change where something was laid out again
+	if (rebuilt) {
+		_clickGrids.clear();
+	}
+	for (int root : _roots) {
+		auto first = _dirty.begin() + root;
+		auto last = _dirty.begin() + _subtreeEnds[root];
+		if (rebuilt || std::find(first, last, 1) != last) {
+			buildClickGrid(root);
+		}
 	}
+	std::fill(_dirty.begin(), _dirty.end(), 0);
 }
 
 void UIManager::Resize(UIComponent* root) {
     root->Resize();
+
+	// laid out again with the next update, so the clip rectangles and click grid follow
+	auto it = _nodeIndices.find(root);
+	if (it != _nodeIndices.end()) {
+		_dirty[it->second] = 1;
+	}
 }
 
 void UIManager::ClickUI(UIComponent* root, float x, float y) {
-	UIComponent* select = root;
-	findTopClick(&select, root, x, root->screenSize.y - y);
-	if (select != root) {
-		_clickFunctions[select->ClickAction]();
+	auto it = _nodeIndices.find(root);
+	if (it == _nodeIndices.end()) {
+		return;
+	}
+	UIComponent* select = findTopClick(it->second, x, root->screenSize.y - y);
+	if (select != nullptr) {
+		auto click = _clickFunctions.find(select->ClickAction);
+		if (click != _clickFunctions.end() && click->second != nullptr) {
+			click->second();
+		}
 	}
 }
 
@@ -49,36 +67,202 @@ void UIManager::defineClicks() {
 
 }
 
-void UIManager::findTopClick(UIComponent** top, UIComponent* comp, const float x, const float y) {
-	for (Entity* e : comp->GetEntity()->GetChildren()) {
-		UIComponent* c = e->GetComponent<UIComponent>();
-		if (c->visible && pointInRect(x, y, c->screenPosition.y + c->screenSize.y,
-			c->screenPosition.x + c->screenSize.x, c->screenPosition.x, c->screenPosition.y)) {
-			if (c->ClickAction != "" && c->z > (*top)->z) {
-				*top = c;
+bool UIManager::updateTree(const vector<UIComponent*>& components) {
+	// same components with the same parents, the tree still holds
+	bool same = components == _components;
+	if (same) {
+		size_t attached = 0;
+		for (UIComponent* c : components) {
+			if (c->GetEntity() != nullptr) {
+				++attached;
 			}
-			findTopClick(top, c, x, y);
+		}
+		same = attached == _nodes.size();
+	}
+	for (size_t i = 0; same && i < _nodes.size(); ++i) {
+		same = _nodes[i]->GetEntity() != nullptr && _nodes[i]->GetEntity()->GetParent() == _parentEntities[i];
+	}
+	if (same) {
+		return false;
+	}
+
+	_components = components;
+	_nodes.clear();
+	_parents.clear();
+	_subtreeEnds.clear();
+	_parentEntities.clear();
+	_roots.clear();
+	_nodeIndices.clear();
+	for (UIComponent* component : components) {
+		Entity* e = component->GetEntity();
+		if (e != nullptr) {
+			Entity* parent = e->GetParent();
+			if (parent == nullptr || parent->GetComponent<UIComponent>() == nullptr) {
+				// If the entity doesn't have a parent or has a parent that doesn't have a UIComponent
+				// Then it is a root entity
+				addSubtree(component, -1);
+			}
+		}
+	}
+
+	// everything is laid out again, panels may have moved under a parent with another size
+	const size_t count = _nodes.size();
+	_inputs.resize(count);
+	_dirty.assign(count, 1);
+	_clipRects.resize(count);
+	_visible.resize(count);
+	_clickable.resize(count);
+	return true;
+}
+
+void UIManager::addSubtree(UIComponent* component, int parent) {
+	const int index = (int)_nodes.size();
+	Entity* e = component->GetEntity();
+	_nodes.push_back(component);
+	_parents.push_back(parent);
+	_subtreeEnds.push_back(index + 1);
+	_parentEntities.push_back(e->GetParent());
+	_nodeIndices[component] = index;
+	if (parent < 0) {
+		_roots.push_back(index);
+	}
+
+	for (Entity* child : e->GetChildren()) {
+		UIComponent* comp = child->GetComponent<UIComponent>();
+		if (comp != nullptr) {
+			addSubtree(comp, index);
 		}
 	}
+	_subtreeEnds[index] = (int)_nodes.size();
 }
 
-bool UIManager::pointInRect(float px, float py, float rTop, float rRight, float rLeft, float rBottom) {
-    return (px > rLeft && px < rRight && py < rTop && px > rBottom);
+void UIManager::layoutDirty() {
+	// parents come first, so they are laid out (and their dirt passed on) before their children
+	for (size_t i = 0; i < _nodes.size(); ++i) {
+		UIComponent* c = _nodes[i];
+		const int parent = _parents[i];
+		const LayoutInputs inputs = readInputs(c);
+		if (!_dirty[i] && c->valid && sameInputs(inputs, _inputs[i]) && (parent < 0 || !_dirty[parent])) {
+			continue;
+		}
+		_dirty[i] = 1;
+		_inputs[i] = inputs;
+		c->Layout(parent >= 0 ? _nodes[parent] : nullptr);
+
+		// clicks only reach a panel inside every ancestor below the root, the root itself isn't tested
+		glm::vec4 rect(c->screenPosition, c->screenPosition + c->screenSize);
+		if (parent >= 0 && _parents[parent] >= 0) {
+			const glm::vec4& clip = _clipRects[parent];
+			rect = glm::vec4(std::max(rect.x, clip.x), std::max(rect.y, clip.y), std::min(rect.z, clip.z), std::min(rect.w, clip.w));
+		}
+		_clipRects[i] = rect;
+		_visible[i] = parent < 0 || (c->visible && _visible[parent]);
+		_clickable[i] = parent >= 0 && _visible[i] && inputs.clickable;
+	}
 }
 
-void UIManager::traverseChildren(UIComponent *component) {
-	if (component != nullptr) {
-		// Resize if invalidated
-		if (!component->valid) {
-			component->Resize();
+void UIManager::buildClickGrid(int root) {
+	const UIComponent* r = _nodes[root];
+	ClickGrid& grid = _clickGrids[root];
+	grid.origin = r->screenPosition;
+	grid.cellSize = glm::max(r->screenSize / (float)CLICK_GRID_SIZE, glm::vec2(1e-6f));
+	grid.cellStarts.assign(CLICK_GRID_SIZE * CLICK_GRID_SIZE + 1, 0);
+	grid.entries.clear();
+
+	// cells a clipped rectangle touches, panels outside the root land on its edge cells
+	auto cellRange = [&grid](const glm::vec4& rect, int& x0, int& y0, int& x1, int& y1) {
+		auto cell = [](float v) { return std::min(std::max((int)v, 0), CLICK_GRID_SIZE - 1); };
+		x0 = cell((rect.x - grid.origin.x) / grid.cellSize.x);
+		y0 = cell((rect.y - grid.origin.y) / grid.cellSize.y);
+		x1 = cell((rect.z - grid.origin.x) / grid.cellSize.x);
+		y1 = cell((rect.w - grid.origin.y) / grid.cellSize.y);
+	};
+
+	// count, then fill in tree order
+	int x0, y0, x1, y1;
+	for (int i = root + 1; i < _subtreeEnds[root]; ++i) {
+		if (!_clickable[i]) {
+			continue;
+		}
+		cellRange(_clipRects[i], x0, y0, x1, y1);
+		for (int y = y0; y <= y1; ++y) {
+			for (int x = x0; x <= x1; ++x) {
+				++grid.cellStarts[y * CLICK_GRID_SIZE + x + 1];
+			}
 		}
+	}
+	for (size_t i = 1; i < grid.cellStarts.size(); ++i) {
+		grid.cellStarts[i] += grid.cellStarts[i - 1];
+	}
+	grid.entries.resize(grid.cellStarts.back());
 
-		// Call recursively on children in DFS style
-		for (Entity* e : component->GetEntity()->GetChildren()) {
-			UIComponent* child = e->GetComponent<UIComponent>();
-			if (child->visible) {
-				traverseChildren(child);
+	vector<int> next(grid.cellStarts.begin(), grid.cellStarts.end() - 1);
+	for (int i = root + 1; i < _subtreeEnds[root]; ++i) {
+		if (!_clickable[i]) {
+			continue;
+		}
+		cellRange(_clipRects[i], x0, y0, x1, y1);
+		for (int y = y0; y <= y1; ++y) {
+			for (int x = x0; x <= x1; ++x) {
+				grid.entries[next[y * CLICK_GRID_SIZE + x]++] = i;
 			}
 		}
 	}
-}
\ No newline at end of file
+}
+
+UIComponent* UIManager::findTopClick(int node, const float x, const float y) const {
+	int root = node;
+	while (_parents[root] >= 0) {
+		root = _parents[root];
+	}
+	auto it = _clickGrids.find(root);
+	if (it == _clickGrids.end()) {
+		return nullptr;
+	}
+	const ClickGrid& grid = it->second;
+	const int cellX = std::min(std::max((int)((x - grid.origin.x) / grid.cellSize.x), 0), CLICK_GRID_SIZE - 1);
+	const int cellY = std::min(std::max((int)((y - grid.origin.y) / grid.cellSize.y), 0), CLICK_GRID_SIZE - 1);
+	const int cell = cellY * CLICK_GRID_SIZE + cellX;
+
+	// the highest panel wins, the first one in tree order if they're level
+	UIComponent* top = _nodes[node];
+	for (int e = grid.cellStarts[cell]; e < grid.cellStarts[cell + 1]; ++e) {
+		int i = grid.entries[e];
+		if (i <= node || i >= _subtreeEnds[node]) {
+			continue;
+		}
+		const glm::vec4& rect = _clipRects[i];
+		UIComponent* c = _nodes[i];
+		if (pointInRect(x, y, rect.w, rect.z, rect.x, rect.y) && c->ClickAction != "" && c->z > top->z) {
+			top = c;
+		}
+	}
+	return top != _nodes[node] ? top : nullptr;
+}
+
+bool UIManager::pointInRect(float px, float py, float rTop, float rRight, float rLeft, float rBottom) const {
+    return (px > rLeft && px < rRight && py < rTop && py > rBottom);
+}
+
+UIManager::LayoutInputs UIManager::readInputs(const UIComponent* c) {
+	LayoutInputs inputs;
+	inputs.size = c->size;
+	inputs.anchor = c->anchor;
+	inputs.zForce = c->zForce;
+	inputs.aspectRatio = c->aspectRatio;
+	inputs.vAnchor = c->vAnchor;
+	inputs.hAnchor = c->hAnchor;
+	inputs.anchorXType = c->anchorXType;
+	inputs.anchorYType = c->anchorYType;
+	inputs.xType = c->xType;
+	inputs.yType = c->yType;
+	inputs.visible = c->visible;
+	inputs.clickable = !c->ClickAction.empty();
+	return inputs;
+}
+
+bool UIManager::sameInputs(const LayoutInputs& a, const LayoutInputs& b) {
+	return a.size == b.size && a.anchor == b.anchor && a.zForce == b.zForce && a.aspectRatio == b.aspectRatio
+		&& a.vAnchor == b.vAnchor && a.hAnchor == b.hAnchor && a.anchorXType == b.anchorXType && a.anchorYType == b.anchorYType
+		&& a.xType == b.xType && a.yType == b.yType && a.visible == b.visible && a.clickable == b.clickable;
+}
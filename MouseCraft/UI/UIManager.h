@@ -2,15 +2,25 @@
 
 #include <map>
 #include <string>
+#include <vector>
+#include <unordered_map>
 #ifndef NOMINMAX
 #define NOMINMAX 1
 #endif
 #include <windows.h>
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
 #include "UIComponent.h"
 #include "../Core/System.h"
 
 /**
 Static structure used to store the UI data, and methods to interact with UI
+
+The UI tree is kept between frames in flat arrays, parents before their children (depth first),
+so a subtree is one range of indices. Every frame the layout inputs of each panel are compared
+with the ones it was last laid out with; a changed panel and everything below it are marked
+dirty, and one pass over the arrays lays out only the dirty panels.
+Clickable panels are kept in a grid over their root, so a click only tests the panels of one cell.
 */
 class UIManager : public System {
 public:
@@ -26,18 +36,65 @@ public:
 	// Define an on-click function passing in its label and the function to execute
     void DefineClickFunction(const std::string name, void(*f)());
 private:
+	// Everything about a panel its layout depends on, besides its parent's layout
+	struct LayoutInputs {
+		glm::vec2 size;
+		glm::vec2 anchor;
+		float zForce;
+		float aspectRatio;
+		int vAnchor;
+		int hAnchor;
+		int anchorXType;
+		int anchorYType;
+		int xType;
+		int yType;
+		bool visible;
+		bool clickable;
+	};
+
+	// Clickable panels of one root, bucketed by the cells their clipped rectangle touches
+	struct ClickGrid {
+		glm::vec2 origin;
+		glm::vec2 cellSize;
+		std::vector<int> cellStarts;	// cell i holds entries [cellStarts[i], cellStarts[i + 1])
+		std::vector<int> entries;		// node indices, in tree order
+	};
+
 	// Initial definition of all on-click functions
 	void defineClicks();
 
-	// Find the top element under your cursor that has an on-click event and store it in the top pointer location
-	void findTopClick(UIComponent** top, UIComponent* comp, const float x, const float y);
+	// Rebuild the flat tree if panels were added, removed or moved to another parent
+	bool updateTree(const std::vector<UIComponent*>& components);
+	void addSubtree(UIComponent* component, int parent);
+
+	// Mark changed panels and their subtrees dirty, lay out the dirty ones
+	void layoutDirty();
+
+	void buildClickGrid(int root);
+
+	// Find the top element under your cursor that has an on-click event, nullptr if there is none
+	UIComponent* findTopClick(int node, const float x, const float y) const;
 
 	// Is the given point in the defined rectangle
-    bool pointInRect(float px, float py, float rTop, float rRight, float rLeft, float rBottom);
+    bool pointInRect(float px, float py, float rTop, float rRight, float rLeft, float rBottom) const;
+
+	static LayoutInputs readInputs(const UIComponent* component);
+	static bool sameInputs(const LayoutInputs& a, const LayoutInputs& b);
 
-	// Recursive function used to traverse UI tree and resize elements
-	void traverseChildren(UIComponent *component);
+	// the flat tree, one entry per panel
+	std::vector<UIComponent*> _nodes;
+	std::vector<int> _parents;				// -1 for roots
+	std::vector<int> _subtreeEnds;			// one past the last panel below
+	std::vector<Entity*> _parentEntities;	// to notice panels moving
+	std::vector<LayoutInputs> _inputs;		// what each panel was last laid out with
+	std::vector<unsigned char> _dirty;
+	std::vector<glm::vec4> _clipRects;		// left, bottom, right, top of the panel within its ancestors
+	std::vector<unsigned char> _visible;	// the panel and every ancestor below the root
+	std::vector<unsigned char> _clickable;	// visible and has a click action
+	std::vector<int> _roots;
+	std::unordered_map<UIComponent*, int> _nodeIndices;
+	std::unordered_map<int, ClickGrid> _clickGrids;	// by root node
+	std::vector<UIComponent*> _components;	// the component list the tree was built from
 
-    std::vector<UIComponent*> _roots;
     std::map<const std::string, void(*)()> _clickFunctions;
 };
\ No newline at end of file
@@ -0,0 +1,269 @@
+#include "AABBTree.h"
+#include <algorithm>
+
+// half the surface area, only compared against other areas
+static inline float area(const glm::vec3& min, const glm::vec3& max)
+{
+	glm::vec3 d = max - min;
+	return d.x * d.y + d.y * d.z + d.z * d.x;
+}
+
+static inline bool contains(const glm::vec3& outerMin, const glm::vec3& outerMax, const glm::vec3& min, const glm::vec3& max)
+{
+	return glm::all(glm::lessThanEqual(outerMin, min)) && glm::all(glm::lessThanEqual(max, outerMax));
+}
+
+AABBTree::AABBTree(float margin) :
+	_root(NULL_NODE), _freeList(NULL_NODE), _leafCount(0), _margin(margin)
+{
+}
+
+int AABBTree::Insert(const glm::vec3& min, const glm::vec3& max, void* data)
+{
+	int leaf = allocateNode();
+	_nodes[leaf].min = min - glm::vec3(_margin);
+	_nodes[leaf].max = max + glm::vec3(_margin);
+	_nodes[leaf].data = data;
+	_nodes[leaf].height = 0;
+	insertLeaf(leaf);
+	++_leafCount;
+	return leaf;
+}
+
+void AABBTree::Remove(int proxy)
+{
+	removeLeaf(proxy);
+	freeNode(proxy);
+	--_leafCount;
+}
+
+bool AABBTree::Move(int proxy, const glm::vec3& min, const glm::vec3& max)
+{
+	if (contains(_nodes[proxy].min, _nodes[proxy].max, min, max))
+		return false;
+
+	removeLeaf(proxy);
+	_nodes[proxy].min = min - glm::vec3(_margin);
+	_nodes[proxy].max = max + glm::vec3(_margin);
+	insertLeaf(proxy);
+	return true;
+}
+
+bool AABBTree::IsLeaf(int proxy) const
+{
+	return proxy >= 0 && proxy < (int)_nodes.size() && _nodes[proxy].height == 0;
+}
+
+int AABBTree::allocateNode()
+{
+	int node;
+	if (_freeList != NULL_NODE)
+	{
+		node = _freeList;
+		_freeList = _nodes[node].parent;
+	}
+	else
+	{
+		node = (int)_nodes.size();
+		_nodes.emplace_back();
+	}
+	Node& n = _nodes[node];
+	n.data = nullptr;
+	n.parent = NULL_NODE;
+	n.child1 = NULL_NODE;
+	n.child2 = NULL_NODE;
+	n.height = 0;
+	return node;
+}
+
+void AABBTree::freeNode(int node)
+{
+	_nodes[node].parent = _freeList;
+	_nodes[node].height = -1;
+	_freeList = node;
+}
+
+void AABBTree::insertLeaf(int leaf)
+{
+	if (_root == NULL_NODE)
+	{
+		_root = leaf;
+		_nodes[leaf].parent = NULL_NODE;
+		return;
+	}
+
+	// walk down to the sibling that grows the tree the least
+	const glm::vec3 leafMin = _nodes[leaf].min;
+	const glm::vec3 leafMax = _nodes[leaf].max;
+	int index = _root;
+	while (!_nodes[index].IsLeaf())
+	{
+		const Node& node = _nodes[index];
+		const float nodeArea = area(node.min, node.max);
+		const float combinedArea = area(glm::min(node.min, leafMin), glm::max(node.max, leafMax));
+
+		// pairing with this node makes a new parent, going deeper grows this node anyway
+		const float cost = 2.0f * combinedArea;
+		const float inheritanceCost = 2.0f * (combinedArea - nodeArea);
+
+		float childCost[2];
+		const int children[2] = { node.child1, node.child2 };
+		for (int c = 0; c < 2; ++c)
+		{
+			const Node& child = _nodes[children[c]];
+			float grown = area(glm::min(child.min, leafMin), glm::max(child.max, leafMax));
+			childCost[c] = (child.IsLeaf() ? grown : grown - area(child.min, child.max)) + inheritanceCost;
+		}
+
+		if (cost < childCost[0] && cost < childCost[1])
+			break;
+		index = (childCost[0] < childCost[1]) ? children[0] : children[1];
+	}
+	const int sibling = index;
+
+	// new parent for the leaf and its sibling
+	const int oldParent = _nodes[sibling].parent;
+	const int newParent = allocateNode();
+	_nodes[newParent].parent = oldParent;
+	_nodes[newParent].min = glm::min(_nodes[sibling].min, leafMin);
+	_nodes[newParent].max = glm::max(_nodes[sibling].max, leafMax);
+	_nodes[newParent].height = _nodes[sibling].height + 1;
+	_nodes[newParent].child1 = sibling;
+	_nodes[newParent].child2 = leaf;
+	_nodes[sibling].parent = newParent;
+	_nodes[leaf].parent = newParent;
+
+	if (oldParent != NULL_NODE)
+	{
+		if (_nodes[oldParent].child1 == sibling)
+			_nodes[oldParent].child1 = newParent;
+		else
+			_nodes[oldParent].child2 = newParent;
+	}
+	else
+	{
+		_root = newParent;
+	}
+
+	// fix heights and boxes on the way back up
+	index = _nodes[leaf].parent;
+	while (index != NULL_NODE)
+	{
+		index = balance(index);
+		refit(index);
+		index = _nodes[index].parent;
+	}
+}
+
+void AABBTree::removeLeaf(int leaf)
+{
+	if (leaf == _root)
+	{
+		_root = NULL_NODE;
+		return;
+	}
+
+	const int parent = _nodes[leaf].parent;
+	const int grandParent = _nodes[parent].parent;
+	const int sibling = (_nodes[parent].child1 == leaf) ? _nodes[parent].child2 : _nodes[parent].child1;
+
+	// the sibling takes the parent's place
+	if (grandParent != NULL_NODE)
+	{
+		if (_nodes[grandParent].child1 == parent)
+			_nodes[grandParent].child1 = sibling;
+		else
+			_nodes[grandParent].child2 = sibling;
+		_nodes[sibling].parent = grandParent;
+		freeNode(parent);
+
+		int index = grandParent;
+		while (index != NULL_NODE)
+		{
+			index = balance(index);
+			refit(index);
+			index = _nodes[index].parent;
+		}
+	}
+	else
+	{
+		_root = sibling;
+		_nodes[sibling].parent = NULL_NODE;
+		freeNode(parent);
+	}
+}
+
+int AABBTree::balance(int iA)
+{
+	Node& A = _nodes[iA];
+	if (A.IsLeaf() || A.height < 2)
+		return iA;
+
+	const int iB = A.child1;
+	const int iC = A.child2;
+	Node& B = _nodes[iB];
+	Node& C = _nodes[iC];
+	const int difference = C.height - B.height;
+
+	// rotate whichever child is too tall up to A's place
+	if (difference > 1 || difference < -1)
+	{
+		const bool cUp = difference > 1;
+		const int iUp = cUp ? iC : iB;
+		Node& up = _nodes[iUp];
+		Node& other = cUp ? B : C;
+		const int iF = up.child1;
+		const int iG = up.child2;
+		Node& F = _nodes[iF];
+		Node& G = _nodes[iG];
+
+		up.child1 = iA;
+		up.parent = A.parent;
+		A.parent = iUp;
+		if (up.parent != NULL_NODE)
+		{
+			if (_nodes[up.parent].child1 == iA)
+				_nodes[up.parent].child1 = iUp;
+			else
+				_nodes[up.parent].child2 = iUp;
+		}
+		else
+		{
+			_root = iUp;
+		}
+
+		// the taller grandchild stays with the rotated node, the other goes to A
+		const bool keepF = F.height > G.height;
+		const int iKeep = keepF ? iF : iG;
+		const int iGive = keepF ? iG : iF;
+		Node& keep = _nodes[iKeep];
+		Node& give = _nodes[iGive];
+
+		up.child2 = iKeep;
+		if (cUp)
+			A.child2 = iGive;
+		else
+			A.child1 = iGive;
+		give.parent = iA;
+
+		A.min = glm::min(other.min, give.min);
+		A.max = glm::max(other.max, give.max);
+		A.height = 1 + std::max(other.height, give.height);
+		up.min = glm::min(A.min, keep.min);
+		up.max = glm::max(A.max, keep.max);
+		up.height = 1 + std::max(A.height, keep.height);
+		return iUp;
+	}
+
+	return iA;
+}
+
+void AABBTree::refit(int index)
+{
+	Node& node = _nodes[index];
+	const Node& child1 = _nodes[node.child1];
+	const Node& child2 = _nodes[node.child2];
+	node.height = 1 + std::max(child1.height, child2.height);
+	node.min = glm::min(child1.min, child2.min);
+	node.max = glm::max(child1.max, child2.max);
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+// Dynamic bounding volume hierarchy of axis aligned boxes.
+// Leaves store a box grown by a margin, so objects moving a little don't touch the tree.
+// Inserting picks the sibling that grows the tree's surface area the least and rotations
+// keep it balanced (like Box2D's b2DynamicTree). Not thread safe.
+class AABBTree
+{
+public:
+	static const int NULL_NODE = -1;
+
+	// Result of an overlap test for query.
+	enum Overlap
+	{
+		OUTSIDE,	// skip the node and everything below it
+		INTERSECTS,	// test the children
+		INSIDE		// everything below it overlaps, no more tests
+	};
+
+	// margin: how far leaf boxes are grown on every side
+	explicit AABBTree(float margin = 0.25f);
+
+	// Adds a box, returns the proxy ID of its leaf.
+	int Insert(const glm::vec3& min, const glm::vec3& max, void* data);
+
+	// Removes a leaf. The proxy ID can be handed out again.
+	void Remove(int proxy);
+
+	// Updates the box of a leaf. Only touches the tree if the box left the grown box.
+	// Returns true if the leaf was reinserted.
+	bool Move(int proxy, const glm::vec3& min, const glm::vec3& max);
+
+	void* GetData(int proxy) const { return _nodes[proxy].data; }
+	const glm::vec3& GetMin(int proxy) const { return _nodes[proxy].min; }
+	const glm::vec3& GetMax(int proxy) const { return _nodes[proxy].max; }
+
+	// Returns true if proxy is a leaf in use.
+	bool IsLeaf(int proxy) const;
+
+	// Proxy IDs are in [0, GetCapacity()).
+	int GetCapacity() const { return (int)_nodes.size(); }
+
+	int GetLeafCount() const { return _leafCount; }
+
+	// Height of the tree, 0 for a single leaf.
+	int GetHeight() const { return _root == NULL_NODE ? 0 : _nodes[_root].height; }
+
+	// Calls visit(data) for every leaf that overlap(min, max) doesn't reject.
+	template<typename OverlapFunc, typename VisitFunc>
+	void Query(const OverlapFunc& overlap, const VisitFunc& visit) const
+	{
+		if (_root == NULL_NODE) return;
+
+		_stack.clear();
+		_stack.push_back(StackEntry{ _root, false });
+		while (!_stack.empty())
+		{
+			StackEntry entry = _stack.back();
+			_stack.pop_back();
+			const Node& node = _nodes[entry.node];
+
+			bool inside = entry.inside;
+			if (!inside)
+			{
+				Overlap result = overlap(node.min, node.max);
+				if (result == OUTSIDE) continue;
+				inside = (result == INSIDE);
+			}
+
+			if (node.IsLeaf())
+			{
+				visit(node.data);
+			}
+			else
+			{
+				_stack.push_back(StackEntry{ node.child1, inside });
+				_stack.push_back(StackEntry{ node.child2, inside });
+			}
+		}
+	}
+
+private:
+	struct Node
+	{
+		glm::vec3 min;
+		glm::vec3 max;
+		void* data;
+		int parent;		// next free node while on the free list
+		int child1;
+		int child2;
+		int height;		// -1 when free, 0 for leaves
+
+		bool IsLeaf() const { return child1 == NULL_NODE; }
+	};
+
+	struct StackEntry
+	{
+		int node;
+		bool inside;	// an ancestor was fully inside
+	};
+
+	int allocateNode();
+	void freeNode(int node);
+	void insertLeaf(int leaf);
+	void removeLeaf(int leaf);
+	int balance(int node);
+	void refit(int node);
+
+	std::vector<Node> _nodes;
+	int _root;
+	int _freeList;
+	int _leafCount;
+	float _margin;
+
+	mutable std::vector<StackEntry> _stack;	// query traversal, kept to reuse the memory
+};
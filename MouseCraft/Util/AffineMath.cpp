@@ -0,0 +1,296 @@
+#include "AffineMath.h"
+#include <cmath>
+
+#if defined(AFFINE_MATH_SSE)
+#include <xmmintrin.h>
+#elif defined(AFFINE_MATH_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace AffineMath
+{
+
+glm::mat4 Compose(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+{
+	// same as glm::mat3_cast with the scale folded into the columns
+	const float xx = rotation.x * rotation.x, yy = rotation.y * rotation.y, zz = rotation.z * rotation.z;
+	const float xz = rotation.x * rotation.z, xy = rotation.x * rotation.y, yz = rotation.y * rotation.z;
+	const float wx = rotation.w * rotation.x, wy = rotation.w * rotation.y, wz = rotation.w * rotation.z;
+
+	glm::mat4 out;
+	out[0] = glm::vec4((1.0f - 2.0f * (yy + zz)) * scale.x, 2.0f * (xy + wz) * scale.x, 2.0f * (xz - wy) * scale.x, 0.0f);
+	out[1] = glm::vec4(2.0f * (xy - wz) * scale.y, (1.0f - 2.0f * (xx + zz)) * scale.y, 2.0f * (yz + wx) * scale.y, 0.0f);
+	out[2] = glm::vec4(2.0f * (xz + wy) * scale.z, 2.0f * (yz - wx) * scale.z, (1.0f - 2.0f * (xx + yy)) * scale.z, 0.0f);
+	out[3] = glm::vec4(position, 1.0f);
+	return out;
+}
+
+#if defined(AFFINE_MATH_SSE)
+
+static inline __m128 cross(__m128 a, __m128 b)
+{
+	// w stays 0 because it's a.w * b.w - a.w * b.w
+	__m128 aYZX = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+	__m128 bYZX = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+	__m128 c = _mm_sub_ps(_mm_mul_ps(a, bYZX), _mm_mul_ps(aYZX, b));
+	return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+}
+
+static inline float dot3(__m128 a, __m128 b)
+{
+	__m128 m = _mm_mul_ps(a, b);
+	__m128 y = _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 1, 1, 1));
+	__m128 z = _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 2, 2, 2));
+	return _mm_cvtss_f32(_mm_add_ss(_mm_add_ss(m, y), z));
+}
+
+void Multiply(const glm::mat4& a, const glm::mat4& b, glm::mat4& out)
+{
+	const float* A = &a[0][0];
+	const float* B = &b[0][0];
+	float* O = &out[0][0];
+
+	const __m128 a0 = _mm_loadu_ps(A);
+	const __m128 a1 = _mm_loadu_ps(A + 4);
+	const __m128 a2 = _mm_loadu_ps(A + 8);
+	const __m128 a3 = _mm_loadu_ps(A + 12);
+
+	// b's w is 0 for the axes and 1 for the translation
+	for (int c = 0; c < 4; ++c)
+	{
+		const float* col = B + c * 4;
+		__m128 r = _mm_mul_ps(a0, _mm_set1_ps(col[0]));
+		r = _mm_add_ps(r, _mm_mul_ps(a1, _mm_set1_ps(col[1])));
+		r = _mm_add_ps(r, _mm_mul_ps(a2, _mm_set1_ps(col[2])));
+		if (c == 3)
+			r = _mm_add_ps(r, a3);
+		_mm_storeu_ps(O + c * 4, r);
+	}
+}
+
+glm::mat4 NormalMatrix(const glm::mat4& m)
+{
+	const float* M = &m[0][0];
+	const __m128 mask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+	const __m128 c0 = _mm_and_ps(_mm_loadu_ps(M), mask);
+	const __m128 c1 = _mm_and_ps(_mm_loadu_ps(M + 4), mask);
+	const __m128 c2 = _mm_and_ps(_mm_loadu_ps(M + 8), mask);
+
+	// inverse transpose of the 3x3 is the cofactor matrix over the determinant
+	const __m128 r0 = cross(c1, c2);
+	const __m128 r1 = cross(c2, c0);
+	const __m128 r2 = cross(c0, c1);
+	const __m128 invDet = _mm_set1_ps(1.0f / dot3(c0, r0));
+
+	glm::mat4 out;
+	float* O = &out[0][0];
+	_mm_storeu_ps(O, _mm_mul_ps(r0, invDet));
+	_mm_storeu_ps(O + 4, _mm_mul_ps(r1, invDet));
+	_mm_storeu_ps(O + 8, _mm_mul_ps(r2, invDet));
+	_mm_storeu_ps(O + 12, _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f));
+	return out;
+}
+
+// x, y and z of one column of 4 matrices, a lane per matrix
+struct Column4
+{
+	__m128 x, y, z;
+};
+
+static inline Column4 loadColumn4(const glm::mat4* m, int c)
+{
+	__m128 x = _mm_loadu_ps(&m[0][c][0]);
+	__m128 y = _mm_loadu_ps(&m[1][c][0]);
+	__m128 z = _mm_loadu_ps(&m[2][c][0]);
+	__m128 w = _mm_loadu_ps(&m[3][c][0]);
+	_MM_TRANSPOSE4_PS(x, y, z, w);
+	return Column4{ x, y, z };
+}
+
+static inline Column4 cross4(const Column4& a, const Column4& b)
+{
+	return Column4{
+		_mm_sub_ps(_mm_mul_ps(a.y, b.z), _mm_mul_ps(a.z, b.y)),
+		_mm_sub_ps(_mm_mul_ps(a.z, b.x), _mm_mul_ps(a.x, b.z)),
+		_mm_sub_ps(_mm_mul_ps(a.x, b.y), _mm_mul_ps(a.y, b.x)) };
+}
+
+static inline void storeColumn4(glm::mat4* m, int c, const Column4& v, __m128 scale)
+{
+	__m128 x = _mm_mul_ps(v.x, scale);
+	__m128 y = _mm_mul_ps(v.y, scale);
+	__m128 z = _mm_mul_ps(v.z, scale);
+	__m128 w = _mm_setzero_ps();
+	_MM_TRANSPOSE4_PS(x, y, z, w);
+	_mm_storeu_ps(&m[0][c][0], x);
+	_mm_storeu_ps(&m[1][c][0], y);
+	_mm_storeu_ps(&m[2][c][0], z);
+	_mm_storeu_ps(&m[3][c][0], w);
+}
+
+void NormalMatrices(const glm::mat4* in, glm::mat4* out, size_t count)
+{
+	// 4 at a time with a matrix per lane, so there are no shuffles or horizontal adds but the transposes
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 lastColumn = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		const Column4 c0 = loadColumn4(in + i, 0);
+		const Column4 c1 = loadColumn4(in + i, 1);
+		const Column4 c2 = loadColumn4(in + i, 2);
+
+		const Column4 r0 = cross4(c1, c2);
+		const Column4 r1 = cross4(c2, c0);
+		const Column4 r2 = cross4(c0, c1);
+		const __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0.x, r0.x), _mm_mul_ps(c0.y, r0.y)), _mm_mul_ps(c0.z, r0.z));
+		const __m128 invDet = _mm_div_ps(one, det);
+
+		storeColumn4(out + i, 0, r0, invDet);
+		storeColumn4(out + i, 1, r1, invDet);
+		storeColumn4(out + i, 2, r2, invDet);
+		for (int k = 0; k < 4; ++k)
+			_mm_storeu_ps(&out[i + k][3][0], lastColumn);
+	}
+	for (; i < count; ++i)
+		out[i] = NormalMatrix(in[i]);
+}
+
+glm::vec3 ExtractScale(const glm::mat4& m)
+{
+	const float* M = &m[0][0];
+	__m128 c0 = _mm_loadu_ps(M);
+	__m128 c1 = _mm_loadu_ps(M + 4);
+	__m128 c2 = _mm_loadu_ps(M + 8);
+	__m128 c3 = _mm_setzero_ps();
+	_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+	// lanes are now x, y, z axis
+	__m128 sq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, c0), _mm_mul_ps(c1, c1)), _mm_mul_ps(c2, c2));
+	float lengths[4];
+	_mm_storeu_ps(lengths, _mm_sqrt_ps(sq));
+	return glm::vec3(lengths[0], lengths[1], lengths[2]);
+}
+
+#elif defined(AFFINE_MATH_NEON)
+
+static inline float32x4_t cross(float32x4_t a, float32x4_t b)
+{
+	float32x4_t aYZX = { vgetq_lane_f32(a, 1), vgetq_lane_f32(a, 2), vgetq_lane_f32(a, 0), 0.0f };
+	float32x4_t bYZX = { vgetq_lane_f32(b, 1), vgetq_lane_f32(b, 2), vgetq_lane_f32(b, 0), 0.0f };
+	float32x4_t c = vmlsq_f32(vmulq_f32(a, bYZX), aYZX, b);
+	float32x4_t r = { vgetq_lane_f32(c, 1), vgetq_lane_f32(c, 2), vgetq_lane_f32(c, 0), 0.0f };
+	return r;
+}
+
+static inline float dot3(float32x4_t a, float32x4_t b)
+{
+	float32x4_t m = vmulq_f32(a, b);
+	return vgetq_lane_f32(m, 0) + vgetq_lane_f32(m, 1) + vgetq_lane_f32(m, 2);
+}
+
+void Multiply(const glm::mat4& a, const glm::mat4& b, glm::mat4& out)
+{
+	const float* A = &a[0][0];
+	const float* B = &b[0][0];
+	float* O = &out[0][0];
+
+	const float32x4_t a0 = vld1q_f32(A);
+	const float32x4_t a1 = vld1q_f32(A + 4);
+	const float32x4_t a2 = vld1q_f32(A + 8);
+	const float32x4_t a3 = vld1q_f32(A + 12);
+
+	for (int c = 0; c < 4; ++c)
+	{
+		const float* col = B + c * 4;
+		float32x4_t r = vmulq_n_f32(a0, col[0]);
+		r = vmlaq_n_f32(r, a1, col[1]);
+		r = vmlaq_n_f32(r, a2, col[2]);
+		if (c == 3)
+			r = vaddq_f32(r, a3);
+		vst1q_f32(O + c * 4, r);
+	}
+}
+
+glm::mat4 NormalMatrix(const glm::mat4& m)
+{
+	const float* M = &m[0][0];
+	const float32x4_t c0 = vsetq_lane_f32(0.0f, vld1q_f32(M), 3);
+	const float32x4_t c1 = vsetq_lane_f32(0.0f, vld1q_f32(M + 4), 3);
+	const float32x4_t c2 = vsetq_lane_f32(0.0f, vld1q_f32(M + 8), 3);
+
+	const float32x4_t r0 = cross(c1, c2);
+	const float32x4_t r1 = cross(c2, c0);
+	const float32x4_t r2 = cross(c0, c1);
+	const float invDet = 1.0f / dot3(c0, r0);
+
+	glm::mat4 out;
+	float* O = &out[0][0];
+	vst1q_f32(O, vmulq_n_f32(r0, invDet));
+	vst1q_f32(O + 4, vmulq_n_f32(r1, invDet));
+	vst1q_f32(O + 8, vmulq_n_f32(r2, invDet));
+	out[3] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	return out;
+}
+
+glm::vec3 ExtractScale(const glm::mat4& m)
+{
+	return glm::vec3(glm::length(glm::vec3(m[0])), glm::length(glm::vec3(m[1])), glm::length(glm::vec3(m[2])));
+}
+
+#else
+
+void Multiply(const glm::mat4& a, const glm::mat4& b, glm::mat4& out)
+{
+	const glm::vec4 a0 = a[0], a1 = a[1], a2 = a[2], a3 = a[3];
+	for (int c = 0; c < 4; ++c)
+	{
+		const glm::vec4 col = b[c];
+		glm::vec4 r = a0 * col.x + a1 * col.y + a2 * col.z;
+		if (c == 3)
+			r += a3;
+		out[c] = r;
+	}
+}
+
+glm::mat4 NormalMatrix(const glm::mat4& m)
+{
+	const glm::vec3 c0(m[0]), c1(m[1]), c2(m[2]);
+	const glm::vec3 r0 = glm::cross(c1, c2);
+	const float invDet = 1.0f / glm::dot(c0, r0);
+
+	glm::mat4 out;
+	out[0] = glm::vec4(r0 * invDet, 0.0f);
+	out[1] = glm::vec4(glm::cross(c2, c0) * invDet, 0.0f);
+	out[2] = glm::vec4(glm::cross(c0, c1) * invDet, 0.0f);
+	out[3] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	return out;
+}
+
+glm::vec3 ExtractScale(const glm::mat4& m)
+{
+	return glm::vec3(glm::length(glm::vec3(m[0])), glm::length(glm::vec3(m[1])), glm::length(glm::vec3(m[2])));
+}
+
+#endif
+
+#if !defined(AFFINE_MATH_SSE)
+void NormalMatrices(const glm::mat4* in, glm::mat4* out, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+		out[i] = NormalMatrix(in[i]);
+}
+#endif
+
+void TransformBounds(const glm::mat4& m, const glm::vec3& min, const glm::vec3& max, glm::vec3& outMin, glm::vec3& outMax)
+{
+	// transform the center, the extents only need the absolute axes (Arvo)
+	const glm::vec3 center = (min + max) * 0.5f;
+	const glm::vec3 extents = (max - min) * 0.5f;
+	const glm::vec3 newCenter = glm::vec3(m[0]) * center.x + glm::vec3(m[1]) * center.y + glm::vec3(m[2]) * center.z + glm::vec3(m[3]);
+	const glm::vec3 newExtents = glm::abs(glm::vec3(m[0])) * extents.x + glm::abs(glm::vec3(m[1])) * extents.y + glm::abs(glm::vec3(m[2])) * extents.z;
+	outMin = newCenter - newExtents;
+	outMax = newCenter + newExtents;
+}
+
+}
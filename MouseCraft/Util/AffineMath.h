@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define AFFINE_MATH_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define AFFINE_MATH_NEON
+#endif
+
+// Kernels for affine transformations (translation, rotation, scale - no projection).
+// Matrices are regular column-major glm::mat4s so they can be passed straight to OpenGL,
+// but the last row is assumed to be (0, 0, 0, 1) and never read. That makes them 3x4
+// operations: 12 multiplies for a concatenation instead of 16.
+// Uses SSE or NEON when available, scalar code otherwise.
+namespace AffineMath
+{
+	// Returns translate(position) * mat4(rotation) * scale(scale).
+	glm::mat4 Compose(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale);
+
+	// out = a * b. out can be a or b.
+	void Multiply(const glm::mat4& a, const glm::mat4& b, glm::mat4& out);
+
+	inline glm::mat4 Multiply(const glm::mat4& a, const glm::mat4& b)
+	{
+		glm::mat4 out;
+		Multiply(a, b, out);
+		return out;
+	}
+
+	// Returns transpose(inverse(m)) for transforming normals.
+	// Only the upper 3x3 is meaningful, the translation column is (0, 0, 0, 1).
+	glm::mat4 NormalMatrix(const glm::mat4& m);
+
+	// NormalMatrix for count matrices.
+	void NormalMatrices(const glm::mat4* in, glm::mat4* out, size_t count);
+
+	// Returns the length of the x, y and z axes.
+	glm::vec3 ExtractScale(const glm::mat4& m);
+
+	// Bounding box of the box [min, max] after transforming it by m.
+	void TransformBounds(const glm::mat4& m, const glm::vec3& min, const glm::vec3& max, glm::vec3& outMin, glm::vec3& outMax);
+}
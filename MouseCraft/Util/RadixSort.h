@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+// LSD radix sort on 64 bit keys, one byte per pass.
+// Stable, so items with equal keys keep the order they were added in.
+namespace RadixSort
+{
+	// Sorts count items by their uint64_t key member. scratch must hold count items.
+	// Passes where every key has the same byte are skipped, so keys that only use
+	// a few bits (or lists that are already grouped) cost fewer passes.
+	template<typename T>
+	void Sort(T* items, T* scratch, size_t count)
+	{
+		if (count < 2) return;
+
+		// all eight histograms in one read of the keys
+		size_t histograms[8][256] = {};
+		for (size_t i = 0; i < count; ++i)
+		{
+			uint64_t key = items[i].key;
+			for (int pass = 0; pass < 8; ++pass)
+				histograms[pass][(key >> (pass * 8)) & 0xFF]++;
+		}
+
+		T* from = items;
+		T* to = scratch;
+		for (int pass = 0; pass < 8; ++pass)
+		{
+			size_t* histogram = histograms[pass];
+			const int shift = pass * 8;
+
+			// every key lands in the same bucket, nothing to do for this byte
+			if (histogram[(from[0].key >> shift) & 0xFF] == count)
+				continue;
+
+			size_t offset = 0;
+			for (int b = 0; b < 256; ++b)
+			{
+				size_t n = histogram[b];
+				histogram[b] = offset;
+				offset += n;
+			}
+			for (size_t i = 0; i < count; ++i)
+				to[histogram[(from[i].key >> shift) & 0xFF]++] = from[i];
+			std::swap(from, to);
+		}
+
+		// odd number of passes leaves the result in scratch
+		if (from != items)
+		{
+			for (size_t i = 0; i < count; ++i)
+				items[i] = from[i];
+		}
+	}
+}
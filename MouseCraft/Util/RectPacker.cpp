@@ -0,0 +1,98 @@
+#include "RectPacker.h"
+#include <algorithm>
+
+RectPacker::RectPacker(int width, int height) :
+	_width(width), _height(height), _usedArea(0)
+{
+	Clear();
+}
+
+bool RectPacker::Insert(int width, int height, int& x, int& y)
+{
+	if (width <= 0 || height <= 0)
+		return false;
+
+	// lowest top wins, ties go to the narrowest segment to leave wide gaps for wide rectangles
+	size_t best = _skyline.size();
+	int bestTop = _height + 1;
+	int bestWidth = _width + 1;
+	for (size_t i = 0; i < _skyline.size(); ++i)
+	{
+		int top = fit(i, width, height);
+		if (top < 0)
+			continue;
+		top += height;
+		if (top < bestTop || (top == bestTop && _skyline[i].width < bestWidth))
+		{
+			best = i;
+			bestTop = top;
+			bestWidth = _skyline[i].width;
+		}
+	}
+	if (best == _skyline.size())
+		return false;
+
+	x = _skyline[best].x;
+	y = bestTop - height;
+
+	// the new rectangle's top replaces the skyline under it
+	Segment placed = { x, bestTop, width };
+	_skyline.insert(_skyline.begin() + best, placed);
+	for (size_t i = best + 1; i < _skyline.size();)
+	{
+		Segment& s = _skyline[i];
+		const int covered = placed.x + placed.width - s.x;
+		if (covered <= 0)
+			break;
+		if (covered < s.width)
+		{
+			s.x += covered;
+			s.width -= covered;
+			break;
+		}
+		_skyline.erase(_skyline.begin() + i);
+	}
+
+	// merge neighbours at the same height
+	for (size_t i = 1; i < _skyline.size();)
+	{
+		if (_skyline[i - 1].y == _skyline[i].y)
+		{
+			_skyline[i - 1].width += _skyline[i].width;
+			_skyline.erase(_skyline.begin() + i);
+		}
+		else
+		{
+			++i;
+		}
+	}
+
+	_usedArea += (long long)width * height;
+	return true;
+}
+
+void RectPacker::Clear()
+{
+	_skyline.clear();
+	_skyline.push_back(Segment{ 0, 0, _width });
+	_usedArea = 0;
+}
+
+int RectPacker::fit(size_t index, int width, int height) const
+{
+	const int x = _skyline[index].x;
+	if (x + width > _width)
+		return -1;
+
+	// the rectangle rests on the highest segment it spans
+	int y = 0;
+	int remaining = width;
+	for (size_t i = index; remaining > 0; ++i)
+	{
+		y = std::max(y, _skyline[i].y);
+		if (y + height > _height)
+			return -1;
+		remaining -= _skyline[i].width;
+	}
+	return y;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+// Packs rectangles into a fixed size area, for sharing one texture layer between many small images.
+// Keeps the skyline of the packed rectangles and puts each new one where its top ends up lowest
+// (bottom left rule). Space can't be freed one rectangle at a time, only all at once with Clear.
+class RectPacker
+{
+public:
+	RectPacker(int width, int height);
+
+	// Finds room for a width * height rectangle. Returns false if it doesn't fit anywhere.
+	bool Insert(int width, int height, int& x, int& y);
+
+	// Forgets every rectangle.
+	void Clear();
+
+	int GetWidth() const { return _width; }
+	int GetHeight() const { return _height; }
+
+	// Area of the rectangles packed since the last Clear.
+	long long GetUsedArea() const { return _usedArea; }
+
+	// Fraction of the area the packed rectangles cover.
+	float GetOccupancy() const { return (float)((double)_usedArea / ((double)_width * _height)); }
+private:
+	// a horizontal run of the skyline, everything below y is taken
+	struct Segment
+	{
+		int x;
+		int y;
+		int width;
+	};
+
+	// Lowest y a rectangle starting at segment index can sit at, -1 if it doesn't fit there.
+	int fit(size_t index, int width, int height) const;
+
+	int _width;
+	int _height;
+	long long _usedArea;
+	std::vector<Segment> _skyline;	// sorted by x, covers the whole width
+};
@@ -4,6 +4,7 @@
 #include <Windows.h>
 #include <iostream>
 #include "Core/OmegaEngine.h"
+#include "Core/TickManager.h"
 #include "Graphics/RenderSystem.h"
 #include "Input/InputSystem.h"
 #include "Loading/PrefabLoader.h"
@@ -13,6 +14,8 @@
 #include "ContraptionSystem.h"
 #include "MenuScene.h"
 #include "UI/UIManager.h"
+#include "TransformAnimator.h"
+#include "Rotator.h"
 
 SoundManager* noise;
 
@@ -34,6 +37,10 @@ void MainTest()
 
 	OmegaEngine::Instance().initialize();
 
+	// these only animate their own transform
+	TickManager::Instance().SetConcurrent<TransformAnimator>(true);
+	TickManager::Instance().SetConcurrent<Rotator>(true);
+
 	OmegaEngine::Instance().ChangeScene(new MenuScene());
 
 	InputSystem* inputSystem = new InputSystem();